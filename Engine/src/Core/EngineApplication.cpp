@@ -1,5 +1,6 @@
 #include "UltimateEnginePCH.h"
 #include "EngineApplication.h"
+#include "JobSystem.h"
 #include "../VulkanRenderer/VulkanApplication.h"
 #include "../World/Camera.h"
 #include "../EngineHeader.h"
@@ -39,6 +40,11 @@ bool EngineApplication::Initialize(const std::string& name, uint16_t width, uint
 	glfwSetMouseButtonCallback(m_pGLFWWindow, MouseButtonCallback);
 	glfwSetScrollCallback(m_pGLFWWindow, MouseScrollCallback);
 
+	// Main thread keeps GLFW & Vulkan queues to itself, every other core is a worker
+	const uint32_t coreCount = std::thread::hardware_concurrency();
+	const uint32_t workerCount = (coreCount > 1) ? coreCount - 1 : 1;
+	CHECK(JobSystem::getInstance().Initialize(workerCount));
+
 	m_pVulkanApp = new VulkanApplication();
 	m_bAppInitialized = m_pVulkanApp->Initialize(m_pGLFWWindow);
 
@@ -54,11 +60,16 @@ void EngineApplication::Run() const
 	{
 		glfwPollEvents();
 
+		// Whatever workers asked main thread to do since last frame
+		JobSystem::getInstance().PumpMainThreadJobs();
+
 		static double lastTime = 0.0f;
 		const double now = glfwGetTime();
 		const double dt = now - lastTime;
 		lastTime = now;
 
+		// Update kicks off next frame's simulation on a worker, Render records & submits this one meanwhile & waits for
+		// it at the end. Frame costs max(update, render) instead of both!
 		m_pVulkanApp->Update(dt);
 		m_pVulkanApp->Render();
 	}
@@ -68,6 +79,7 @@ void EngineApplication::Run() const
 void EngineApplication::Cleanup()
 {
 	m_pVulkanApp->Cleanup();
+	JobSystem::getInstance().Cleanup();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,478 @@
+#include "UltimateEnginePCH.h"
+#include "JobSystem.h"
+#include "../EngineHeader.h"
+
+// Index of the calling thread into queues, foreign threads (not ours, not main) only ever steal
+static thread_local uint32_t s_uiThreadIndex = UINT32_MAX;
+
+//---------------------------------------------------------------------------------------------------------------------
+JobSystem::JobSystem()
+{
+	m_uiQueuedJobs = 0;
+	m_uiWaitEpoch = 0;
+	m_bStopping = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+JobSystem::~JobSystem()
+{
+	Cleanup();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::Initialize(uint32_t workerCount)
+{
+	CHECK_LOG(workerCount > 0, "Job system needs at least one worker!");
+
+	m_bStopping = false;
+	m_MainThreadId = std::this_thread::get_id();
+	s_uiThreadIndex = 0;
+
+	// Main thread's deque first, then one per worker
+	for (uint32_t i = 0; i <= workerCount; ++i)
+	{
+		m_ListQueues.push_back(new WorkQueue());
+	}
+
+	for (uint32_t i = 1; i <= workerCount; ++i)
+	{
+		m_ListWorkers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	LOG_DEBUG("Job system started with {0} workers", workerCount);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::Cleanup()
+{
+	if (m_ListWorkers.empty())
+		return;
+
+	// Workers drain whatever is still queued before they exit!
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_bStopping = true;
+	}
+
+	m_cvJobAvailable.notify_all();
+
+	for (std::thread& worker : m_ListWorkers)
+	{
+		worker.join();
+	}
+
+	m_ListWorkers.clear();
+
+	// Nobody left to run them but us
+	PumpMainThreadJobs();
+
+	for (WorkQueue* pQueue : m_ListQueues)
+	{
+		SAFE_DELETE(pQueue);
+	}
+
+	m_ListQueues.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::Run(const std::function<void()>& job, JobCounter* pCounter, JobCounter* pDependency)
+{
+	if (pCounter)
+		++pCounter->uiValue;
+
+	// Dependency still running, job gets queued by whoever finishes its last job
+	if (pDependency)
+	{
+		std::lock_guard<std::mutex> lock(pDependency->Mutex);
+		if (!pDependency->IsDone())
+		{
+			pDependency->ListDependentJobs.emplace_back(job, pCounter);
+			return;
+		}
+	}
+
+	Job newJob;
+	newJob.func = job;
+	newJob.pCounter = pCounter;
+
+	Push(s_uiThreadIndex < m_ListQueues.size() ? s_uiThreadIndex : 0, newJob);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::RunOnMainThread(const std::function<void()>& job, JobCounter* pCounter)
+{
+	if (pCounter)
+		++pCounter->uiValue;
+
+	Job newJob;
+	newJob.func = job;
+	newJob.pCounter = pCounter;
+
+	// Not counted in m_uiQueuedJobs, no worker may wake up for these. Main thread might be asleep in Wait() though!
+	{
+		std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+		m_MainThreadQueue.QueueJobs.push_back(newJob);
+	}
+
+	NotifyWaiters();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::RunBackground(const std::function<void()>& job, JobCounter* pCounter)
+{
+	if (pCounter)
+		++pCounter->uiValue;
+
+	Job newJob;
+	newJob.func = job;
+	newJob.pCounter = pCounter;
+
+	{
+		std::lock_guard<std::mutex> lock(m_BackgroundQueue.Mutex);
+		m_BackgroundQueue.QueueJobs.push_back(newJob);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		++m_uiQueuedJobs;
+	}
+
+	m_cvJobAvailable.notify_one();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::RunHighPriority(const std::function<void()>& job, JobCounter* pCounter)
+{
+	if (pCounter)
+		++pCounter->uiValue;
+
+	Job newJob;
+	newJob.func = job;
+	newJob.pCounter = pCounter;
+
+	{
+		std::lock_guard<std::mutex> lock(m_HighPriorityQueue.Mutex);
+		m_HighPriorityQueue.QueueJobs.push_back(newJob);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		++m_uiQueuedJobs;
+	}
+
+	m_cvJobAvailable.notify_one();
+
+	// Whoever waits on it may take it back
+	NotifyWaiters();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::Wait(JobCounter* pCounter)
+{
+	if (!pCounter)
+		return;
+
+	const bool bMainThread = IsMainThread();
+
+	while (!pCounter->IsDone())
+	{
+		// Anything happening after this is read wakes us up below, so nothing queued in between gets missed
+		const uint32_t waitEpoch = m_uiWaitEpoch.load();
+
+		// Main thread might be the only one able to finish what we wait on
+		if (bMainThread)
+		{
+			Job mainThreadJob;
+			bool bHasMainThreadJob = false;
+
+			{
+				std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+				if (!m_MainThreadQueue.QueueJobs.empty())
+				{
+					mainThreadJob = m_MainThreadQueue.QueueJobs.front();
+					m_MainThreadQueue.QueueJobs.pop_front();
+					bHasMainThreadJob = true;
+				}
+			}
+
+			if (bHasMainThreadJob)
+			{
+				mainThreadJob.func();
+				Finish(mainThreadJob.pCounter);
+				continue;
+			}
+		}
+
+		// High priority job we wait on might still be queued with every worker stuck in a background job, take it back.
+		// Only ours though, main thread mustn't end up running somebody else's simulation halfway through a frame!
+		Job ownJob;
+		if (TryPopQueueFor(&m_HighPriorityQueue, pCounter, &ownJob))
+		{
+			--m_uiQueuedJobs;
+
+			ownJob.func();
+			Finish(ownJob.pCounter);
+			continue;
+		}
+
+		// Never pick up background jobs here, whoever waits on us would sit behind a whole asset decode!
+		if (TryRunOne(s_uiThreadIndex, false))
+			continue;
+
+		// Nothing we may run, sleep till something gets queued or a counter drops to zero
+		std::unique_lock<std::mutex> lock(m_WaitMutex);
+		m_cvWaitProgress.wait(lock, [this, pCounter, waitEpoch]() { return pCounter->IsDone() || m_uiWaitEpoch.load() != waitEpoch; });
+	}
+
+	// Last job's thread might still be inside counter's mutex, counter can't go away before it leaves!
+	std::lock_guard<std::mutex> lock(pCounter->Mutex);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::PumpMainThreadJobs()
+{
+	UT_ASSERT_BOOL((IsMainThread()), "Main thread jobs pumped from another thread!");
+
+	std::deque<Job> queueJobs;
+
+	{
+		std::lock_guard<std::mutex> lock(m_MainThreadQueue.Mutex);
+		queueJobs.swap(m_MainThreadQueue.QueueJobs);
+	}
+
+	for (const Job& job : queueJobs)
+	{
+		job.func();
+		Finish(job.pCounter);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	// A batch per thread, stealing evens out the rest. Tiny ranges aren't worth handing over at all!
+	const uint32_t threadBatchSize = (count + GetThreadCount() - 1) / GetThreadCount();
+	const uint32_t batchSize = std::max(std::max(minBatchSize, threadBatchSize), 1u);
+
+	if (batchSize >= count)
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (uint32_t first = batchSize; first < count; first += batchSize)
+	{
+		const uint32_t last = std::min(first + batchSize, count);
+		Run([&func, first, last]() { func(first, last); }, &counter);
+	}
+
+	// First batch is ours
+	func(0, batchSize);
+
+	Wait(&counter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t JobSystem::GetThreadIndex() const
+{
+	return s_uiThreadIndex;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::IsMainThread() const
+{
+	return std::this_thread::get_id() == m_MainThreadId;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::WorkerLoop(uint32_t threadIndex)
+{
+	s_uiThreadIndex = threadIndex;
+
+	while (true)
+	{
+		if (TryRunOne(threadIndex, true))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_cvJobAvailable.wait(lock, [this]() { return m_bStopping || m_uiQueuedJobs.load() > 0; });
+
+		if (m_bStopping && m_uiQueuedJobs.load() == 0)
+			return;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::Push(uint32_t queueIndex, const Job& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_ListQueues[queueIndex]->Mutex);
+		m_ListQueues[queueIndex]->QueueJobs.push_back(job);
+	}
+
+	// Sleep mutex makes sure a worker about to sleep sees the new count, otherwise wake up could get lost
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		++m_uiQueuedJobs;
+	}
+
+	m_cvJobAvailable.notify_one();
+
+	// Anybody waiting may steal it
+	NotifyWaiters();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::NotifyWaiters()
+{
+	// Bumped under wait mutex, so a waiter about to sleep either sees the new epoch or gets woken up
+	{
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		++m_uiWaitEpoch;
+	}
+
+	m_cvWaitProgress.notify_all();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::TryRunOne(uint32_t threadIndex, bool bAllowBackground)
+{
+	Job job;
+
+	// High priority jobs first & background jobs last, only from a worker's own loop. Main thread never runs either!
+	const bool bWorker = (threadIndex > 0 && threadIndex < m_ListQueues.size());
+	const bool bBackground = bWorker && bAllowBackground;
+
+	if (!(bWorker && TryPopQueue(&m_HighPriorityQueue, &job)) &&
+		!TryPop(threadIndex, &job) &&
+		!TrySteal(threadIndex, &job) &&
+		!(bBackground && TryPopQueue(&m_BackgroundQueue, &job)))
+		return false;
+
+	--m_uiQueuedJobs;
+
+	job.func();
+	Finish(job.pCounter);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::TryPop(uint32_t threadIndex, Job* pOutJob)
+{
+	if (threadIndex >= m_ListQueues.size())
+		return false;
+
+	// Newest first from our own deque
+	WorkQueue* pQueue = m_ListQueues[threadIndex];
+
+	std::lock_guard<std::mutex> lock(pQueue->Mutex);
+	if (pQueue->QueueJobs.empty())
+		return false;
+
+	*pOutJob = std::move(pQueue->QueueJobs.back());
+	pQueue->QueueJobs.pop_back();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::TrySteal(uint32_t threadIndex, Job* pOutJob)
+{
+	// Oldest first from everybody else's, starting with our neighbour so thieves don't all pick on thread 0
+	const uint32_t queueCount = static_cast<uint32_t>(m_ListQueues.size());
+	const uint32_t firstVictim = (threadIndex < queueCount) ? threadIndex + 1 : 0;
+
+	for (uint32_t i = 0; i < queueCount; ++i)
+	{
+		const uint32_t victim = (firstVictim + i) % queueCount;
+		if (victim == threadIndex)
+			continue;
+
+		WorkQueue* pQueue = m_ListQueues[victim];
+
+		std::lock_guard<std::mutex> lock(pQueue->Mutex);
+		if (pQueue->QueueJobs.empty())
+			continue;
+
+		*pOutJob = std::move(pQueue->QueueJobs.front());
+		pQueue->QueueJobs.pop_front();
+
+		return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::TryPopQueue(WorkQueue* pQueue, Job* pOutJob)
+{
+	// Shared queues are FIFO
+	std::lock_guard<std::mutex> lock(pQueue->Mutex);
+	if (pQueue->QueueJobs.empty())
+		return false;
+
+	*pOutJob = std::move(pQueue->QueueJobs.front());
+	pQueue->QueueJobs.pop_front();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool JobSystem::TryPopQueueFor(WorkQueue* pQueue, const JobCounter* pCounter, Job* pOutJob)
+{
+	// Oldest job signalling given counter
+	std::lock_guard<std::mutex> lock(pQueue->Mutex);
+	for (std::deque<Job>::iterator iter = pQueue->QueueJobs.begin(); iter != pQueue->QueueJobs.end(); ++iter)
+	{
+		if (iter->pCounter != pCounter)
+			continue;
+
+		*pOutJob = std::move(*iter);
+		pQueue->QueueJobs.erase(iter);
+
+		return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void JobSystem::Finish(JobCounter* pCounter)
+{
+	if (!pCounter)
+		return;
+
+	std::vector<std::pair<std::function<void()>, JobCounter*>> listReleasedJobs;
+
+	bool bDone = false;
+
+	// Decrement under counter's mutex, a dependent job is either queued by us or sees the counter already at zero
+	{
+		std::lock_guard<std::mutex> lock(pCounter->Mutex);
+		if (--pCounter->uiValue == 0)
+		{
+			listReleasedJobs.swap(pCounter->ListDependentJobs);
+			bDone = true;
+		}
+	}
+
+	if (bDone)
+		NotifyWaiters();
+
+	for (const std::pair<std::function<void()>, JobCounter*>& releasedJob : listReleasedJobs)
+	{
+		Job job;
+		job.func = releasedJob.first;
+		job.pCounter = releasedJob.second;
+
+		Push(s_uiThreadIndex < m_ListQueues.size() ? s_uiThreadIndex : 0, job);
+	}
+}
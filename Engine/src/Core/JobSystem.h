@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Core.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Counts jobs which haven't finished yet. Every job run with it increments it & decrements it once done, jobs can
+// depend on it & only get queued once it drops to zero. Must outlive every job signalling it!
+struct UT_API JobCounter
+{
+	JobCounter() : uiValue(0) {}
+
+	inline bool							IsDone() const					{ return uiValue.load() == 0; }
+
+	std::atomic<uint32_t>				uiValue;
+
+	// jobs waiting for us to reach zero, JobSystem moves them to a queue when we get there
+	std::mutex							Mutex;
+	std::vector<std::pair<std::function<void()>, JobCounter*>>	ListDependentJobs;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Work stealing scheduler, one per engine. Main thread is thread 0 & every worker has an index of its own, each with a
+// deque : owner pushes & pops at the back (newest first, its data is still in cache), idle threads steal from the front
+// of somebody else's. Nobody sleeps while there's something to steal!
+//
+// Waiting on a counter keeps the thread running jobs till counter hits zero & only sleeps once there's nothing it may
+// run. Jobs which must run on
+// main thread (GLFW, Vulkan queues, ImGui) go through RunOnMainThread() & are only picked up by main thread, in Wait()
+// or in PumpMainThreadJobs() once a frame. Long jobs (asset decode) go through RunBackground(), workers pick them up
+// only from their own loop when there's nothing else. Main thread never does & neither does anybody inside Wait(), so a
+// ParallelFor never ends up waiting on a decode somebody grabbed halfway through it.
+// Frame critical work (simulation) goes through RunHighPriority(), workers pick those up before anything else. If they
+// are all busy, whoever waits on the job's counter takes it back.
+class UT_API JobSystem
+{
+public:
+	static JobSystem& getInstance()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	bool								Initialize(uint32_t workerCount);
+	void								Cleanup();
+
+	void								Run(const std::function<void()>& job, JobCounter* pCounter = nullptr, JobCounter* pDependency = nullptr);
+	void								RunOnMainThread(const std::function<void()>& job, JobCounter* pCounter = nullptr);
+	void								RunBackground(const std::function<void()>& job, JobCounter* pCounter = nullptr);
+	void								RunHighPriority(const std::function<void()>& job, JobCounter* pCounter = nullptr);
+	void								Wait(JobCounter* pCounter);
+	void								PumpMainThreadJobs();
+
+	// Splits [0, count) in batches of at least minBatchSize, func(first, last) runs once per batch on any thread &
+	// calling thread helps out till every batch is done
+	void								ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+	inline uint32_t						GetWorkerCount() const			{ return static_cast<uint32_t>(m_ListWorkers.size()); }
+	inline uint32_t						GetThreadCount() const			{ return GetWorkerCount() + 1; }
+	uint32_t							GetThreadIndex() const;
+	bool								IsMainThread() const;
+
+private:
+	JobSystem();
+	JobSystem(const JobSystem&);
+	~JobSystem();
+
+	struct Job
+	{
+		std::function<void()>			func;
+		JobCounter*						pCounter;
+	};
+
+	// deque per thread, mutex only ever fought over by its owner & a thief
+	struct WorkQueue
+	{
+		std::mutex						Mutex;
+		std::deque<Job>					QueueJobs;
+	};
+
+	void								WorkerLoop(uint32_t threadIndex);
+	void								Push(uint32_t queueIndex, const Job& job);
+	bool								TryRunOne(uint32_t threadIndex, bool bAllowBackground);
+	bool								TryPop(uint32_t threadIndex, Job* pOutJob);
+	bool								TrySteal(uint32_t threadIndex, Job* pOutJob);
+	bool								TryPopQueue(WorkQueue* pQueue, Job* pOutJob);
+	bool								TryPopQueueFor(WorkQueue* pQueue, const JobCounter* pCounter, Job* pOutJob);
+	void								NotifyWaiters();
+	void								Finish(JobCounter* pCounter);
+
+private:
+	std::vector<std::thread>			m_ListWorkers;
+	std::vector<WorkQueue*>				m_ListQueues;					// thread index -> its deque, 0 is main thread's
+	WorkQueue							m_MainThreadQueue;				// only ever run by main thread
+	WorkQueue							m_BackgroundQueue;				// only ever run by workers, FIFO
+	WorkQueue							m_HighPriorityQueue;			// run by workers before everything else, or by whoever waits on them
+	std::thread::id						m_MainThreadId;
+
+	// sleeping workers wake up once something is pushed
+	std::mutex							m_SleepMutex;
+	std::condition_variable				m_cvJobAvailable;
+	std::atomic<uint32_t>				m_uiQueuedJobs;
+	std::atomic<bool>					m_bStopping;
+
+	// threads in Wait() with nothing to run sleep till a job is queued or a counter drops to zero
+	std::mutex							m_WaitMutex;
+	std::condition_variable				m_cvWaitProgress;
+	std::atomic<uint32_t>				m_uiWaitEpoch;
+};
@@ -0,0 +1,82 @@
+#include "UltimateEnginePCH.h"
+#include "MappedFile.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile()
+{
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pData = nullptr;
+	m_uiSize = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	// Sequential scan hint lets OS read ahead aggressively, we touch every page exactly once
+	m_hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+						  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_hMapping)
+	{
+		LOG_ERROR("Failed to create file mapping for {0}", filePath);
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		LOG_ERROR("Failed to map view of {0}", filePath);
+		Close();
+		return false;
+	}
+
+	m_uiSize = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+
+	if (m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	m_uiSize = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Read only view of a whole file mapped into address space. OS pages it in on first touch, so parsing headers & then
+// memcpy-ing straight out of it never goes through an intermediate heap copy. Unmapped on Close() or destruction!
+class UT_API MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool								Open(const std::string& filePath);
+	void								Close();
+
+	inline const uint8_t*				GetData() const					{ return m_pData; }
+	inline size_t						GetSize() const					{ return m_uiSize; }
+	inline bool							IsOpen() const					{ return m_pData != nullptr; }
+
+private:
+	HANDLE								m_hFile;
+	HANDLE								m_hMapping;
+	const uint8_t*						m_pData;
+	size_t								m_uiSize;
+};
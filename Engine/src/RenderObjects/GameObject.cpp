@@ -13,3 +13,21 @@ void GameObject::Cleanup(void* pDevice)
 {
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+bool GameObject::LoadAssets(const void* pDevice)
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool GameObject::FinalizeAssets(const void* pDevice)
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool GameObject::IsReady(const void* pDevice) const
+{
+	return true;
+}
+
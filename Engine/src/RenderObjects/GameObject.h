@@ -21,6 +21,11 @@ public:
 	virtual bool		Initialize(const void*) override;
 	virtual void		Cleanup(void*) override;
 
+	// Asynchronous loading, see AssetLoader. LoadAssets() runs on a worker thread, FinalizeAssets() on main thread.
+	virtual bool		LoadAssets(const void*);
+	virtual bool		FinalizeAssets(const void*);
+	virtual bool		IsReady(const void*) const;
+
 	inline void			SetPosition(const glm::vec3& _pos)		{ m_vecPosition = _pos; }
 	inline void			SetRotationAxis(const glm::vec3& _axis)	{ m_vecRotationAxis = _axis; }
 	inline void			SetRotationAngle(float _angle)			{ m_fRotation = _angle; }
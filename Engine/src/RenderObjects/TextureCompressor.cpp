@@ -0,0 +1,359 @@
+#include "UltimateEnginePCH.h"
+#include "TextureCompressor.h"
+
+#include <cfloat>
+
+//---------------------------------------------------------------------------------------------------------------------
+static uint16_t PackRGB565(const float* pColor)
+{
+	const uint32_t r = static_cast<uint32_t>(std::clamp(pColor[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = static_cast<uint32_t>(std::clamp(pColor[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = static_cast<uint32_t>(std::clamp(pColor[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static void UnpackRGB565(uint16_t packed, int32_t* pOutColor)
+{
+	const int32_t r = (packed >> 11) & 31;
+	const int32_t g = (packed >> 5) & 63;
+	const int32_t b = packed & 31;
+
+	pOutColor[0] = (r << 3) | (r >> 2);
+	pOutColor[1] = (g << 2) | (g >> 4);
+	pOutColor[2] = (b << 3) | (b >> 2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureCompressor::IsBlockCompressed(vk::Format format)
+{
+	uint32_t blockDim = 1;
+	UT::VkUtility::GetFormatBlockSize(format, &blockDim);
+
+	return blockDim > 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureCompressor::CanEncode(vk::Format format)
+{
+	switch (format)
+	{
+		case vk::Format::eBc1RgbUnormBlock:
+		case vk::Format::eBc1RgbSrgbBlock:
+		case vk::Format::eBc1RgbaUnormBlock:
+		case vk::Format::eBc1RgbaSrgbBlock:
+		case vk::Format::eBc3UnormBlock:
+		case vk::Format::eBc3SrgbBlock:
+		case vk::Format::eBc4UnormBlock:
+		case vk::Format::eBc5UnormBlock:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+std::string TextureCompressor::GetCachePath(const std::string& sourcePath, vk::Format format)
+{
+	std::string suffix;
+
+	switch (format)
+	{
+		case vk::Format::eBc1RgbUnormBlock:		suffix = ".bc1.dds";			break;
+		case vk::Format::eBc1RgbSrgbBlock:		suffix = ".bc1_srgb.dds";		break;
+		case vk::Format::eBc1RgbaUnormBlock:	suffix = ".bc1a.dds";			break;
+		case vk::Format::eBc1RgbaSrgbBlock:		suffix = ".bc1a_srgb.dds";		break;
+		case vk::Format::eBc3UnormBlock:		suffix = ".bc3.dds";			break;
+		case vk::Format::eBc3SrgbBlock:			suffix = ".bc3_srgb.dds";		break;
+		case vk::Format::eBc4UnormBlock:		suffix = ".bc4.dds";			break;
+		case vk::Format::eBc5UnormBlock:		suffix = ".bc5.dds";			break;
+		default:								suffix = ".dds";				break;
+	}
+
+	// Assets/Textures/Foo.png -> Assets/Textures/Foo.bc3_srgb.dds
+	std::filesystem::path cachePath(sourcePath);
+	cachePath.replace_extension(suffix);
+
+	return cachePath.string();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureCompressor::CompressMipChain(const uint8_t* pRGBAChain, uint32_t width, uint32_t height, uint32_t mipLevels,
+										 vk::Format format, std::vector<uint8_t>* pOutBlocks)
+{
+	if (!CanEncode(format))
+	{
+		LOG_ERROR("Texture compressor has no encoder for format {0}!", vk::to_string(format));
+		return false;
+	}
+
+	vk::DeviceSize chainSize = 0;
+	for (uint32_t mip = 0; mip < mipLevels; ++mip)
+	{
+		chainSize += UT::VkUtility::GetImageLevelSize(format, width, height, mip);
+	}
+
+	pOutBlocks->resize(static_cast<size_t>(chainSize));
+
+	const uint8_t* pSrc = pRGBAChain;
+	uint8_t* pDst = pOutBlocks->data();
+
+	for (uint32_t mip = 0; mip < mipLevels; ++mip)
+	{
+		const uint32_t mipWidth = std::max(width >> mip, 1u);
+		const uint32_t mipHeight = std::max(height >> mip, 1u);
+
+		CompressLevel(pSrc, mipWidth, mipHeight, format, pDst);
+
+		pSrc += static_cast<size_t>(mipWidth) * mipHeight * 4;
+		pDst += UT::VkUtility::GetImageLevelSize(format, width, height, mip);
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureCompressor::CompressLevel(const uint8_t* pRGBA, uint32_t width, uint32_t height, vk::Format format, uint8_t* pOutBlocks)
+{
+	uint32_t blockDim = 1;
+	const uint32_t blockSize = UT::VkUtility::GetFormatBlockSize(format, &blockDim);
+
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+
+	std::array<uint8_t, 64> blockTexels = {};
+
+	for (uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			// Gather 4x4 texels, levels smaller than a block repeat their edge texels
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					const uint32_t srcX = std::min(bx * 4 + x, width - 1);
+					const uint32_t srcY = std::min(by * 4 + y, height - 1);
+
+					memcpy(&blockTexels[(y * 4 + x) * 4], pRGBA + (static_cast<size_t>(srcY) * width + srcX) * 4, 4);
+				}
+			}
+
+			uint8_t* pBlock = pOutBlocks + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+
+			switch (format)
+			{
+				case vk::Format::eBc1RgbUnormBlock:
+				case vk::Format::eBc1RgbSrgbBlock:
+					EncodeBlockBC1(blockTexels.data(), false, pBlock);
+					break;
+
+				case vk::Format::eBc1RgbaUnormBlock:
+				case vk::Format::eBc1RgbaSrgbBlock:
+					EncodeBlockBC1(blockTexels.data(), true, pBlock);
+					break;
+
+				case vk::Format::eBc3UnormBlock:
+				case vk::Format::eBc3SrgbBlock:
+					EncodeBlockBC4(blockTexels.data(), 3, pBlock);
+					EncodeBlockBC1(blockTexels.data(), false, pBlock + 8);
+					break;
+
+				case vk::Format::eBc4UnormBlock:
+					EncodeBlockBC4(blockTexels.data(), 0, pBlock);
+					break;
+
+				case vk::Format::eBc5UnormBlock:
+					EncodeBlockBC4(blockTexels.data(), 0, pBlock);
+					EncodeBlockBC4(blockTexels.data(), 1, pBlock + 8);
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureCompressor::EncodeBlockBC1(const uint8_t* pBlockRGBA, bool bAlphaCutout, uint8_t* pOut)
+{
+	// Texels with alpha below half go transparent, only possible in 3 colour mode
+	bool bHasTransparent = false;
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		bHasTransparent |= bAlphaCutout && (pBlockRGBA[i * 4 + 3] < 128);
+
+		for (uint32_t c = 0; c < 3; ++c)
+			mean[c] += pBlockRGBA[i * 4 + c] / 16.0f;
+	}
+
+	// Covariance of block colours...
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const float r = pBlockRGBA[i * 4 + 0] - mean[0];
+		const float g = pBlockRGBA[i * 4 + 1] - mean[1];
+		const float b = pBlockRGBA[i * 4 + 2] - mean[2];
+
+		cov[0] += r * r;	cov[1] += r * g;	cov[2] += r * b;
+		cov[3] += g * g;	cov[4] += g * b;	cov[5] += b * b;
+	}
+
+	// ...& its principal axis, few power iterations are plenty for a 3x3 matrix
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (uint32_t iter = 0; iter < 4; ++iter)
+	{
+		const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+		const float length = std::sqrt(x * x + y * y + z * z);
+		if (length < 1e-6f)
+			break;
+
+		axis[0] = x / length;	axis[1] = y / length;	axis[2] = z / length;
+	}
+
+	// Endpoints are the extremes of colours projected on the axis
+	float minProj = FLT_MAX;
+	float maxProj = -FLT_MAX;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const float proj = (pBlockRGBA[i * 4 + 0] - mean[0]) * axis[0] +
+						   (pBlockRGBA[i * 4 + 1] - mean[1]) * axis[1] +
+						   (pBlockRGBA[i * 4 + 2] - mean[2]) * axis[2];
+
+		minProj = std::min(minProj, proj);
+		maxProj = std::max(maxProj, proj);
+	}
+
+	float endpoint0[3], endpoint1[3];
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		endpoint0[c] = mean[c] + axis[c] * maxProj;
+		endpoint1[c] = mean[c] + axis[c] * minProj;
+	}
+
+	uint16_t color0 = PackRGB565(endpoint0);
+	uint16_t color1 = PackRGB565(endpoint1);
+
+	// color0 > color1 selects 4 colour mode, color0 <= color1 selects 3 colour + transparent mode
+	if ((!bHasTransparent && color0 < color1) || (bHasTransparent && color0 > color1))
+		std::swap(color0, color1);
+
+	int32_t palette[4][3];
+	UnpackRGB565(color0, palette[0]);
+	UnpackRGB565(color1, palette[1]);
+
+	const bool bFourColors = color0 > color1;
+	const uint32_t paletteSize = bFourColors ? 4 : 3;
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		if (bFourColors)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	uint32_t indices = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		uint32_t bestIndex = 0;
+
+		if (bHasTransparent && pBlockRGBA[i * 4 + 3] < 128)
+		{
+			bestIndex = 3;
+		}
+		else
+		{
+			int32_t bestError = INT32_MAX;
+			for (uint32_t p = 0; p < paletteSize; ++p)
+			{
+				const int32_t dr = pBlockRGBA[i * 4 + 0] - palette[p][0];
+				const int32_t dg = pBlockRGBA[i * 4 + 1] - palette[p][1];
+				const int32_t db = pBlockRGBA[i * 4 + 2] - palette[p][2];
+				const int32_t error = dr * dr + dg * dg + db * db;
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+		}
+
+		indices |= bestIndex << (i * 2);
+	}
+
+	pOut[0] = static_cast<uint8_t>(color0 & 0xFF);
+	pOut[1] = static_cast<uint8_t>(color0 >> 8);
+	pOut[2] = static_cast<uint8_t>(color1 & 0xFF);
+	pOut[3] = static_cast<uint8_t>(color1 >> 8);
+	memcpy(pOut + 4, &indices, 4);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureCompressor::EncodeBlockBC4(const uint8_t* pBlockRGBA, uint32_t channel, uint8_t* pOut)
+{
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		minValue = std::min(minValue, pBlockRGBA[i * 4 + channel]);
+		maxValue = std::max(maxValue, pBlockRGBA[i * 4 + channel]);
+	}
+
+	// endpoint0 > endpoint1 selects 8 value mode : both endpoints + 6 interpolated values in between
+	int32_t palette[8];
+	palette[0] = maxValue;
+	palette[1] = minValue;
+
+	for (int32_t i = 1; i < 7; ++i)
+	{
+		palette[i + 1] = ((7 - i) * palette[0] + i * palette[1] + 3) / 7;
+	}
+
+	uint64_t indices = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t value = pBlockRGBA[i * 4 + channel];
+
+		uint64_t bestIndex = 0;
+		int32_t bestError = INT32_MAX;
+
+		// Flat block : endpoints are equal, every texel is endpoint0
+		const uint32_t paletteSize = (maxValue > minValue) ? 8 : 1;
+		for (uint32_t p = 0; p < paletteSize; ++p)
+		{
+			const int32_t error = std::abs(value - palette[p]);
+			if (error < bestError)
+			{
+				bestError = error;
+				bestIndex = p;
+			}
+		}
+
+		indices |= bestIndex << (i * 3);
+	}
+
+	pOut[0] = maxValue;
+	pOut[1] = minValue;
+
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		pOut[2 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xFF);
+	}
+}
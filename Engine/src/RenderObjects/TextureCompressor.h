@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../VulkanRenderer/VulkanGlobals.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// CPU block compressor used by the asset pipeline. Takes RGBA8 texels (whole mip chain, tightly packed) & produces
+// GPU ready blocks :
+//	BC1 - RGB (+1 bit alpha), 4 bpp			BC4 - single channel (R), 4 bpp
+//	BC3 - RGB + smooth alpha, 8 bpp			BC5 - two channels (RG), 8 bpp
+//
+// Endpoints are fit along colour's principal axis, indices picked by nearest palette entry. It's not a production
+// quality encoder, but it's fast enough to run on first load & results are cached on disk (see GetCachePath).
+class UT_API TextureCompressor
+{
+public:
+	static bool							IsBlockCompressed(vk::Format format);
+	static bool							CanEncode(vk::Format format);
+	static std::string					GetCachePath(const std::string& sourcePath, vk::Format format);
+
+	static bool							CompressMipChain(const uint8_t* pRGBAChain, uint32_t width, uint32_t height, uint32_t mipLevels,
+														 vk::Format format, std::vector<uint8_t>* pOutBlocks);
+
+private:
+	static void							CompressLevel(const uint8_t* pRGBA, uint32_t width, uint32_t height, vk::Format format, uint8_t* pOutBlocks);
+
+	static void							EncodeBlockBC1(const uint8_t* pBlockRGBA, bool bAlphaCutout, uint8_t* pOut);
+	static void							EncodeBlockBC4(const uint8_t* pBlockRGBA, uint32_t channel, uint8_t* pOut);
+};
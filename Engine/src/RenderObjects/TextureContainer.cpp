@@ -0,0 +1,400 @@
+#include "UltimateEnginePCH.h"
+#include "TextureContainer.h"
+#include "TextureMipGenerator.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// DDS layout, see "DDS_HEADER" & "DDS_HEADER_DXT10" on MSDN. KTX2 layout, see Khronos KTX 2.0 spec section 3.
+namespace
+{
+	constexpr uint32_t	DDS_MAGIC				= 0x20534444;		// "DDS "
+	constexpr uint32_t	DDS_FOURCC_DX10			= 0x30315844;		// "DX10"
+	constexpr uint32_t	DDS_FOURCC_DXT1			= 0x31545844;		// "DXT1"
+	constexpr uint32_t	DDS_FOURCC_DXT3			= 0x33545844;		// "DXT3"
+	constexpr uint32_t	DDS_FOURCC_DXT5			= 0x35545844;		// "DXT5"
+	constexpr uint32_t	DDS_FOURCC_ATI1			= 0x31495441;		// "ATI1"
+	constexpr uint32_t	DDS_FOURCC_BC4U			= 0x55344342;		// "BC4U"
+	constexpr uint32_t	DDS_FOURCC_ATI2			= 0x32495441;		// "ATI2"
+	constexpr uint32_t	DDS_FOURCC_BC5U			= 0x55354342;		// "BC5U"
+
+	constexpr uint32_t	DDSD_CAPS				= 0x1;
+	constexpr uint32_t	DDSD_HEIGHT				= 0x2;
+	constexpr uint32_t	DDSD_WIDTH				= 0x4;
+	constexpr uint32_t	DDSD_PIXELFORMAT		= 0x1000;
+	constexpr uint32_t	DDSD_MIPMAPCOUNT		= 0x20000;
+	constexpr uint32_t	DDSD_LINEARSIZE			= 0x80000;
+	constexpr uint32_t	DDPF_FOURCC				= 0x4;
+	constexpr uint32_t	DDSCAPS_COMPLEX			= 0x8;
+	constexpr uint32_t	DDSCAPS_TEXTURE			= 0x1000;
+	constexpr uint32_t	DDSCAPS_MIPMAP			= 0x400000;
+	constexpr uint32_t	DDS_DIMENSION_TEXTURE2D	= 3;
+
+	struct DDSPixelFormat
+	{
+		uint32_t	size;
+		uint32_t	flags;
+		uint32_t	fourCC;
+		uint32_t	rgbBitCount;
+		uint32_t	rBitMask;
+		uint32_t	gBitMask;
+		uint32_t	bBitMask;
+		uint32_t	aBitMask;
+	};
+
+	struct DDSHeader
+	{
+		uint32_t		size;
+		uint32_t		flags;
+		uint32_t		height;
+		uint32_t		width;
+		uint32_t		pitchOrLinearSize;
+		uint32_t		depth;
+		uint32_t		mipMapCount;
+		uint32_t		reserved1[11];
+		DDSPixelFormat	pixelFormat;
+		uint32_t		caps;
+		uint32_t		caps2;
+		uint32_t		caps3;
+		uint32_t		caps4;
+		uint32_t		reserved2;
+	};
+
+	struct DDSHeaderDX10
+	{
+		uint32_t	dxgiFormat;
+		uint32_t	resourceDimension;
+		uint32_t	miscFlag;
+		uint32_t	arraySize;
+		uint32_t	miscFlags2;
+	};
+
+	constexpr uint8_t	KTX2_IDENTIFIER[12]		= { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct KTX2Header
+	{
+		uint8_t			identifier[12];
+		uint32_t		vkFormat;
+		uint32_t		typeSize;
+		uint32_t		pixelWidth;
+		uint32_t		pixelHeight;
+		uint32_t		pixelDepth;
+		uint32_t		layerCount;
+		uint32_t		faceCount;
+		uint32_t		levelCount;
+		uint32_t		supercompressionScheme;
+		uint32_t		dfdByteOffset;
+		uint32_t		dfdByteLength;
+		uint32_t		kvdByteOffset;
+		uint32_t		kvdByteLength;
+		uint64_t		sgdByteOffset;
+		uint64_t		sgdByteLength;
+	};
+
+	struct KTX2LevelIndex
+	{
+		uint64_t		byteOffset;
+		uint64_t		byteLength;
+		uint64_t		uncompressedByteLength;
+	};
+
+	static_assert(sizeof(DDSHeader) == 124, "DDS header must be 124 bytes!");
+	static_assert(sizeof(DDSHeaderDX10) == 20, "DDS DX10 header must be 20 bytes!");
+	static_assert(sizeof(KTX2Header) == 80, "KTX2 header must be 80 bytes!");
+	static_assert(sizeof(KTX2LevelIndex) == 24, "KTX2 level index entry must be 24 bytes!");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureContainer::IsContainerFile(const std::string& filePath)
+{
+	std::string extension = std::filesystem::path(filePath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(::tolower(c)); });
+
+	return extension == ".dds" || extension == ".ktx2";
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureContainer::Parse(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView)
+{
+	// Go by magic rather than extension, baked caches & hand made files both end up here
+	if (fileSize >= sizeof(KTX2_IDENTIFIER) && memcmp(pFileData, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+		return ParseKTX2(pFileData, fileSize, filePath, pOutView);
+
+	uint32_t magic = 0;
+	if (fileSize >= sizeof(magic))
+		memcpy(&magic, pFileData, sizeof(magic));
+
+	if (magic == DDS_MAGIC)
+		return ParseDDS(pFileData, fileSize, filePath, pOutView);
+
+	LOG_ERROR("{0} is neither DDS nor KTX2 file!", filePath);
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureContainer::GetView(const TextureContainerData& textureData, TextureContainerView* pOutView)
+{
+	pOutView->format = textureData.format;
+	pOutView->width = textureData.width;
+	pOutView->height = textureData.height;
+	pOutView->mipLevels = std::min(textureData.mipLevels, UT::VkGlobals::GMaxMipLevels);
+
+	const uint8_t* pLevel = textureData.data.data();
+	for (uint32_t mip = 0; mip < pOutView->mipLevels; ++mip)
+	{
+		pOutView->listLevelData[mip] = pLevel;
+		pLevel += UT::VkUtility::GetImageLevelSize(textureData.format, textureData.width, textureData.height, mip);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureContainer::ParseDDS(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView)
+{
+	DDSHeader header = {};
+	DDSHeaderDX10 headerDX10 = {};
+
+	size_t dataOffset = sizeof(DDS_MAGIC) + sizeof(DDSHeader);
+	if (fileSize < dataOffset)
+	{
+		LOG_ERROR("{0} is truncated!", filePath);
+		return false;
+	}
+
+	memcpy(&header, pFileData + sizeof(DDS_MAGIC), sizeof(header));
+	CHECK_LOG(header.size == sizeof(DDSHeader), "Invalid DDS header!");
+
+	// DX10 header tells the exact format, older files only have FourCC (DXT1/3/5, ATI1/2 etc.)
+	if (header.pixelFormat.fourCC == DDS_FOURCC_DX10)
+	{
+		if (fileSize < dataOffset + sizeof(DDSHeaderDX10))
+		{
+			LOG_ERROR("{0} is truncated!", filePath);
+			return false;
+		}
+
+		memcpy(&headerDX10, pFileData + dataOffset, sizeof(headerDX10));
+		dataOffset += sizeof(DDSHeaderDX10);
+
+		pOutView->format = FromDXGIFormat(headerDX10.dxgiFormat);
+
+		if (headerDX10.resourceDimension != DDS_DIMENSION_TEXTURE2D || headerDX10.arraySize > 1)
+		{
+			LOG_ERROR("{0} : only single 2D textures are supported!", filePath);
+			return false;
+		}
+	}
+	else
+	{
+		pOutView->format = (header.pixelFormat.flags & DDPF_FOURCC) ? FromFourCC(header.pixelFormat.fourCC) : vk::Format::eUndefined;
+	}
+
+	if (pOutView->format == vk::Format::eUndefined)
+	{
+		LOG_ERROR("{0} : unsupported DDS format!", filePath);
+		return false;
+	}
+
+	pOutView->width = header.width;
+	pOutView->height = header.height;
+	pOutView->mipLevels = std::max(header.mipMapCount, 1u);
+
+	CHECK_LOG(pOutView->width > 0 && pOutView->height > 0, "DDS has zero size!");
+	CHECK_LOG(pOutView->mipLevels <= UT::VkGlobals::GMaxMipLevels, "DDS has too many mip levels!");
+	CHECK_LOG(pOutView->mipLevels <= TextureMipGenerator::GetMipLevelCount(pOutView->width, pOutView->height), "DDS has more mip levels than its size allows!");
+
+	// Levels follow the header back to back, mip 0 first
+	size_t levelOffset = dataOffset;
+	for (uint32_t mip = 0; mip < pOutView->mipLevels; ++mip)
+	{
+		const vk::DeviceSize levelSize = UT::VkUtility::GetImageLevelSize(pOutView->format, pOutView->width, pOutView->height, mip);
+		// levelOffset never goes past fileSize, so this can't wrap around unlike adding levelSize to it
+		if (levelSize > fileSize - levelOffset)
+		{
+			LOG_ERROR("{0} is truncated!", filePath);
+			return false;
+		}
+
+		pOutView->listLevelData[mip] = pFileData + levelOffset;
+		levelOffset += static_cast<size_t>(levelSize);
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureContainer::ParseKTX2(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView)
+{
+	KTX2Header header = {};
+	if (fileSize < sizeof(KTX2Header))
+	{
+		LOG_ERROR("{0} is truncated!", filePath);
+		return false;
+	}
+
+	memcpy(&header, pFileData, sizeof(header));
+
+	// Basis/zstd payloads would need a transcoder, layers/faces/3D aren't something our materials use
+	if (header.supercompressionScheme != 0 || header.vkFormat == VK_FORMAT_UNDEFINED)
+	{
+		LOG_ERROR("{0} : supercompressed KTX2 is not supported!", filePath);
+		return false;
+	}
+
+	if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+	{
+		LOG_ERROR("{0} : only single 2D textures are supported!", filePath);
+		return false;
+	}
+
+	pOutView->format = static_cast<vk::Format>(header.vkFormat);
+	pOutView->width = header.pixelWidth;
+	pOutView->height = std::max(header.pixelHeight, 1u);
+	pOutView->mipLevels = std::max(header.levelCount, 1u);
+
+	CHECK_LOG(pOutView->width > 0 && pOutView->height > 0, "KTX2 has zero size!");
+	CHECK_LOG(pOutView->mipLevels <= UT::VkGlobals::GMaxMipLevels, "KTX2 has too many mip levels!");
+	CHECK_LOG(pOutView->mipLevels <= TextureMipGenerator::GetMipLevelCount(pOutView->width, pOutView->height), "KTX2 has more mip levels than its size allows!");
+
+	if (fileSize < sizeof(KTX2Header) + pOutView->mipLevels * sizeof(KTX2LevelIndex))
+	{
+		LOG_ERROR("{0} is truncated!", filePath);
+		return false;
+	}
+
+	// Level index is mip 0 first, even though data itself is stored smallest level first
+	for (uint32_t mip = 0; mip < pOutView->mipLevels; ++mip)
+	{
+		KTX2LevelIndex levelIndex = {};
+		memcpy(&levelIndex, pFileData + sizeof(KTX2Header) + mip * sizeof(KTX2LevelIndex), sizeof(levelIndex));
+
+		// Also catches formats we don't know the block size of, they'd come out with wrong size here. Offset & length
+		// come straight from the file, checked one at a time so a huge offset can't wrap their sum back into range
+		const vk::DeviceSize levelSize = UT::VkUtility::GetImageLevelSize(pOutView->format, pOutView->width, pOutView->height, mip);
+		if (levelIndex.byteLength != levelSize || levelIndex.byteOffset > fileSize || levelIndex.byteLength > fileSize - levelIndex.byteOffset)
+		{
+			LOG_ERROR("{0} : mip level {1} doesn't match its format or is truncated!", filePath, mip);
+			return false;
+		}
+
+		pOutView->listLevelData[mip] = pFileData + levelIndex.byteOffset;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureContainer::WriteDDS(const std::string& filePath, const TextureContainerData& textureData)
+{
+	const uint32_t dxgiFormat = ToDXGIFormat(textureData.format);
+	CHECK_LOG(dxgiFormat != 0, "Format can't be stored in DDS!");
+
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = textureData.height;
+	header.width = textureData.width;
+	header.pitchOrLinearSize = static_cast<uint32_t>(UT::VkUtility::GetImageLevelSize(textureData.format, textureData.width, textureData.height, 0));
+	header.depth = 1;
+	header.mipMapCount = textureData.mipLevels;
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = DDS_FOURCC_DX10;
+	header.caps = DDSCAPS_TEXTURE | ((textureData.mipLevels > 1) ? (DDSCAPS_COMPLEX | DDSCAPS_MIPMAP) : 0);
+
+	DDSHeaderDX10 headerDX10 = {};
+	headerDX10.dxgiFormat = dxgiFormat;
+	headerDX10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	headerDX10.arraySize = 1;
+
+	// Write to a temp file & rename, so that a half written cache is never picked up
+	const std::string tempPath = filePath + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		CHECK_LOG(file.is_open(), "Failed to open DDS file for writing!");
+
+		file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+		file.write(reinterpret_cast<const char*>(textureData.data.data()), static_cast<std::streamsize>(textureData.data.size()));
+
+		CHECK_LOG(file.good(), "Failed to write DDS file!");
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempPath, filePath, errorCode);
+	CHECK_LOG(!errorCode, errorCode.message());
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t TextureContainer::ToDXGIFormat(vk::Format format)
+{
+	switch (format)
+	{
+		case vk::Format::eR32G32B32A32Sfloat:	return 2;
+		case vk::Format::eR16G16B16A16Sfloat:	return 10;
+		case vk::Format::eR8G8B8A8Unorm:		return 28;
+		case vk::Format::eR8G8B8A8Srgb:			return 29;
+		case vk::Format::eBc1RgbUnormBlock:
+		case vk::Format::eBc1RgbaUnormBlock:	return 71;
+		case vk::Format::eBc1RgbSrgbBlock:
+		case vk::Format::eBc1RgbaSrgbBlock:		return 72;
+		case vk::Format::eBc2UnormBlock:		return 74;
+		case vk::Format::eBc2SrgbBlock:			return 75;
+		case vk::Format::eBc3UnormBlock:		return 77;
+		case vk::Format::eBc3SrgbBlock:			return 78;
+		case vk::Format::eBc4UnormBlock:		return 80;
+		case vk::Format::eBc4SnormBlock:		return 81;
+		case vk::Format::eBc5UnormBlock:		return 83;
+		case vk::Format::eBc5SnormBlock:		return 84;
+		case vk::Format::eBc6HUfloatBlock:		return 95;
+		case vk::Format::eBc6HSfloatBlock:		return 96;
+		case vk::Format::eBc7UnormBlock:		return 98;
+		case vk::Format::eBc7SrgbBlock:			return 99;
+		default:								return 0;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::Format TextureContainer::FromFourCC(uint32_t fourCC)
+{
+	switch (fourCC)
+	{
+		case DDS_FOURCC_DXT1:	return vk::Format::eBc1RgbaUnormBlock;
+		case DDS_FOURCC_DXT3:	return vk::Format::eBc2UnormBlock;
+		case DDS_FOURCC_DXT5:	return vk::Format::eBc3UnormBlock;
+		case DDS_FOURCC_ATI1:
+		case DDS_FOURCC_BC4U:	return vk::Format::eBc4UnormBlock;
+		case DDS_FOURCC_ATI2:
+		case DDS_FOURCC_BC5U:	return vk::Format::eBc5UnormBlock;
+		default:				return vk::Format::eUndefined;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::Format TextureContainer::FromDXGIFormat(uint32_t dxgiFormat)
+{
+	// DXGI has no separate RGB/RGBA BC1, alpha version decodes both
+	switch (dxgiFormat)
+	{
+		case 2:		return vk::Format::eR32G32B32A32Sfloat;
+		case 10:	return vk::Format::eR16G16B16A16Sfloat;
+		case 28:	return vk::Format::eR8G8B8A8Unorm;
+		case 29:	return vk::Format::eR8G8B8A8Srgb;
+		case 71:	return vk::Format::eBc1RgbaUnormBlock;
+		case 72:	return vk::Format::eBc1RgbaSrgbBlock;
+		case 74:	return vk::Format::eBc2UnormBlock;
+		case 75:	return vk::Format::eBc2SrgbBlock;
+		case 77:	return vk::Format::eBc3UnormBlock;
+		case 78:	return vk::Format::eBc3SrgbBlock;
+		case 80:	return vk::Format::eBc4UnormBlock;
+		case 81:	return vk::Format::eBc4SnormBlock;
+		case 83:	return vk::Format::eBc5UnormBlock;
+		case 84:	return vk::Format::eBc5SnormBlock;
+		case 95:	return vk::Format::eBc6HUfloatBlock;
+		case 96:	return vk::Format::eBc6HSfloatBlock;
+		case 98:	return vk::Format::eBc7UnormBlock;
+		case 99:	return vk::Format::eBc7SrgbBlock;
+		default:	return vk::Format::eUndefined;
+	}
+}
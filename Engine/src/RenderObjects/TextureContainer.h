@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../VulkanRenderer/VulkanGlobals.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// GPU ready texture data as it sits in a container file : every mip level tightly packed, mip 0 first.
+struct TextureContainerData
+{
+	TextureContainerData()
+	{
+		format = vk::Format::eUndefined;
+		width = 0;
+		height = 0;
+		mipLevels = 0;
+	}
+
+	vk::Format							format;
+	uint32_t							width;
+	uint32_t							height;
+	uint32_t							mipLevels;
+	std::vector<uint8_t>				data;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Non owning view of a parsed container. Level pointers point straight into whatever memory got parsed (usually a
+// MappedFile), so it's only valid as long as that memory is!
+struct TextureContainerView
+{
+	TextureContainerView()
+	{
+		format = vk::Format::eUndefined;
+		width = 0;
+		height = 0;
+		mipLevels = 0;
+		listLevelData.fill(nullptr);
+	}
+
+	vk::Format							format;
+	uint32_t							width;
+	uint32_t							height;
+	uint32_t							mipLevels;
+	std::array<const uint8_t*, UT::VkGlobals::GMaxMipLevels>	listLevelData;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Parses DDS (DX10 header or legacy DXTn/ATIn FourCC) & KTX2 (no supercompression) files into level views & writes
+// DDS files, used to cache block compressed textures on disk.
+class UT_API TextureContainer
+{
+public:
+	static bool							IsContainerFile(const std::string& filePath);
+	static bool							Parse(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView);
+	static void							GetView(const TextureContainerData& textureData, TextureContainerView* pOutView);
+
+	static bool							WriteDDS(const std::string& filePath, const TextureContainerData& textureData);
+
+	static uint32_t						ToDXGIFormat(vk::Format format);
+	static vk::Format					FromDXGIFormat(uint32_t dxgiFormat);
+
+private:
+	static bool							ParseDDS(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView);
+	static bool							ParseKTX2(const uint8_t* pFileData, size_t fileSize, const std::string& filePath, TextureContainerView* pOutView);
+	static vk::Format					FromFourCC(uint32_t fourCC);
+};
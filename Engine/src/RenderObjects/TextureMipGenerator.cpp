@@ -0,0 +1,232 @@
+#include "UltimateEnginePCH.h"
+#include "TextureMipGenerator.h"
+#include "../EngineHeader.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#define UT_MIP_SSE2
+	#include <emmintrin.h>
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
+static float SRGBToLinear(uint8_t value)
+{
+	static const std::array<float, 256> table = []()
+	{
+		std::array<float, 256> lut = {};
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			const float c = static_cast<float>(i) / 255.0f;
+			lut[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		return lut;
+	}();
+
+	return table[value];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static uint8_t LinearToSRGB(float value)
+{
+	value = std::clamp(value, 0.0f, 1.0f);
+
+	const float c = (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	return static_cast<uint8_t>(c * 255.0f + 0.5f);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t TextureMipGenerator::GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	uint32_t size = std::max(width, height);
+
+	while (size > 1)
+	{
+		size >>= 1;
+		++levels;
+	}
+
+	return levels;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t TextureMipGenerator::GetTexelSize(MipFilterFormat format)
+{
+	return (format == MipFilterFormat::MIP_FORMAT_RGBA32_FLOAT) ? 16 : 4;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t TextureMipGenerator::GetMipChainSize(uint32_t width, uint32_t height, uint32_t mipLevels, MipFilterFormat format)
+{
+	size_t chainSize = 0;
+
+	for (uint32_t mip = 0; mip < mipLevels; ++mip)
+	{
+		chainSize += static_cast<size_t>(width) * height * GetTexelSize(format);
+
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+
+	return chainSize;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool TextureMipGenerator::GenerateMipChain(const void* pSrcData, uint32_t width, uint32_t height, uint32_t mipLevels,
+										   MipFilterFormat format, std::vector<uint8_t>* pOutChain)
+{
+	CHECK_LOG(pSrcData && width > 0 && height > 0, "Invalid source image for mip generation!");
+
+	const size_t texelSize = GetTexelSize(format);
+
+	pOutChain->resize(GetMipChainSize(width, height, mipLevels, format));
+
+	// Mip 0 is just the source image...
+	uint8_t* pSrc = pOutChain->data();
+	memcpy(pSrc, pSrcData, static_cast<size_t>(width) * height * texelSize);
+
+	// ...every next level is filtered from the previous one, straight inside the chain
+	for (uint32_t mip = 1; mip < mipLevels; ++mip)
+	{
+		const uint32_t dstWidth = std::max(width / 2, 1u);
+		const uint32_t dstHeight = std::max(height / 2, 1u);
+
+		uint8_t* pDst = pSrc + static_cast<size_t>(width) * height * texelSize;
+
+		switch (format)
+		{
+			case MipFilterFormat::MIP_FORMAT_RGBA8_UNORM:
+				DownsampleRGBA8(pSrc, width, height, pDst, dstWidth, dstHeight);
+				break;
+
+			case MipFilterFormat::MIP_FORMAT_RGBA8_SRGB:
+				DownsampleRGBA8sRGB(pSrc, width, height, pDst, dstWidth, dstHeight);
+				break;
+
+			case MipFilterFormat::MIP_FORMAT_RGBA32_FLOAT:
+				DownsampleRGBA32F(reinterpret_cast<const float*>(pSrc), width, height, reinterpret_cast<float*>(pDst), dstWidth, dstHeight);
+				break;
+
+			default:
+				LOG_ERROR("Unsupported mip filter format!");
+				return false;
+		}
+
+		pSrc = pDst;
+		width = dstWidth;
+		height = dstHeight;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureMipGenerator::DownsampleRGBA8(const uint8_t* pSrc, uint32_t srcWidth, uint32_t srcHeight, uint8_t* pDst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		const uint8_t* pRow0 = pSrc + static_cast<size_t>(std::min(y * 2, srcHeight - 1)) * srcWidth * 4;
+		const uint8_t* pRow1 = pSrc + static_cast<size_t>(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * 4;
+		uint8_t* pDstRow = pDst + static_cast<size_t>(y) * dstWidth * 4;
+
+		uint32_t x = 0;
+
+#ifdef UT_MIP_SSE2
+		// Two output texels per iteration : 4 source texels from each row, widened to 16 bits so sums don't overflow
+		if (srcWidth >= 2)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+
+			for (; x + 2 <= dstWidth; x += 2)
+			{
+				const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + x * 8));
+				const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + x * 8));
+
+				// [t0 t1] & [t2 t3] summed vertically
+				const __m128i sumLo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+				const __m128i sumHi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+				// [t0+t2 ...] + [t1+t3 ...] = horizontal pairs
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(sumLo, sumHi), _mm_unpackhi_epi64(sumLo, sumHi));
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pDstRow + x * 4), _mm_packus_epi16(sum, zero));
+			}
+		}
+#endif
+
+		for (; x < dstWidth; ++x)
+		{
+			const uint32_t x0 = std::min(x * 2, srcWidth - 1) * 4;
+			const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const uint32_t sum = pRow0[x0 + c] + pRow0[x1 + c] + pRow1[x0 + c] + pRow1[x1 + c];
+				pDstRow[x * 4 + c] = static_cast<uint8_t>((sum + 2) >> 2);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureMipGenerator::DownsampleRGBA8sRGB(const uint8_t* pSrc, uint32_t srcWidth, uint32_t srcHeight, uint8_t* pDst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	// Averaging gamma encoded values darkens every level, so colour goes through linear space. Alpha is linear already!
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		const uint8_t* pRow0 = pSrc + static_cast<size_t>(std::min(y * 2, srcHeight - 1)) * srcWidth * 4;
+		const uint8_t* pRow1 = pSrc + static_cast<size_t>(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * 4;
+		uint8_t* pDstRow = pDst + static_cast<size_t>(y) * dstWidth * 4;
+
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const uint32_t x0 = std::min(x * 2, srcWidth - 1) * 4;
+			const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const float sum = SRGBToLinear(pRow0[x0 + c]) + SRGBToLinear(pRow0[x1 + c]) +
+								  SRGBToLinear(pRow1[x0 + c]) + SRGBToLinear(pRow1[x1 + c]);
+
+				pDstRow[x * 4 + c] = LinearToSRGB(sum * 0.25f);
+			}
+
+			const uint32_t alphaSum = pRow0[x0 + 3] + pRow0[x1 + 3] + pRow1[x0 + 3] + pRow1[x1 + 3];
+			pDstRow[x * 4 + 3] = static_cast<uint8_t>((alphaSum + 2) >> 2);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void TextureMipGenerator::DownsampleRGBA32F(const float* pSrc, uint32_t srcWidth, uint32_t srcHeight, float* pDst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		const float* pRow0 = pSrc + static_cast<size_t>(std::min(y * 2, srcHeight - 1)) * srcWidth * 4;
+		const float* pRow1 = pSrc + static_cast<size_t>(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * 4;
+		float* pDstRow = pDst + static_cast<size_t>(y) * dstWidth * 4;
+
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const uint32_t x0 = std::min(x * 2, srcWidth - 1) * 4;
+			const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+
+#ifdef UT_MIP_SSE2
+			// One RGBA texel is exactly one SSE register
+			const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(pRow0 + x0), _mm_loadu_ps(pRow0 + x1)),
+										  _mm_add_ps(_mm_loadu_ps(pRow1 + x0), _mm_loadu_ps(pRow1 + x1)));
+
+			_mm_storeu_ps(pDstRow + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				pDstRow[x * 4 + c] = (pRow0[x0 + c] + pRow0[x1 + c] + pRow1[x0 + c] + pRow1[x1 + c]) * 0.25f;
+			}
+#endif
+		}
+	}
+}
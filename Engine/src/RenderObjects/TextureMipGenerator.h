@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Core/Core.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+enum class MipFilterFormat
+{
+	MIP_FORMAT_RGBA8_UNORM = 0,
+	MIP_FORMAT_RGBA8_SRGB,				// filtered in linear space, then encoded back to sRGB
+	MIP_FORMAT_RGBA32_FLOAT,
+	MIP_FORMAT_END
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// CPU side mip chain generation, used when GPU can't linearly filter the format with vkCmdBlitImage. Every level is a
+// 2x2 box filter of the previous one (SSE2 on x64), odd edges are clamped.
+//
+// Output chain is tightly packed, mip 0 first, which is exactly how staging ring copies levels into the image.
+class UT_API TextureMipGenerator
+{
+public:
+	static uint32_t						GetMipLevelCount(uint32_t width, uint32_t height);
+	static uint32_t						GetTexelSize(MipFilterFormat format);
+	static size_t						GetMipChainSize(uint32_t width, uint32_t height, uint32_t mipLevels, MipFilterFormat format);
+
+	static bool							GenerateMipChain(const void* pSrcData, uint32_t width, uint32_t height, uint32_t mipLevels,
+														 MipFilterFormat format, std::vector<uint8_t>* pOutChain);
+
+private:
+	static void							DownsampleRGBA8(const uint8_t* pSrc, uint32_t srcWidth, uint32_t srcHeight, uint8_t* pDst, uint32_t dstWidth, uint32_t dstHeight);
+	static void							DownsampleRGBA8sRGB(const uint8_t* pSrc, uint32_t srcWidth, uint32_t srcHeight, uint8_t* pDst, uint32_t dstWidth, uint32_t dstHeight);
+	static void							DownsampleRGBA32F(const float* pSrc, uint32_t srcWidth, uint32_t srcHeight, float* pDst, uint32_t dstWidth, uint32_t dstHeight);
+};
@@ -4,9 +4,10 @@
 #include "VulkanMeshData.h"
 #include "GameObject.h"
 #include "VulkanCube.h"
+#include "../World/RenderSnapshot.h"
 #include "VulkanMaterial.h"
 #include "VulkanTexture.h"
-#include "../World/Camera.h"
+#include "VulkanMeshCache.h"
 #include "../VulkanRenderer/VulkanDevice.h"
 #include "../VulkanRenderer/VulkanGlobals.h"
 
@@ -14,10 +15,14 @@
 VulkanCube::VulkanCube(const std::string& name, const glm::vec4 color) : GameObject(name)
 {
 	m_Color = color;
+	m_fCurrentAngle = 0.0f;
 
-	m_pShaderDataBuffer = nullptr;
+	m_pShaderData = nullptr;
 	m_pMesh = nullptr;
 	m_pMaterial = nullptr;
+
+	m_bAssetsFinalized = false;
+	m_bReady = false;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -27,12 +32,20 @@ VulkanCube::~VulkanCube()
 	m_ListIndices.clear();
 
 	SAFE_DELETE(m_pMaterial);
-	SAFE_DELETE(m_pMesh);
-	SAFE_DELETE(m_pShaderDataBuffer);
+	SAFE_DELETE(m_pShaderData);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanCube::Initialize(const void* pDevice)
+{
+	// Nothing to create, layouts come from ForwardPassLayouts & assets from LoadAssets()
+	LOG_DEBUG("{0} Gameobject Initialized", GameObject::getName());
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCube::LoadAssets(const void* pDevice)
 {
 	const auto* pVulkanDevice = static_cast<const VulkanDevice*>(pDevice);
 
@@ -69,90 +82,87 @@ bool VulkanCube::Initialize(const void* pDevice)
 	m_ListIndices[30] = 0;				m_ListIndices[31] = 4;			m_ListIndices[32] = 5;
 	m_ListIndices[33] = 0;				m_ListIndices[34] = 5;			m_ListIndices[35] = 1;
 
-	m_pMesh = new VulkanMesh(pVulkanDevice, m_ListVertices, m_ListIndices);
+	// Every cube has the same geometry, so all of them share one mesh & scene draws them instanced
+	m_pMesh = pVulkanDevice->GetMeshCache()->Acquire("Cube", m_ListVertices, m_ListIndices);
+	CHECK(m_pMesh);
 
 	m_pMaterial = new VulkanMaterial();
-	m_pMaterial->CreateMaterial(pVulkanDevice, "Assets/Textures/Cube/DefaultWhite.png", TextureType::TEXTURE_ALBEDO, m_Color, m_Color);
+	CHECK(m_pMaterial->CreateMaterial(pVulkanDevice, "Assets/Textures/Cube/DefaultWhite.png", TextureType::TEXTURE_ALBEDO, m_Color, m_Color));
 
-	CHECK_LOG(SetupDescriptors(pVulkanDevice), "{0}'s Setup Descriptor FAILED!", GameObject::getName());
+	CHECK_LOG(CreateUniformData(pVulkanDevice), "{0}'s Uniform data creation FAILED!", GameObject::getName());
 
-	// Create pipeline layout!
-	const std::array<vk::DescriptorSetLayout, 1> setLayouts = { m_vkDescriptorSetLayout };
-	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-	pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+	return true;
+}
 
-	m_vkRenderingPipelineLayout = pVulkanDevice->GetDevice().createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCube::FinalizeAssets(const void* pDevice)
+{
+	// Nothing to create here anymore, textures went into bindless table as they were loaded!
+	m_bAssetsFinalized = true;
 
-	LOG_DEBUG("{0} Gameobject Initialized", GameObject::getName());
+	LOG_DEBUG("{0} Gameobject assets loaded", GameObject::getName());
 
 	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanCube::Render(const VulkanDevice* pDevice, uint32_t index) const
+bool VulkanCube::IsReady(const void* pDevice) const
 {
-	const std::vector<vk::Buffer> vertexBuffers = { m_pMesh->m_vkVertexBuffer.buffer };
-	const VkBuffer indexBuffer = m_pMesh->m_vkIndexBuffer.buffer;
-	const std::vector<vk::DeviceSize> offsets = { 0 };
-
-	// Bind VB & IB
-	const vk::CommandBuffer gfxCmdBuffer = pDevice->GetGraphicsCommandBuffer(index);
+	if (m_bReady)
+		return true;
 
-	//gfxCmdBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
-	gfxCmdBuffer.bindVertexBuffers(0, 1, vertexBuffers.data(), offsets.data());
-	gfxCmdBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+	if (!m_bAssetsFinalized)
+		return false;
 
-	gfxCmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_vkRenderingPipelineLayout, 0, 1, &(m_ListDescriptorSets[index]), 0, nullptr);
+	// Draw only once GPU has finished copying our mesh & textures
+	const auto* pVulkanDevice = static_cast<const VulkanDevice*>(pDevice);
+	m_bReady = m_pMesh->IsUploadComplete(pVulkanDevice) && m_pMaterial->IsUploadComplete(pVulkanDevice);
 
-	// Draw
-	gfxCmdBuffer.drawIndexed(m_pMesh->m_uiIndexCount, 1, 0, 0, 0);
+	return m_bReady;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanCube::Update(const Camera* pCamera, float dt) const
+void VulkanCube::Update(float dt)
 {
-	static float fCurrentAngle = 0.0f;
-	//fCurrentAngle += dt * 0.5f;
-	if (fCurrentAngle > 360.0f) { fCurrentAngle = 0.0f; }
+	// Per object, Update() runs on whichever thread simulation hands us to
+	//m_fCurrentAngle += dt * 0.5f;
+	if (m_fCurrentAngle > 360.0f) { m_fCurrentAngle = 0.0f; }
 
-	m_pShaderDataBuffer->shaderData.matWorld = glm::mat4(1);
-	m_pShaderDataBuffer->shaderData.matWorld = glm::translate(m_pShaderDataBuffer->shaderData.matWorld, m_vecPosition);
-	m_pShaderDataBuffer->shaderData.matWorld = glm::rotate(m_pShaderDataBuffer->shaderData.matWorld, glm::degrees(m_fRotation), m_vecRotationAxis);
-	m_pShaderDataBuffer->shaderData.matWorld = glm::scale(m_pShaderDataBuffer->shaderData.matWorld, m_vecScale);
+	m_pShaderData->instanceData.matWorld = glm::mat4(1);
+	m_pShaderData->instanceData.matWorld = glm::translate(m_pShaderData->instanceData.matWorld, m_vecPosition);
+	m_pShaderData->instanceData.matWorld = glm::rotate(m_pShaderData->instanceData.matWorld, glm::degrees(m_fRotation), m_vecRotationAxis);
+	m_pShaderData->instanceData.matWorld = glm::scale(m_pShaderData->instanceData.matWorld, m_vecScale);
 
-	const float aspect = (float)(UT::VkGlobals::GCurrentResolution.x)/ (float)(UT::VkGlobals::GCurrentResolution.y);
-	m_pShaderDataBuffer->shaderData.matProjection = pCamera->m_matProjection; //glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
-	m_pShaderDataBuffer->shaderData.matProjection[1][1] *= -1.0f;
-
-	m_pShaderDataBuffer->shaderData.matView = pCamera->m_matView; //glm::lookAt(glm::vec3(0.0f, 2.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-
-	m_pShaderDataBuffer->shaderData.albedoColor = m_Color;
+	// Camera matrices are per view, scene packs them once for everyone!
+	m_pShaderData->instanceData.albedoColor = m_Color;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanCube::UpdateUniforms(vk::Device vkDevice, uint32_t imageIndex) const
+void VulkanCube::FillSnapshot(SnapshotObject* pOutObject) const
 {
-	void* data;
+	// Copies only, renderer never looks at us while next frame's simulation runs
+	pOutObject->pMesh = m_pMesh;
+	pOutObject->instanceData = m_pShaderData->instanceData;
+	pOutObject->materialData = m_pShaderData->materialData;
+}
 
-	vkMapMemory(vkDevice, m_pShaderDataBuffer->listBuffers[imageIndex].deviceMemory, 0, sizeof(MeshUniformData), 0, &data);
-	memcpy(data, &(m_pShaderDataBuffer->shaderData), sizeof(MeshUniformData));
-	vkUnmapMemory(vkDevice, m_pShaderDataBuffer->listBuffers[imageIndex].deviceMemory);
+//---------------------------------------------------------------------------------------------------------------------
+const MaterialUniformData& VulkanCube::GetMaterialData() const
+{
+	return m_pShaderData->materialData;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanCube::Cleanup(void* pDevice)
 {
 	const VulkanDevice* ptrDevice = static_cast<const VulkanDevice*>(pDevice);
-	const vk::Device vkDevice = ptrDevice->GetDevice();
 
-	m_pMesh->Cleanup(ptrDevice->GetDevice());
-	m_pShaderDataBuffer->Cleanup(ptrDevice);
+	// Object might have never finished loading! Mesh goes back to the cache, last one out destroys it
+	ptrDevice->GetMeshCache()->Release(m_pMesh);
+	m_pMesh = nullptr;
 
-	vkDevice.destroyDescriptorPool(m_vkDescriptorPool);
-	vkDevice.destroyDescriptorSetLayout(m_vkDescriptorSetLayout);
+	if (m_pMaterial)
+		m_pMaterial->Cleanup(ptrDevice);
 
 	m_ListVertices.clear();
 	m_ListIndices.clear();
@@ -164,132 +174,23 @@ void VulkanCube::CleanupOnWindowsResize(VulkanDevice* pDevice)
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanCube::SetupDescriptors(const VulkanDevice* pDevice)
+bool VulkanCube::CreateUniformData(const VulkanDevice* pDevice)
 {
-	m_pShaderDataBuffer = new MeshUniformDataBuffer();
-	m_pShaderDataBuffer->CreateUniformDataBuffers(pDevice);
+	// Only CPU side data, instance & material are packed in device's uniform arena every frame!
+	m_pShaderData = new MeshShaderData();
 
 	// Set default material info!
-	m_pShaderDataBuffer->shaderData.albedoColor = m_Color;
-	m_pShaderDataBuffer->shaderData.emissionColor = m_Color;
-	m_pShaderDataBuffer->shaderData.hasTextureAEN = glm::vec3(0);
-	m_pShaderDataBuffer->shaderData.hasTextureRMO = glm::vec3(0);
-	m_pShaderDataBuffer->shaderData.metalness = 0.0f;
-	m_pShaderDataBuffer->shaderData.occlusion = 1.0f;
-	m_pShaderDataBuffer->shaderData.roughness = 1.0f;
-
-	// Descriptor Pool
-	CHECK(CreateDescriptorPool(pDevice))
-
-	// Descriptor Set Layout
-	CHECK(CreateDescriptorSetLayout(pDevice))
-
-	// Descriptor Sets
-	CHECK(CreateDescriptorSets(pDevice))
-}
-
-//---------------------------------------------------------------------------------------------------------------------
-bool VulkanCube::CreateDescriptorPool(const VulkanDevice* pDevice)
-{
-	std::array<vk::DescriptorPoolSize, 2> arrDescriptorPoolSize = {};
-
-	//-- Uniform buffers
-	arrDescriptorPoolSize[0].descriptorCount = pDevice->GetSwapchainImageCount();
-
-	//-- Texture samplers
-	arrDescriptorPoolSize[1].descriptorCount = m_pMaterial->GetTexturesCount();
-
-	vk::DescriptorPoolCreateInfo poolCreateInfo = {};
-	poolCreateInfo.maxSets = pDevice->GetSwapchainImageCount() + m_pMaterial->GetTexturesCount();
-	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(arrDescriptorPoolSize.size());
-	poolCreateInfo.pPoolSizes = arrDescriptorPoolSize.data();
-
-	// Create Descriptor Pool!
-	m_vkDescriptorPool = pDevice->GetDevice().createDescriptorPool(poolCreateInfo);
-
-	return true;
-}
-
-//---------------------------------------------------------------------------------------------------------------------
-bool VulkanCube::CreateDescriptorSetLayout(const VulkanDevice* pDevice)
-{
-	std::array < vk::DescriptorSetLayoutBinding, 2> layoutBindings;
-
-	// Uniform buffer
-	layoutBindings[0].binding = 0;
-	layoutBindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-	layoutBindings[0].descriptorCount = 1;
-	layoutBindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-
-	// Albedo texture
-	layoutBindings[1].binding = 1;
-	layoutBindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-	layoutBindings[1].descriptorCount = 1;
-	layoutBindings[1].stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
-	layoutBindings[1].pImmutableSamplers = nullptr;
-
-	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
-	layoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-	layoutCreateInfo.pBindings = layoutBindings.data();
-
-	m_vkDescriptorSetLayout = pDevice->GetDevice().createDescriptorSetLayout(layoutCreateInfo);
-
-	return true;
-}
-
-//---------------------------------------------------------------------------------------------------------------------
-bool VulkanCube::CreateDescriptorSets(const VulkanDevice* pDevice)
-{
-	//-- Descriptor Sets!
-	m_ListDescriptorSets.resize(pDevice->GetSwapchainImageCount());
-
-	// create copy of descriptor set layout for each swap chain image!
-	const std::vector<vk::DescriptorSetLayout> listSetLayouts(pDevice->GetSwapchainImageCount(), m_vkDescriptorSetLayout);
-
-	vk::DescriptorSetAllocateInfo setAllocInfo = {};
-	setAllocInfo.descriptorPool = m_vkDescriptorPool;
-	setAllocInfo.descriptorSetCount = static_cast<uint32_t>(listSetLayouts.size());
-	setAllocInfo.pSetLayouts = listSetLayouts.data();
-
-	m_ListDescriptorSets = pDevice->GetDevice().allocateDescriptorSets(setAllocInfo);
-
-	//-- Update all the descriptor set bindings!
-	for (uint16_t i = 0; i < pDevice->GetSwapchainImageCount(); i++)
-	{
-		//-- Uniform buffer
-		vk::DescriptorBufferInfo ubBufferInfo = {};
-		ubBufferInfo.buffer = m_pShaderDataBuffer->listBuffers[i].buffer;
-		ubBufferInfo.offset = 0;
-		ubBufferInfo.range = sizeof(MeshUniformData);
-
-		vk::WriteDescriptorSet ubWriteSet = {};
-		ubWriteSet.descriptorCount = 1;
-		ubWriteSet.descriptorType = vk::DescriptorType::eUniformBuffer;
-		ubWriteSet.dstArrayElement = 0;
-		ubWriteSet.dstBinding = 0;
-		ubWriteSet.dstSet = m_ListDescriptorSets[i];
-		ubWriteSet.pBufferInfo = &ubBufferInfo;
-
-		//-- Albedo Texture
-		vk::DescriptorImageInfo albedoImageInfo = {};
-		albedoImageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-		albedoImageInfo.imageView = m_pMaterial->GetVulkanTexture(TextureType::TEXTURE_ALBEDO)->getVkImageView();
-		albedoImageInfo.sampler = m_pMaterial->GetVulkanTexture(TextureType::TEXTURE_ALBEDO)->getVkSampler();
-
-		vk::WriteDescriptorSet albedoWriteSet = {};
-		albedoWriteSet.dstSet = m_ListDescriptorSets[i];
-		albedoWriteSet.dstBinding = 1;
-		albedoWriteSet.dstArrayElement = 0;
-		albedoWriteSet.descriptorType = vk::DescriptorType::eCombinedImageSampler;
-		albedoWriteSet.descriptorCount = 1;
-		albedoWriteSet.pImageInfo = &albedoImageInfo;
-
-		// List of all Descriptor set writes!
-		std::array<vk::WriteDescriptorSet, 2> listWriteSets = { ubWriteSet , albedoWriteSet };
-
-		// Update the descriptor sets with buffers/binding info
-		pDevice->GetDevice().updateDescriptorSets(listWriteSets, nullptr);
-	}
+	m_pShaderData->instanceData.albedoColor = m_Color;
+	m_pShaderData->materialData.emissionColor = m_Color;
+	m_pShaderData->materialData.textureIndexAEN = glm::ivec4(m_pMaterial->GetTextureIndex(TextureType::TEXTURE_ALBEDO),
+																m_pMaterial->GetTextureIndex(TextureType::TEXTURE_EMISSIVE),
+																m_pMaterial->GetTextureIndex(TextureType::TEXTURE_NORMAL), -1);
+	m_pShaderData->materialData.textureIndexRMO = glm::ivec4(m_pMaterial->GetTextureIndex(TextureType::TEXTURE_ROUGHNESS),
+																m_pMaterial->GetTextureIndex(TextureType::TEXTURE_METALNESS),
+																m_pMaterial->GetTextureIndex(TextureType::TEXTURE_AO), -1);
+	m_pShaderData->materialData.metalness = 0.0f;
+	m_pShaderData->materialData.occlusion = 1.0f;
+	m_pShaderData->materialData.roughness = 1.0f;
 
 	return true;
 }
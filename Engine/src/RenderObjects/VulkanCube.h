@@ -3,11 +3,14 @@
 #include "../VulkanRenderer/VulkanGlobals.h"
 #include "VulkanMesh.h"
 
+#include <atomic>
+
 class GameObject;
 class VulkanDevice;
 struct VulkanMeshData;
 class VulkanMaterial;
-class Camera;
+struct MaterialUniformData;
+struct SnapshotObject;
 
 class UT_API VulkanCube : public GameObject
 {
@@ -18,37 +21,37 @@ public:
 	~VulkanCube() override;
 
 	virtual bool						Initialize(const void* pDevice) override;
-	void								Render(const VulkanDevice* pDevice, uint32_t index) const;
-	void								Update(const Camera* pCamera, float dt) const;
-	void								UpdateUniforms(vk::Device vkDevice, uint32_t imageIndex) const;
+	virtual bool						LoadAssets(const void* pDevice) override;
+	virtual bool						FinalizeAssets(const void* pDevice) override;
+	virtual bool						IsReady(const void* pDevice) const override;
+	void								Update(float dt);
+	void								FillSnapshot(SnapshotObject* pOutObject) const;
 	void								Cleanup(void* pDevice);
 	void								CleanupOnWindowsResize(VulkanDevice* pDevice);
 
 private:
-	bool								SetupDescriptors(const VulkanDevice* pDevice);
-	bool								CreateDescriptorPool(const VulkanDevice* pDevice);
-	bool								CreateDescriptorSetLayout(const VulkanDevice* pDevice);
-	bool								CreateDescriptorSets(const VulkanDevice* pDevice);
+	bool								CreateUniformData(const VulkanDevice* pDevice);
 
 public:
-	inline vk::PipelineLayout			GetPipelineLayout() const { return m_vkRenderingPipelineLayout; }
+	inline const VulkanMesh*			GetMesh() const { return m_pMesh; }					// shared, from device's mesh cache
+	const MaterialUniformData&			GetMaterialData() const;
 
 	glm::vec4							getColor() const { return m_Color; }
 	void								setColor(const glm::vec4& _color) { m_Color = _color; }
 
 private:
-	vk::DescriptorPool					m_vkDescriptorPool;
-	vk::DescriptorSetLayout				m_vkDescriptorSetLayout;
-	std::vector<vk::DescriptorSet>		m_ListDescriptorSets;
-
-	vk::PipelineLayout					m_vkRenderingPipelineLayout;
-
 	VulkanMesh*							m_pMesh;
-	MeshUniformDataBuffer*				m_pShaderDataBuffer;
+	MeshShaderData*						m_pShaderData;
 	VulkanMaterial*						m_pMaterial;
 
 	std::vector<VertexPNTBT>			m_ListVertices;
 	std::vector<uint32_t>				m_ListIndices;
 
 	glm::vec4							m_Color;
+
+	float								m_fCurrentAngle;
+
+	// set by main thread (asset finalize, IsReady) & read by simulation jobs on any thread
+	std::atomic<bool>					m_bAssetsFinalized;
+	mutable std::atomic<bool>			m_bReady;
 };
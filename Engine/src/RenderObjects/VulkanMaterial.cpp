@@ -1,7 +1,9 @@
 #include "UltimateEnginePCH.h"
 #include "VulkanTexture.h"
 #include "VulkanMaterial.h"
+#include "VulkanTextureCache.h"
 #include "../VulkanRenderer/VulkanDevice.h"
+#include "../VulkanRenderer/VulkanBindlessTextures.h"
 
 //-----------------------------------------------------------------------------------------------------------------------
 VulkanMaterial::VulkanMaterial()
@@ -26,13 +28,7 @@ VulkanMaterial::VulkanMaterial()
 //-----------------------------------------------------------------------------------------------------------------------
 VulkanMaterial::~VulkanMaterial()
 {
-	std::unordered_map<TextureType, VulkanTexture*>::iterator iter = m_umapTextures.begin();
-
-	for( ; iter != m_umapTextures.end() ; ++iter)
-	{
-		SAFE_DELETE(iter->second);
-	}
-
+	// Textures are owned by device's texture cache, Cleanup() hands them back!
 	m_umapTextures.clear();
 
 	//SAFE_DELETE(m_pTextureAlbedo);
@@ -54,28 +50,49 @@ bool VulkanMaterial::CreateMaterial(const VulkanDevice* pDevice, const std::stri
 
 	if(type != TextureType::TEXTURE_NONE)
 		CHECK(LoadTexture(pDevice, filePath, type))
+
+	return true;
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
 bool VulkanMaterial::LoadTexture(const VulkanDevice* pDevice, const std::string& filePath, TextureType type)
 {
-	VulkanTexture* pTexture = new VulkanTexture();
-	
+	// Block compressed format first, plain RGBA8 if device can't sample it. Compressed data is cached on disk next to source!
+	vk::Format compressedFormat = vk::Format::eUndefined;
 	vk::Format textureFormat = vk::Format::eUndefined;
 
 	switch (type)
 	{
 		case TextureType::TEXTURE_ALBEDO:
 		{
+			compressedFormat = vk::Format::eBc3SrgbBlock;
 			textureFormat = vk::Format::eR8G8B8A8Srgb;
 			break;
 		}
 
 		case TextureType::TEXTURE_EMISSIVE:
+		{
+			compressedFormat = vk::Format::eBc1RgbUnormBlock;
+			textureFormat = vk::Format::eR8G8B8A8Unorm;
+			break;
+		}
+
 		case TextureType::TEXTURE_NORMAL:
+		{
+			compressedFormat = vk::Format::eBc5UnormBlock;
+			textureFormat = vk::Format::eR8G8B8A8Unorm;
+			break;
+		}
+
 		case TextureType::TEXTURE_ROUGHNESS:
 		case TextureType::TEXTURE_METALNESS:
 		case TextureType::TEXTURE_AO:
+		{
+			compressedFormat = vk::Format::eBc4UnormBlock;
+			textureFormat = vk::Format::eR8G8B8A8Unorm;
+			break;
+		}
+
 		case TextureType::TEXTURE_ERROR:
 		{
 			textureFormat = vk::Format::eR8G8B8A8Unorm;
@@ -92,7 +109,19 @@ bool VulkanMaterial::LoadTexture(const VulkanDevice* pDevice, const std::string&
 			break;
 	}
 
-	CHECK(pTexture->CreateTexture(pDevice, filePath, textureFormat));
+	if (compressedFormat != vk::Format::eUndefined)
+	{
+		const vk::FormatFeatureFlags sampledFlags = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		const vk::Format chosenFormat = pDevice->ChooseSupportedFormat({ compressedFormat, textureFormat }, vk::ImageTiling::eOptimal, sampledFlags);
+
+		if (chosenFormat != vk::Format::eUndefined)
+			textureFormat = chosenFormat;
+	}
+
+	// Same file might already be loaded by some other material, cache decodes & uploads it only once!
+	VulkanTexture* pTexture = pDevice->GetTextureCache()->Acquire(filePath, textureFormat);
+	CHECK(pTexture);
+
 	m_umapTextures.insert(std::make_pair(type, pTexture));
 
 	// Mark it that we have this "type" of texture within this material as bookkeeping!
@@ -108,11 +137,10 @@ void VulkanMaterial::Cleanup(const VulkanDevice* pDevice)
 
 	for (; iter != m_umapTextures.end(); ++iter)
 	{
-		if(iter->second != nullptr)
-		{
-			iter->second->Cleanup(pDevice);
-		}
+		pDevice->GetTextureCache()->Release(iter->second);
 	}
+
+	m_umapTextures.clear();
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -123,11 +151,29 @@ void VulkanMaterial::CleanupOnWindowResize(const VulkanDevice* pDevice)
 //-----------------------------------------------------------------------------------------------------------------------
 VulkanTexture* VulkanMaterial::GetVulkanTexture(TextureType type) const
 {
-	VulkanTexture* pTexture = new VulkanTexture();
+	return HasTexture(type) ? m_umapTextures.at(type) : nullptr;
+}
 
-	(HasTexture(type)) ? pTexture = m_umapTextures.at(type) : pTexture = nullptr;
+//-----------------------------------------------------------------------------------------------------------------------
+int32_t VulkanMaterial::GetTextureIndex(TextureType type) const
+{
+	const VulkanTexture* pTexture = GetVulkanTexture(type);
+	if (!pTexture || pTexture->getBindlessIndex() == VulkanBindlessTextures::InvalidIndex)
+		return -1;
+
+	return static_cast<int32_t>(pTexture->getBindlessIndex());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+bool VulkanMaterial::IsUploadComplete(const VulkanDevice* pDevice) const
+{
+	for (const std::pair<const TextureType, VulkanTexture*>& texture : m_umapTextures)
+	{
+		if (!texture.second->IsUploadComplete(pDevice))
+			return false;
+	}
 
-	return pTexture;
+	return true;
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -33,6 +33,8 @@ public:
 
 	inline uint32_t			GetTexturesCount() const					{ return static_cast<uint32_t>(m_umapTextures.size()); }
 	VulkanTexture*			GetVulkanTexture(TextureType type) const;
+	int32_t					GetTextureIndex(TextureType type) const;		// bindless slot, -1 if there's no such texture
+	bool					IsUploadComplete(const VulkanDevice* pDevice) const;
 
 public:
 	bool					HasTexture(TextureType type) const;
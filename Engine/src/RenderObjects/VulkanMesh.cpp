@@ -15,85 +15,77 @@ VulkanMesh::VulkanMesh(const VulkanDevice* pVulkanDevice, const std::vector<Vert
 	m_uiVertexCount = vertices.size();
 	m_uiIndexCount = indices.size();
 
-	CreateVertexBuffer(pVulkanDevice, vertices);
-	CreateIndexBuffer(pVulkanDevice, indices);
+	ComputeBoundingSphere(vertices);
+
+	// No buffers of our own, just a range in the pool. Stays invalid if pool is full!
+	if (!pVulkanDevice->GetMeshPool()->Allocate(m_uiVertexCount, m_uiIndexCount, &m_PoolAllocation))
+		return;
+
+	UploadVertices(pVulkanDevice, vertices);
+	UploadIndices(pVulkanDevice, indices);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanMesh::Cleanup(vk::Device vkDevice)
+void VulkanMesh::Cleanup(const VulkanDevice* pVulkanDevice)
 {
-	m_vkVertexBuffer.DestroyAll(vkDevice);
-	m_vkIndexBuffer.DestroyAll(vkDevice);
+	// Range goes back to the pool, GPU must be done with it by now!
+	pVulkanDevice->GetMeshPool()->Free(&m_PoolAllocation);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanMesh::CreateVertexBuffer(const VulkanDevice* pVulkanDevice, const std::vector<VertexPNTBT>& vertices)
+bool VulkanMesh::IsUploadComplete(const VulkanDevice* pVulkanDevice) const
 {
-	// Get the size of buffer needed for vertices
-	const VkDeviceSize bufferSize = m_uiVertexCount * sizeof(VertexPNTBT);
-	
-	// Create buffer & allocate memory to it!
-	UT::VkStructs::VulkanBuffer srcBuffer;
-	pVulkanDevice->CreateBuffer(bufferSize,
-								vk::BufferUsageFlagBits::eTransferSrc,
-								vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-								&srcBuffer);
-
-	// Map memory to Vertex buffer
-	const vk::Device vkDevice = pVulkanDevice->GetDevice();
-
-	void* data = vkDevice.mapMemory(srcBuffer.deviceMemory, 0, bufferSize);
-	memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-	vkDevice.unmapMemory(srcBuffer.deviceMemory);
-
-	// Now, Create buffer with TRANSFER_DST_BIT to make as recipient of data (also VERTEX_BUFFER_BIT)
-	// this time, buffer memory is set to DEVICE_LOCAL which means, it's on the GPU. 
-	pVulkanDevice->CreateBuffer( bufferSize,
-								 vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-								 vk::MemoryPropertyFlagBits::eDeviceLocal,
-								 &m_vkVertexBuffer);
-
-	// Copy staging buffer data to vertex buffer on GPUP using Command buffer!
-	pVulkanDevice->CopyBuffer(srcBuffer.buffer, m_vkVertexBuffer.buffer, bufferSize);
-	
-	// Destroy source/staging buffer!
-	srcBuffer.DestroyAll(vkDevice);
+	return pVulkanDevice->IsUploadComplete(m_UploadTicket);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanMesh::CreateIndexBuffer(const VulkanDevice* pVulkanDevice, const std::vector<uint32_t>& indices)
+void VulkanMesh::UploadVertices(const VulkanDevice* pVulkanDevice, const std::vector<VertexPNTBT>& vertices)
 {
-	// Get size of buffer needed for indices
-	const VkDeviceSize bufferSize = m_uiIndexCount * sizeof(uint32_t);
-
-	// Temporary buffer to "stage" index data before transferring to GPU
-	UT::VkStructs::VulkanBuffer srcBuffer;
-	pVulkanDevice->CreateBuffer(bufferSize,
-								vk::BufferUsageFlagBits::eTransferSrc,
-								vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-								&srcBuffer);
+	// Get the size & place of our vertices in pool's vertex buffer
+	const VkDeviceSize bufferSize = m_uiVertexCount * sizeof(VertexPNTBT);
+	const VkDeviceSize bufferOffset = static_cast<VkDeviceSize>(m_PoolAllocation.firstVertex) * sizeof(VertexPNTBT);
 
-	// Map memory to Index buffer
-	const vk::Device vkDevice = pVulkanDevice->GetDevice();
+	// Stage vertex data through the ring, copy is submitted with the next flush!
+	m_UploadTicket = pVulkanDevice->UploadToBuffer(vertices.data(), bufferSize, pVulkanDevice->GetMeshPool()->GetVertexBuffer(), bufferOffset);
+}
 
-	void* data = vkDevice.mapMemory(srcBuffer.deviceMemory, 0, bufferSize);
-	memcpy(data, indices.data(), static_cast<size_t>(bufferSize));
-	vkDevice.unmapMemory(srcBuffer.deviceMemory);
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanMesh::UploadIndices(const VulkanDevice* pVulkanDevice, const std::vector<uint32_t>& indices)
+{
+	// Get the size & place of our indices in pool's index buffer
+	const VkDeviceSize bufferSize = m_uiIndexCount * sizeof(uint32_t);
+	const VkDeviceSize bufferOffset = static_cast<VkDeviceSize>(m_PoolAllocation.firstIndex) * sizeof(uint32_t);
 
-	// Create buffer for index data on GPU access only area
-	pVulkanDevice->CreateBuffer(bufferSize,
-								vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-								vk::MemoryPropertyFlagBits::eDeviceLocal,
-								&m_vkIndexBuffer);
+	// Stage index data through the ring, copy is submitted with the next flush!
+	m_UploadTicket = pVulkanDevice->UploadToBuffer(indices.data(), bufferSize, pVulkanDevice->GetMeshPool()->GetIndexBuffer(), bufferOffset);
+}
 
-	// Copy staging buffer data to vertex buffer on GPUP using Command buffer!
-	pVulkanDevice->CopyBuffer(srcBuffer.buffer, m_vkIndexBuffer.buffer, bufferSize);
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanMesh::ComputeBoundingSphere(const std::vector<VertexPNTBT>& vertices)
+{
+	m_vecBoundingSphere = glm::vec4(0);
 
-	// Destroy source/staging buffer!
-	srcBuffer.DestroyAll(vkDevice);
-}
+	if (vertices.empty())
+		return;
 
+	// Centered on the bounding box, not the tightest sphere but good enough for culling & cheap to get!
+	glm::vec3 minPos = vertices[0].Position;
+	glm::vec3 maxPos = vertices[0].Position;
 
+	for (const VertexPNTBT& vertex : vertices)
+	{
+		minPos = glm::min(minPos, vertex.Position);
+		maxPos = glm::max(maxPos, vertex.Position);
+	}
 
+	const glm::vec3 center = (minPos + maxPos) * 0.5f;
 
+	float radiusSq = 0.0f;
+	for (const VertexPNTBT& vertex : vertices)
+	{
+		const glm::vec3 offset = vertex.Position - center;
+		radiusSq = std::max(radiusSq, glm::dot(offset, offset));
+	}
 
+	m_vecBoundingSphere = glm::vec4(center, std::sqrt(radiusSq));
+}
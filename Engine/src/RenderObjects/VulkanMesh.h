@@ -3,6 +3,7 @@
 #include "vulkan/vulkan.hpp"
 #include "../VulkanRenderer/VulkanGlobals.h"
 #include "VulkanMeshData.h"
+#include "VulkanMeshPool.h"
 
 class VulkanDevice;
 
@@ -13,7 +14,7 @@ public:
 	VulkanMesh();
 	VulkanMesh(const VulkanDevice* pVulkanDevice, const std::vector<VertexPNTBT>& vertices, const std::vector<uint32_t>& indices);
 
-	void							Cleanup(vk::Device vkDevice);
+	void							Cleanup(const VulkanDevice* pVulkanDevice);
 
 	~VulkanMesh();
 
@@ -21,11 +22,20 @@ public:
 	uint32_t						m_uiVertexCount;
 	uint32_t						m_uiIndexCount;
 
-	UT::VkStructs::VulkanBuffer		m_vkVertexBuffer;
-	UT::VkStructs::VulkanBuffer		m_vkIndexBuffer;
+	// Local space, xyz center & w radius. Culling pass transforms it by every instance's world matrix
+	glm::vec4						m_vecBoundingSphere;
+
+	// Our range in device's mesh pool, vertex & index buffers are shared by every mesh
+	MeshPoolAllocation				m_PoolAllocation;
+
+	// vertex & index data go in the same staging batch, so one ticket covers both
+	UT::VkStructs::UploadTicket		m_UploadTicket;
+
+	inline bool						IsValid() const { return m_PoolAllocation.IsValid(); }
+	bool							IsUploadComplete(const VulkanDevice* pVulkanDevice) const;
 
 private:
-	void							CreateVertexBuffer(const VulkanDevice* pVulkanDevice, const std::vector<VertexPNTBT>& vertices);
-	void							CreateIndexBuffer(const VulkanDevice* pVulkanDevice, const std::vector<uint32_t>& indices);
+	void							UploadVertices(const VulkanDevice* pVulkanDevice, const std::vector<VertexPNTBT>& vertices);
+	void							UploadIndices(const VulkanDevice* pVulkanDevice, const std::vector<uint32_t>& indices);
+	void							ComputeBoundingSphere(const std::vector<VertexPNTBT>& vertices);
 };
-
@@ -0,0 +1,111 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanMeshCache.h"
+#include "../VulkanRenderer/VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshCache::VulkanMeshCache()
+{
+	m_pDevice = nullptr;
+	m_umapMeshes.clear();
+	m_umapMeshNames.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshCache::~VulkanMeshCache()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanMeshCache::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshCache::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Whatever is still here was never released by its object!
+	for (std::pair<const std::string, CacheEntry>& entry : m_umapMeshes)
+	{
+		LOG_WARNING("Mesh cache : {0} still has {1} reference(s) at cleanup", entry.first, entry.second.refCount);
+
+		entry.second.pMesh->Cleanup(m_pDevice);
+		SAFE_DELETE(entry.second.pMesh);
+	}
+
+	m_umapMeshes.clear();
+	m_umapMeshNames.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMesh* VulkanMeshCache::Acquire(const std::string& meshName, const std::vector<VertexPNTBT>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const std::unordered_map<std::string, CacheEntry>::iterator iter = m_umapMeshes.find(meshName);
+	if (iter != m_umapMeshes.end())
+	{
+		++iter->second.refCount;
+		return iter->second.pMesh;
+	}
+
+	CacheEntry newEntry;
+	newEntry.pMesh = new VulkanMesh(m_pDevice, vertices, indices);
+	newEntry.refCount = 1;
+
+	if (!newEntry.pMesh->IsValid())
+	{
+		LOG_ERROR("Mesh cache : failed to create {0}", meshName);
+		SAFE_DELETE(newEntry.pMesh);
+		return nullptr;
+	}
+
+	m_umapMeshes.emplace(meshName, newEntry);
+	m_umapMeshNames.emplace(newEntry.pMesh, meshName);
+
+	LOG_DEBUG("Mesh cache : created {0}", meshName);
+
+	return newEntry.pMesh;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshCache::Release(VulkanMesh* pMesh)
+{
+	if (pMesh == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const std::unordered_map<VulkanMesh*, std::string>::iterator nameIter = m_umapMeshNames.find(pMesh);
+	if (nameIter == m_umapMeshNames.end())
+	{
+		LOG_ERROR("Mesh cache : releasing a mesh which isn't in cache!");
+		return;
+	}
+
+	const std::unordered_map<std::string, CacheEntry>::iterator iter = m_umapMeshes.find(nameIter->second);
+	if (--iter->second.refCount > 0)
+		return;
+
+	// Last user is gone. Callers release at cleanup time, after GPU is done with the mesh!
+	LOG_DEBUG("Mesh cache : destroying {0}", iter->first);
+
+	iter->second.pMesh->Cleanup(m_pDevice);
+	SAFE_DELETE(iter->second.pMesh);
+
+	m_umapMeshes.erase(iter);
+	m_umapMeshNames.erase(nameIter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanMeshCache::GetMeshCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return static_cast<uint32_t>(m_umapMeshes.size());
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "VulkanMesh.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reference counted meshes, keyed by name. Every object asking for the same geometry gets the same VulkanMesh, so it's
+// stored on GPU only once & scene can draw all its users with a single instanced draw.
+//
+// Acquire() can be called from asset loader threads. Mesh is created under the lock, it's only a range out of mesh
+// pool & a copy into staging ring, nothing worth waiting outside of it for!
+class UT_API VulkanMeshCache
+{
+public:
+	VulkanMeshCache();
+	~VulkanMeshCache();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	VulkanMesh*							Acquire(const std::string& meshName, const std::vector<VertexPNTBT>& vertices, const std::vector<uint32_t>& indices);
+	void								Release(VulkanMesh* pMesh);
+
+	uint32_t							GetMeshCount() const;
+
+private:
+	struct CacheEntry
+	{
+		VulkanMesh*						pMesh;
+		uint32_t						refCount;
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	std::unordered_map<std::string, CacheEntry>		m_umapMeshes;
+	std::unordered_map<VulkanMesh*, std::string>	m_umapMeshNames;
+
+	mutable std::mutex					m_Mutex;
+};
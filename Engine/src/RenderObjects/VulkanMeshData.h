@@ -2,73 +2,115 @@
 
 #include "..\VulkanRenderer\VulkanGlobals.h"
 #include "..\VulkanRenderer\VulkanDevice.h"
+#include "..\VulkanRenderer\VulkanUniformArena.h"
+#include "..\VulkanRenderer\VulkanLayoutCache.h"
+#include "..\VulkanRenderer\VulkanBindlessTextures.h"
 
 //---------------------------------------------------------------------------------------------------------------------
-struct MeshUniformData
+// Per view data, packed once per frame & bound once at set 0. Matches "ViewData" block in shaders!
+struct ViewUniformData
 {
-	MeshUniformData()
+	ViewUniformData()
 	{
-		matWorld = glm::mat4(1);
 		matView = glm::mat4(1);
 		matProjection = glm::mat4(1);
+		matViewProjection = glm::mat4(1);
+		cameraPosition = glm::vec4(0);
 	}
 
-	// Transformation data...
-	alignas(64) glm::mat4 matWorld;
-	alignas(64) glm::mat4 matView;
-	alignas(64) glm::mat4 matProjection;
+	alignas(16) glm::mat4	matView;
+	alignas(16) glm::mat4	matProjection;
+	alignas(16) glm::mat4	matViewProjection;		// premultiplied on CPU, vertex shader does one mat * vec less
+	alignas(16) glm::vec4	cameraPosition;
+};
 
-	// Material data...
-	alignas(16)	glm::vec4	albedoColor;
-	alignas(16) glm::vec4	emissionColor;
-	alignas(16) glm::ivec3	hasTextureAEN;
-	alignas(16) glm::ivec3	hasTextureRMO;
-	alignas(4)	float		occlusion;
-	alignas(4)	float		roughness;
-	alignas(4)	float		metalness;
+//---------------------------------------------------------------------------------------------------------------------
+// Per instance data, read through instance rate vertex binding 1 (locations 5 to 10). Scene packs every ready object's
+// copy into this frame's uniform arena grouped by mesh, culling pass copies survivors into its own buffer which is what
+// forward pass actually reads. Attribute layout in forward pipeline & "InstanceData" struct in cull.comp (std430) must
+// both follow this struct!
+struct InstanceData
+{
+	InstanceData()
+	{
+		matWorld = glm::mat4(1);
+		albedoColor = glm::vec4(1);
+		materialIndex = 0;
+		drawIndex = 0;
+		padding[0] = 0;
+		padding[1] = 0;
+	}
+
+	glm::mat4				matWorld;					// 4 consecutive vec4 locations
+	glm::vec4				albedoColor;
+	uint32_t				materialIndex;				// into this frame's material block
+	uint32_t				drawIndex;					// into this frame's draw table, culling only
+	uint32_t				padding[2];					// std430 array stride is 96
 };
 
 //---------------------------------------------------------------------------------------------------------------------
-struct MeshUniformDataBuffer
+// Per object material data. Scene packs every distinct one into one array in the uniform arena, bound once at set 1.
+// Matches "MaterialData" struct in shaders, std140 array stride is 64!
+struct MaterialUniformData
 {
-	MeshUniformDataBuffer()
+	MaterialUniformData()
 	{
-		listBuffers.clear();
+		emissionColor = glm::vec4(0);
+		textureIndexAEN = glm::ivec4(-1);
+		textureIndexRMO = glm::ivec4(-1);
+		occlusion = 1.0f;
+		roughness = 1.0f;
+		metalness = 0.0f;
 	}
 
-	inline UT_API void	CreateUniformDataBuffers(const VulkanDevice* pDevice)
+	// Member by member, padding at the end is never initialized
+	bool operator==(const MaterialUniformData& rhs) const
 	{
-		vk::DeviceSize bufferSize = sizeof(MeshUniformData);
+		return emissionColor == rhs.emissionColor && textureIndexAEN == rhs.textureIndexAEN && textureIndexRMO == rhs.textureIndexRMO &&
+			   occlusion == rhs.occlusion && roughness == rhs.roughness && metalness == rhs.metalness;
+	}
 
-		// one uniform buffer for each swapchain/command buffer
-		const uint16_t count = pDevice->GetSwapchainImageCount();
+	alignas(16) glm::vec4	emissionColor;
+	alignas(16) glm::ivec4	textureIndexAEN;			// Albedo | Emissive | Normal, slots in bindless table, -1 if none
+	alignas(16) glm::ivec4	textureIndexRMO;			// Roughness | Metallic | Occlusion
+	alignas(4)	float		occlusion;
+	alignas(4)	float		roughness;
+	alignas(4)	float		metalness;
+};
 
-		for (uint16_t i = 0; i < count; i++)
-		{
-			UT::VkStructs::VulkanBuffer buffer;
-			pDevice->CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer,
-				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-				&buffer);
+static_assert(sizeof(ViewUniformData) <= UT::VkGlobals::GMaxUniformBlockSize, "ViewUniformData doesn't fit in uniform arena's binding range!");
+static_assert(sizeof(InstanceData) == 96, "InstanceData must match cull shader's std430 array stride!");
+static_assert(sizeof(InstanceData) == UT::VkGlobals::GInstanceDataSize, "Uniform arena is sized with GInstanceDataSize!");
+static_assert(sizeof(MaterialUniformData) == 64, "MaterialUniformData must match shader's std140 array stride!");
+static_assert(sizeof(MaterialUniformData) * UT::VkGlobals::GMaxMaterialsPerFrame <= UT::VkGlobals::GMaxUniformBlockSize, "Material block doesn't fit in uniform arena's binding range!");
 
-			listBuffers.emplace_back(buffer);
-		}
-	}
+//---------------------------------------------------------------------------------------------------------------------
+// CPU copy of object's shader data. Material gets copied into frame's material block, index of that slot goes into
+// instance data which is packed next to the instances of everyone else sharing our mesh.
+struct MeshShaderData
+{
+	InstanceData								instanceData;
+	MaterialUniformData							materialData;
+};
 
-	inline UT_API void	Cleanup(const VulkanDevice* pDevice)
+//---------------------------------------------------------------------------------------------------------------------
+// Layouts of forward pass shader interface : set 0 view block & set 1 material block (both in uniform arena), set 2
+// device's bindless texture table. No push constants, whole scene is one indirect draw so there's nothing left to push
+// per draw, everything per object comes in as InstanceData. Forward pipeline & scene get them from device's layout
+// cache through here, so they're created once & nobody borrows them from objects!
+struct ForwardPassLayouts
+{
+	static vk::DescriptorSetLayout GetTextureSetLayout(const VulkanDevice* pDevice)
 	{
-		for (uint16_t i = 0; i < pDevice->GetSwapchainImageCount(); i++)
-		{
-			listBuffers[i].DestroyAll(pDevice->GetDevice());
-		}
+		// Every texture lives in one table, materials index into it
+		return pDevice->GetBindlessTextures()->GetDescriptorSetLayout();
 	}
 
-	inline UT_API void	CleanupOnWindowsResize(const VulkanDevice* pDevice)
+	static vk::PipelineLayout GetPipelineLayout(const VulkanDevice* pDevice)
 	{
-
+		const vk::DescriptorSetLayout arenaSetLayout = pDevice->GetUniformArena()->GetDescriptorSetLayout();
+		return pDevice->GetLayoutCache()->GetPipelineLayout({ arenaSetLayout, arenaSetLayout, GetTextureSetLayout(pDevice) }, {});
 	}
-
-	MeshUniformData								shaderData;
-	std::vector<UT::VkStructs::VulkanBuffer>	listBuffers;
 };
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,197 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanMeshPool.h"
+#include "../VulkanRenderer/VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshPool::VulkanMeshPool()
+{
+	m_pDevice = nullptr;
+	m_uiMaxVertices = 0;
+	m_uiMaxIndices = 0;
+	m_uiUsedVertices = 0;
+	m_uiUsedIndices = 0;
+
+	m_mapFreeVertices.clear();
+	m_mapFreeIndices.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMeshPool::~VulkanMeshPool()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanMeshPool::Initialize(const VulkanDevice* pDevice, uint32_t maxVertices, uint32_t maxIndices)
+{
+	m_pDevice = pDevice;
+	m_uiMaxVertices = maxVertices;
+	m_uiMaxIndices = maxIndices;
+
+	// Filled only through staging ring, never touched by CPU!
+	const bool bVertexBuffer = m_pDevice->CreateBuffer(static_cast<vk::DeviceSize>(maxVertices) * sizeof(VertexPNTBT),
+													   vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+													   vk::MemoryPropertyFlagBits::eDeviceLocal,
+													   &m_vkVertexBuffer);
+
+	const bool bIndexBuffer = m_pDevice->CreateBuffer(static_cast<vk::DeviceSize>(maxIndices) * sizeof(uint32_t),
+													  vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+													  vk::MemoryPropertyFlagBits::eDeviceLocal,
+													  &m_vkIndexBuffer);
+
+	CHECK_LOG(bVertexBuffer && bIndexBuffer, "Failed to create mesh pool buffers!");
+
+	// whole buffer is one big hole to begin with!
+	m_mapFreeVertices.insert(std::make_pair(0, maxVertices));
+	m_mapFreeIndices.insert(std::make_pair(0, maxIndices));
+
+	LOG_DEBUG("Mesh pool : {0} vertices, {1} indices", maxVertices, maxIndices);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshPool::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_uiUsedVertices > 0 || m_uiUsedIndices > 0)
+	{
+		LOG_WARNING("Mesh pool : {0} vertices & {1} indices still allocated at cleanup", m_uiUsedVertices, m_uiUsedIndices);
+	}
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	m_vkVertexBuffer.DestroyAll(vkDevice);
+	m_vkIndexBuffer.DestroyAll(vkDevice);
+
+	m_mapFreeVertices.clear();
+	m_mapFreeIndices.clear();
+	m_uiUsedVertices = 0;
+	m_uiUsedIndices = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanMeshPool::Allocate(uint32_t vertexCount, uint32_t indexCount, MeshPoolAllocation* pOutAllocation)
+{
+	if (vertexCount == 0 || indexCount == 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	uint32_t firstVertex = 0;
+	if (!AllocateRange(&m_mapFreeVertices, vertexCount, &firstVertex))
+	{
+		LOG_ERROR("Mesh pool : no room for {0} vertices ({1}/{2} used)!", vertexCount, m_uiUsedVertices, m_uiMaxVertices);
+		return false;
+	}
+
+	uint32_t firstIndex = 0;
+	if (!AllocateRange(&m_mapFreeIndices, indexCount, &firstIndex))
+	{
+		LOG_ERROR("Mesh pool : no room for {0} indices ({1}/{2} used)!", indexCount, m_uiUsedIndices, m_uiMaxIndices);
+		ReleaseRange(&m_mapFreeVertices, firstVertex, vertexCount);
+		return false;
+	}
+
+	m_uiUsedVertices += vertexCount;
+	m_uiUsedIndices += indexCount;
+
+	pOutAllocation->firstVertex = firstVertex;
+	pOutAllocation->vertexCount = vertexCount;
+	pOutAllocation->firstIndex = firstIndex;
+	pOutAllocation->indexCount = indexCount;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshPool::Free(MeshPoolAllocation* pAllocation)
+{
+	if (!pAllocation->IsValid())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	ReleaseRange(&m_mapFreeVertices, pAllocation->firstVertex, pAllocation->vertexCount);
+	ReleaseRange(&m_mapFreeIndices, pAllocation->firstIndex, pAllocation->indexCount);
+
+	m_uiUsedVertices -= pAllocation->vertexCount;
+	m_uiUsedIndices -= pAllocation->indexCount;
+
+	*pAllocation = MeshPoolAllocation();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshPool::LogStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	LOG_INFO("Mesh pool : {0}/{1} vertices & {2}/{3} indices used, {4} + {5} holes", m_uiUsedVertices, m_uiMaxVertices,
+			 m_uiUsedIndices, m_uiMaxIndices, m_mapFreeVertices.size(), m_mapFreeIndices.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanMeshPool::AllocateRange(FreeRanges* pFreeRanges, uint32_t count, uint32_t* pOutFirst)
+{
+	// Best fit : pick the hole which leaves the least amount of space behind!
+	FreeRanges::iterator bestIter = pFreeRanges->end();
+	uint32_t bestLeftover = std::numeric_limits<uint32_t>::max();
+
+	for (FreeRanges::iterator iter = pFreeRanges->begin(); iter != pFreeRanges->end(); ++iter)
+	{
+		if (iter->second < count)
+			continue;
+
+		const uint32_t leftover = iter->second - count;
+		if (leftover < bestLeftover)
+		{
+			bestLeftover = leftover;
+			bestIter = iter;
+
+			if (leftover == 0)
+				break;
+		}
+	}
+
+	if (bestIter == pFreeRanges->end())
+		return false;
+
+	const uint32_t rangeFirst = bestIter->first;
+	const uint32_t rangeCount = bestIter->second;
+
+	pFreeRanges->erase(bestIter);
+
+	// Tail goes back as a smaller hole
+	if (count < rangeCount)
+		pFreeRanges->insert(std::make_pair(rangeFirst + count, rangeCount - count));
+
+	*pOutFirst = rangeFirst;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMeshPool::ReleaseRange(FreeRanges* pFreeRanges, uint32_t first, uint32_t count)
+{
+	FreeRanges::iterator iter = pFreeRanges->insert(std::make_pair(first, count)).first;
+
+	// Merge with the next hole...
+	FreeRanges::iterator nextIter = std::next(iter);
+	if (nextIter != pFreeRanges->end() && iter->first + iter->second == nextIter->first)
+	{
+		iter->second += nextIter->second;
+		pFreeRanges->erase(nextIter);
+	}
+
+	// ...& with the previous one!
+	if (iter != pFreeRanges->begin())
+	{
+		FreeRanges::iterator prevIter = std::prev(iter);
+		if (prevIter->first + prevIter->second == iter->first)
+		{
+			prevIter->second += iter->second;
+			pFreeRanges->erase(iter);
+		}
+	}
+}
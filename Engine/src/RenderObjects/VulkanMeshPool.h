@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../VulkanRenderer/VulkanGlobals.h"
+#include "VulkanMeshData.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Where a mesh lives inside the pool, in vertices & indices rather than bytes. firstVertex goes into draw's
+// vertexOffset, so indices stay relative to the mesh itself!
+struct MeshPoolAllocation
+{
+	MeshPoolAllocation()
+	{
+		firstVertex = 0;
+		vertexCount = 0;
+		firstIndex = 0;
+		indexCount = 0;
+	}
+
+	inline bool							IsValid() const { return vertexCount > 0 && indexCount > 0; }
+
+	uint32_t							firstVertex;
+	uint32_t							vertexCount;
+	uint32_t							firstIndex;
+	uint32_t							indexCount;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// One device local vertex buffer & one index buffer shared by every mesh. Meshes get best-fit ranges out of them,
+// freed ranges are merged with their neighbours. Scene binds both once per frame & draws everything with a single
+// indirect draw, no matter how many different meshes there are!
+//
+// Allocate() & Free() can be called from asset loader threads. Range handed to Free() must no longer be used by any
+// pending frame, it's reused by the next Allocate()!
+class UT_API VulkanMeshPool
+{
+public:
+	VulkanMeshPool();
+	~VulkanMeshPool();
+
+	bool								Initialize(const VulkanDevice* pDevice, uint32_t maxVertices, uint32_t maxIndices);
+	void								Cleanup();
+
+	bool								Allocate(uint32_t vertexCount, uint32_t indexCount, MeshPoolAllocation* pOutAllocation);
+	void								Free(MeshPoolAllocation* pAllocation);
+
+	inline vk::Buffer					GetVertexBuffer() const							{ return m_vkVertexBuffer.buffer; }
+	inline vk::Buffer					GetIndexBuffer() const							{ return m_vkIndexBuffer.buffer; }
+	void								LogStats() const;
+
+private:
+	// offset -> size of every hole, sorted so neighbours can merge
+	typedef std::map<uint32_t, uint32_t>	FreeRanges;
+
+	static bool							AllocateRange(FreeRanges* pFreeRanges, uint32_t count, uint32_t* pOutFirst);
+	static void							ReleaseRange(FreeRanges* pFreeRanges, uint32_t first, uint32_t count);
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	UT::VkStructs::VulkanBuffer			m_vkVertexBuffer;
+	UT::VkStructs::VulkanBuffer			m_vkIndexBuffer;
+
+	uint32_t							m_uiMaxVertices;
+	uint32_t							m_uiMaxIndices;
+	uint32_t							m_uiUsedVertices;
+	uint32_t							m_uiUsedIndices;
+
+	FreeRanges							m_mapFreeVertices;
+	FreeRanges							m_mapFreeIndices;
+
+	mutable std::mutex					m_Mutex;
+};
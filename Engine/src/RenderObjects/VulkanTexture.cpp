@@ -3,15 +3,22 @@
 #include "VulkanTexture.h"
 #include "../VulkanRenderer/VulkanDevice.h"
 #include "../VulkanRenderer/VulkanGlobals.h"
+#include "../VulkanRenderer/VulkanSamplerCache.h"
+#include "../VulkanRenderer/VulkanBindlessTextures.h"
+#include "TextureMipGenerator.h"
+#include "TextureCompressor.h"
+#include "TextureContainer.h"
+#include "../Core/MappedFile.h"
 #include "../EngineHeader.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 //---------------------------------------------------------------------------------------------------------------------
-VulkanTexture::VulkanTexture(): m_iTextureWidth(0), m_iTextureHeight(0), m_iTextureChannels(0), m_vkTextureDeviceSize(0)
+VulkanTexture::VulkanTexture(): m_iTextureWidth(0), m_iTextureHeight(0), m_iTextureChannels(0), m_uiMipLevels(1), m_vkTextureDeviceSize(0)
 {
 	m_pImage = nullptr;
+	m_uiBindlessIndex = VulkanBindlessTextures::InvalidIndex;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -21,14 +28,19 @@ VulkanTexture::~VulkanTexture()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanTexture::CreateTexture(const VulkanDevice* pDevice, const std::string& filename, vk::Format format)
+bool VulkanTexture::CreateTexture(const VulkanDevice* pDevice, const std::string& filename, vk::Format format, const TextureSamplerDesc& samplerDesc)
 {
 	m_pImage = new UT::VkStructs::VulkanImage();
 
 	CHECK(CreateImage(pDevice, filename, format));
 
 	// Create Sampler
-	CHECK(CreateTextureSampler(pDevice));
+	CHECK(CreateTextureSampler(pDevice, samplerDesc));
+
+	// Slot in global texture table, materials refer to us by it. Upload might still be in flight, but nobody samples
+	// it before the material reports upload complete!
+	m_uiBindlessIndex = pDevice->GetBindlessTextures()->Register(getVkImageView(), m_vkTextureSampler);
+	CHECK(m_uiBindlessIndex != VulkanBindlessTextures::InvalidIndex);
 
 	LOG_DEBUG("Created Vulkan Texture for {0}", filename);
 
@@ -40,7 +52,10 @@ void VulkanTexture::Cleanup(const VulkanDevice* pDevice)
 {
 	const vk::Device vkDevice = pDevice->GetDevice();
 
-	vkDevice.destroySampler(m_vkTextureSampler);
+	// Sampler belongs to device's sampler cache, not ours to destroy!
+	pDevice->GetBindlessTextures()->Unregister(m_uiBindlessIndex);
+	m_uiBindlessIndex = VulkanBindlessTextures::InvalidIndex;
+
 	m_pImage->DestroyAll(vkDevice);
 }
 
@@ -49,6 +64,18 @@ void VulkanTexture::CleanupOnWindowResize(const VulkanDevice* pDevice)
 {
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTexture::IsUploadComplete(const VulkanDevice* pDevice) const
+{
+	return pDevice->IsUploadComplete(m_UploadTicket);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTexture::WaitForUpload(const VulkanDevice* pDevice) const
+{
+	pDevice->WaitForUpload(m_UploadTicket);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 unsigned char* VulkanTexture::LoadImageData(const std::string& filename)
 {
@@ -71,74 +98,211 @@ unsigned char* VulkanTexture::LoadImageData(const std::string& filename)
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanTexture::CreateImage(const VulkanDevice* pDevice, const std::string& filename, vk::Format format)
 {
+	// Containers are GPU ready already, their own format wins over the requested one!
+	if (TextureContainer::IsContainerFile(filename))
+		return CreateContainerImage(pDevice, filename);
+
+	// Block compressed textures come pre-baked from disk cache, no decode!
+	if (TextureCompressor::IsBlockCompressed(format))
+		return CreateCompressedImage(pDevice, filename, format);
+
 	// Load image data!
 	stbi_uc* imgData = LoadImageData(filename);
-	
-	// Create staging buffer to hold the loaded data, ready to copy to device
-	UT::VkStructs::VulkanBuffer stagingBuffer;
+	if (!imgData)
+		return false;
 
-	pDevice->CreateBuffer(m_vkTextureDeviceSize,
-						  vk::BufferUsageFlagBits::eTransferSrc,
-						  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-						  &stagingBuffer);
 
-	// Grab vk::Device handle!
-	const vk::Device vkDevice = pDevice->GetDevice();
+	// Full mip chain, down to 1x1
+	m_uiMipLevels = TextureMipGenerator::GetMipLevelCount(m_iTextureWidth, m_iTextureHeight);
+
+	// GPU builds mips with linear blits if format allows, otherwise we filter them on CPU & upload the whole chain
+	const bool bBlitMips = pDevice->SupportsLinearBlit(format);
+
+	vk::ImageUsageFlags usageFlags = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+	if (bBlitMips)
+		usageFlags |= vk::ImageUsageFlagBits::eTransferSrc;
+
+	// Create Image...
+	if (!pDevice->CreateImage2D(m_iTextureWidth, 
+								m_iTextureHeight,
+								format, 
+								vk::ImageTiling::eOptimal,
+								usageFlags,
+								vk::MemoryPropertyFlagBits::eDeviceLocal,
+								vk::ImageAspectFlagBits::eColor,
+								m_pImage,
+								m_uiMipLevels))
+	{
+		stbi_image_free(imgData);
+		return false;
+	}
+
+	// Copy pixels into staging ring & record layout transitions + copy, submitted with the next flush!
+	if (bBlitMips)
+	{
+		m_UploadTicket = pDevice->UploadToImage(imgData, m_vkTextureDeviceSize, *m_pImage, true);
+	}
+	else
+	{
+		// Pixels are always decoded as RGBA8, only colour space differs
+		const MipFilterFormat filterFormat = (format == vk::Format::eR8G8B8A8Srgb) ? MipFilterFormat::MIP_FORMAT_RGBA8_SRGB
+																				   : MipFilterFormat::MIP_FORMAT_RGBA8_UNORM;
 
-	// Copy image data to staging buffer
-	void* data;
-	vkMapMemory(vkDevice, stagingBuffer.deviceMemory, 0, m_vkTextureDeviceSize, 0, &data);
-	memcpy(data, imgData, static_cast<uint32_t>(m_vkTextureDeviceSize));
-	vkUnmapMemory(vkDevice, stagingBuffer.deviceMemory);
+		std::vector<uint8_t> mipChain;
+		TextureMipGenerator::GenerateMipChain(imgData, m_iTextureWidth, m_iTextureHeight, m_uiMipLevels, filterFormat, &mipChain);
+
+		m_UploadTicket = pDevice->UploadToImage(mipChain.data(), mipChain.size(), *m_pImage, false);
+	}
 
 	// Free original image data
 	stbi_image_free(imgData);
 
-	// Create Image...
-	pDevice->CreateImage2D(	m_iTextureWidth, 
-							m_iTextureHeight,
-							format, 
-							vk::ImageTiling::eOptimal,
-							vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-							vk::MemoryPropertyFlagBits::eDeviceLocal,
-							vk::ImageAspectFlagBits::eColor,
-							m_pImage);
+	return true;
+}
 
-	// Transition image to be DST for copy operation
-	pDevice->TransitionImageLayout(m_pImage->image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_NULL_HANDLE);
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTexture::CreateContainerImage(const VulkanDevice* pDevice, const std::string& filename)
+{
+	// Pre-baked DDS/KTX2 : map it, parse headers & copy levels straight from the mapping into staging ring
+	MappedFile mappedFile;
+	if (!mappedFile.Open(filename))
+	{
+		LOG_ERROR("Failed to open texture container {0}", filename);
+		return false;
+	}
 
-	// COPY DATA TO IMAGE!
-	pDevice->CopyBufferToImage(stagingBuffer.buffer, m_pImage->extent.width, m_pImage->extent.height, &(m_pImage->image));
+	TextureContainerView textureView;
+	CHECK(TextureContainer::Parse(mappedFile.GetData(), mappedFile.GetSize(), filename, &textureView));
 
-	// Transition image to be Shader Readable for shader usage
-	pDevice->TransitionImageLayout(m_pImage->image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, VK_NULL_HANDLE);
+	// mapping can go away as soon as this returns, ring has its own copy by then!
+	return CreateImageFromView(pDevice, textureView);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTexture::CreateCompressedImage(const VulkanDevice* pDevice, const std::string& filename, vk::Format format)
+{
+	const std::string cachePath = TextureCompressor::GetCachePath(filename, format);
 
-	// Destroy staging buffers
-	stagingBuffer.DestroyAll(vkDevice);
+	// Cache is valid if it exists, is newer than the source & holds the format we want...
+	std::error_code errorCode;
+	const bool bCacheExists = std::filesystem::exists(cachePath, errorCode);
+	const bool bCacheStale = bCacheExists && std::filesystem::exists(filename, errorCode) &&
+							 std::filesystem::last_write_time(filename, errorCode) > std::filesystem::last_write_time(cachePath, errorCode);
+
+	if (bCacheExists && !bCacheStale)
+	{
+		MappedFile mappedFile;
+		TextureContainerView textureView;
+
+		const bool bCacheValid = mappedFile.Open(cachePath) &&
+								 TextureContainer::Parse(mappedFile.GetData(), mappedFile.GetSize(), cachePath, &textureView) &&
+								 TextureContainer::ToDXGIFormat(textureView.format) == TextureContainer::ToDXGIFormat(format);
+
+		if (bCacheValid)
+			return CreateImageFromView(pDevice, textureView);
+	}
+
+	// ...otherwise decode the source once & bake it, next launch maps blocks straight from disk
+	TextureContainerData textureData;
+	CHECK(CompressToCache(filename, cachePath, format, &textureData));
+
+	TextureContainerView textureView;
+	TextureContainer::GetView(textureData, &textureView);
+
+	return CreateImageFromView(pDevice, textureView);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTexture::CreateImageFromView(const VulkanDevice* pDevice, const TextureContainerView& textureView)
+{
+	m_iTextureWidth = static_cast<int>(textureView.width);
+	m_iTextureHeight = static_cast<int>(textureView.height);
+	m_uiMipLevels = textureView.mipLevels;
+
+	m_vkTextureDeviceSize = 0;
+	for (uint32_t mip = 0; mip < m_uiMipLevels; ++mip)
+	{
+		m_vkTextureDeviceSize += UT::VkUtility::GetImageLevelSize(textureView.format, textureView.width, textureView.height, mip);
+	}
+
+	// Container formats can't be blit destinations (blocks) or already have their mips, every level comes from data
+	CHECK(pDevice->CreateImage2D(m_iTextureWidth,
+								 m_iTextureHeight,
+								 textureView.format,
+								 vk::ImageTiling::eOptimal,
+								 vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+								 vk::MemoryPropertyFlagBits::eDeviceLocal,
+								 vk::ImageAspectFlagBits::eColor,
+								 m_pImage,
+								 m_uiMipLevels));
+
+	m_UploadTicket = pDevice->UploadImageLevels(textureView.listLevelData.data(), *m_pImage);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTexture::CompressToCache(const std::string& filename, const std::string& cachePath, vk::Format format, TextureContainerData* pOutData)
+{
+	stbi_uc* imgData = LoadImageData(filename);
+	if (!imgData)
+		return false;
+
+	const uint32_t width = static_cast<uint32_t>(m_iTextureWidth);
+	const uint32_t height = static_cast<uint32_t>(m_iTextureHeight);
+	const uint32_t mipLevels = TextureMipGenerator::GetMipLevelCount(width, height);
+
+	// Mips are filtered before compression, blocks can't be blitted
+	const bool bSRGB = (format == vk::Format::eBc1RgbSrgbBlock || format == vk::Format::eBc1RgbaSrgbBlock || format == vk::Format::eBc3SrgbBlock);
+
+	std::vector<uint8_t> mipChain;
+	const bool bMipsGenerated = TextureMipGenerator::GenerateMipChain(imgData, width, height, mipLevels,
+																	  bSRGB ? MipFilterFormat::MIP_FORMAT_RGBA8_SRGB : MipFilterFormat::MIP_FORMAT_RGBA8_UNORM,
+																	  &mipChain);
+	stbi_image_free(imgData);
+	CHECK(bMipsGenerated);
+
+	pOutData->format = format;
+	pOutData->width = width;
+	pOutData->height = height;
+	pOutData->mipLevels = mipLevels;
+
+	CHECK(TextureCompressor::CompressMipChain(mipChain.data(), width, height, mipLevels, format, &pOutData->data));
+
+	// Failing to write the cache only costs us the encode next time, texture itself is fine
+	if (!TextureContainer::WriteDDS(cachePath, *pOutData))
+	{
+		LOG_WARNING("Could not write texture cache {0}", cachePath);
+	}
+	else
+	{
+		LOG_DEBUG("Baked {0} into {1}", filename, cachePath);
+	}
 
 	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanTexture::CreateTextureSampler(const VulkanDevice* pDevice)
+bool VulkanTexture::CreateTextureSampler(const VulkanDevice* pDevice, const TextureSamplerDesc& samplerDesc)
 {
 	//-- Sampler creation Info
 	vk::SamplerCreateInfo samplerCreateInfo = {};
-	samplerCreateInfo.magFilter = vk::Filter::eLinear;							// how to render when image is magnified on screen
-	samplerCreateInfo.minFilter = vk::Filter::eLinear;							// how to render when image is minified on screen			
-	samplerCreateInfo.addressModeU = vk::SamplerAddressMode::eRepeat;			// how to handle texture wrap in U (x) direction
-	samplerCreateInfo.addressModeV = vk::SamplerAddressMode::eRepeat;			// how to handle texture wrap in V (y) direction
-	samplerCreateInfo.addressModeW = vk::SamplerAddressMode::eRepeat;			// how to handle texture wrap in W (z) direction
+	samplerCreateInfo.magFilter = samplerDesc.filter;							// how to render when image is magnified on screen
+	samplerCreateInfo.minFilter = samplerDesc.filter;							// how to render when image is minified on screen			
+	samplerCreateInfo.addressModeU = samplerDesc.addressMode;					// how to handle texture wrap in U (x) direction
+	samplerCreateInfo.addressModeV = samplerDesc.addressMode;					// how to handle texture wrap in V (y) direction
+	samplerCreateInfo.addressModeW = samplerDesc.addressMode;					// how to handle texture wrap in W (z) direction
 	samplerCreateInfo.borderColor = vk::BorderColor::eIntOpaqueBlack;			// border beyond texture (only works for border clamp)
 	samplerCreateInfo.unnormalizedCoordinates = false;						// whether values of texture coords between [0,1] i.e. normalized
 	samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;				// Mipmap interpolation mode
 	samplerCreateInfo.mipLodBias = 0.0f;										// Level of detail bias for mip level
 	samplerCreateInfo.minLod = 0.0f;											// minimum level of detail to pick mip level
-	samplerCreateInfo.maxLod = 0.0f;											// maximum level of detail to pick mip level
-	samplerCreateInfo.anisotropyEnable = true;								// Enable Anisotropy or not? Check physical device features to see if anisotropy is supported or not!
+	samplerCreateInfo.maxLod = static_cast<float>(m_uiMipLevels);				// maximum level of detail to pick mip level
+	samplerCreateInfo.anisotropyEnable = samplerDesc.bAnisotropy;				// Enable Anisotropy or not? Check physical device features to see if anisotropy is supported or not!
 	samplerCreateInfo.maxAnisotropy = 16;										// Anisotropy sample level
 
-	m_vkTextureSampler = pDevice->GetDevice().createSampler(samplerCreateInfo);
+	// Every texture with same settings shares one sampler object
+	m_vkTextureSampler = pDevice->GetSamplerCache()->GetSampler(samplerCreateInfo);
 
 	return true;
 }
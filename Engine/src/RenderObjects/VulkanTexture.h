@@ -4,6 +4,30 @@
 
 class VulkanDevice;
 enum class TextureType;
+struct TextureContainerData;
+struct TextureContainerView;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sampler state a texture gets created with. Part of the texture cache key, same file sampled differently is a
+// different texture!
+struct TextureSamplerDesc
+{
+	TextureSamplerDesc()
+	{
+		filter = vk::Filter::eLinear;
+		addressMode = vk::SamplerAddressMode::eRepeat;
+		bAnisotropy = true;
+	}
+
+	vk::Filter					filter;
+	vk::SamplerAddressMode		addressMode;
+	bool						bAnisotropy;
+
+	inline bool operator<(const TextureSamplerDesc& other) const
+	{
+		return std::tie(filter, addressMode, bAnisotropy) < std::tie(other.filter, other.addressMode, other.bAnisotropy);
+	}
+};
 
 //---------------------------------------------------------------------------------------------------------------------
 class UT_API VulkanTexture
@@ -12,7 +36,7 @@ public:
 	VulkanTexture();
 	~VulkanTexture();
 
-	bool						CreateTexture(const VulkanDevice* pDevice, const std::string& filename, vk::Format format);
+	bool						CreateTexture(const VulkanDevice* pDevice, const std::string& filename, vk::Format format, const TextureSamplerDesc& samplerDesc = TextureSamplerDesc());
 	void						Cleanup(const VulkanDevice* pDevice);
 	void						CleanupOnWindowResize(const VulkanDevice* pDevice);
 
@@ -30,6 +54,11 @@ public:
 	}
 
 	inline vk::Sampler			getVkSampler()	 const	{ return m_vkTextureSampler; }
+	inline uint32_t				getMipLevels()	 const	{ return m_uiMipLevels; }
+	inline uint32_t				getBindlessIndex() const { return m_uiBindlessIndex; }
+
+	bool						IsUploadComplete(const VulkanDevice* pDevice) const;
+	void						WaitForUpload(const VulkanDevice* pDevice) const;		// main thread only, may flush staging ring!
 
 private:
 	UT::VkStructs::VulkanImage*	m_pImage;
@@ -38,11 +67,18 @@ private:
 private:						
 	unsigned char*				LoadImageData(const std::string& filename);
 	bool						CreateImage(const VulkanDevice* pDevice, const std::string& filename, vk::Format format);
-	bool						CreateTextureSampler(const VulkanDevice* pDevice);
+	bool						CreateContainerImage(const VulkanDevice* pDevice, const std::string& filename);
+	bool						CreateCompressedImage(const VulkanDevice* pDevice, const std::string& filename, vk::Format format);
+	bool						CompressToCache(const std::string& filename, const std::string& cachePath, vk::Format format, TextureContainerData* pOutData);
+	bool						CreateImageFromView(const VulkanDevice* pDevice, const TextureContainerView& textureView);
+	bool						CreateTextureSampler(const VulkanDevice* pDevice, const TextureSamplerDesc& samplerDesc);
 								
 	int							m_iTextureWidth;
 	int							m_iTextureHeight;
 	int							m_iTextureChannels;
+	uint32_t					m_uiMipLevels;
 	vk::DeviceSize				m_vkTextureDeviceSize;
+	uint32_t					m_uiBindlessIndex;			// slot in device's bindless texture table
+	UT::VkStructs::UploadTicket	m_UploadTicket;
 };
 
@@ -0,0 +1,159 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanTextureCache.h"
+#include "../VulkanRenderer/VulkanDevice.h"
+#include "../Core/JobSystem.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanTextureCache::VulkanTextureCache()
+{
+	m_pDevice = nullptr;
+	m_mapTextures.clear();
+	m_umapTextureKeys.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanTextureCache::~VulkanTextureCache()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanTextureCache::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTextureCache::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Whatever is still here was never released by its material!
+	for (std::pair<const CacheKey, CacheEntry>& entry : m_mapTextures)
+	{
+		LOG_WARNING("Texture cache : {0} still has {1} reference(s) at cleanup", entry.first.filePath, entry.second.refCount);
+
+		entry.second.pTexture->Cleanup(m_pDevice);
+		SAFE_DELETE(entry.second.pTexture);
+	}
+
+	m_mapTextures.clear();
+	m_umapTextureKeys.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanTexture* VulkanTextureCache::Acquire(const std::string& filePath, vk::Format format, const TextureSamplerDesc& samplerDesc)
+{
+	CacheKey key;
+	key.filePath = filePath;
+	key.format = format;
+	key.samplerDesc = samplerDesc;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	std::map<CacheKey, CacheEntry>::iterator iter = m_mapTextures.find(key);
+	if (iter != m_mapTextures.end())
+	{
+		// Someone else is creating it right now, wait till it's done (or failed & got removed)
+		m_cvTextureLoaded.wait(lock, [&]()
+		{
+			iter = m_mapTextures.find(key);
+			return iter == m_mapTextures.end() || iter->second.bLoaded;
+		});
+
+		if (iter == m_mapTextures.end())
+			return nullptr;
+
+		++iter->second.refCount;
+		return iter->second.pTexture;
+	}
+
+	// Not in cache, reserve the entry so that others wait for us & create texture outside the lock!
+	CacheEntry newEntry;
+	newEntry.pTexture = new VulkanTexture();
+	newEntry.refCount = 1;
+	newEntry.bLoaded = false;
+
+	VulkanTexture* pTexture = newEntry.pTexture;
+	m_mapTextures.emplace(key, newEntry);
+
+	lock.unlock();
+	const bool bCreated = pTexture->CreateTexture(m_pDevice, filePath, format, samplerDesc);
+	lock.lock();
+
+	if (bCreated)
+	{
+		m_mapTextures[key].bLoaded = true;
+		m_umapTextureKeys.emplace(pTexture, key);
+	}
+	else
+	{
+		LOG_ERROR("Texture cache : failed to create {0}", filePath);
+
+		m_mapTextures.erase(key);
+	}
+
+	lock.unlock();
+	m_cvTextureLoaded.notify_all();
+
+	if (!bCreated)
+	{
+		// Image, its view & memory might already exist with an upload in flight (e.g. bindless table was full). They
+		// can only go once the upload is done & only main thread may wait on it, waiting flushes the staging ring!
+		const VulkanDevice* pDevice = m_pDevice;
+		const std::function<void()> destroyTexture = [pDevice, pTexture]() mutable
+		{
+			pTexture->WaitForUpload(pDevice);
+			pTexture->Cleanup(pDevice);
+			SAFE_DELETE(pTexture);
+		};
+
+		if (JobSystem::getInstance().IsMainThread())
+			destroyTexture();
+		else
+			JobSystem::getInstance().RunOnMainThread(destroyTexture);
+
+		return nullptr;
+	}
+
+	return pTexture;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanTextureCache::Release(VulkanTexture* pTexture)
+{
+	if (pTexture == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const std::unordered_map<VulkanTexture*, CacheKey>::iterator keyIter = m_umapTextureKeys.find(pTexture);
+	if (keyIter == m_umapTextureKeys.end())
+	{
+		LOG_ERROR("Texture cache : releasing a texture which isn't in cache!");
+		return;
+	}
+
+	const std::map<CacheKey, CacheEntry>::iterator iter = m_mapTextures.find(keyIter->second);
+	if (--iter->second.refCount > 0)
+		return;
+
+	// Last user is gone. Callers release at cleanup time, after GPU is done with the texture!
+	LOG_DEBUG("Texture cache : destroying {0}", iter->first.filePath);
+
+	iter->second.pTexture->Cleanup(m_pDevice);
+	SAFE_DELETE(iter->second.pTexture);
+
+	m_mapTextures.erase(iter);
+	m_umapTextureKeys.erase(keyIter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanTextureCache::GetTextureCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return static_cast<uint32_t>(m_mapTextures.size());
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "VulkanTexture.h"
+
+#include <mutex>
+#include <condition_variable>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reference counted textures, keyed by file path + format + sampler state. Every material asking for the same file
+// gets the same VulkanTexture, so it's decoded, staged & stored on GPU only once.
+//
+// Acquire() can be called from asset loader threads. If another thread is already creating the requested texture,
+// caller waits for it instead of creating its own copy.
+class UT_API VulkanTextureCache
+{
+public:
+	VulkanTextureCache();
+	~VulkanTextureCache();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	VulkanTexture*						Acquire(const std::string& filePath, vk::Format format, const TextureSamplerDesc& samplerDesc = TextureSamplerDesc());
+	void								Release(VulkanTexture* pTexture);
+
+	uint32_t							GetTextureCount() const;
+
+private:
+	struct CacheKey
+	{
+		std::string						filePath;
+		vk::Format						format;
+		TextureSamplerDesc				samplerDesc;
+
+		inline bool operator<(const CacheKey& other) const
+		{
+			return std::tie(filePath, format, samplerDesc) < std::tie(other.filePath, other.format, other.samplerDesc);
+		}
+	};
+
+	struct CacheEntry
+	{
+		VulkanTexture*					pTexture;
+		uint32_t						refCount;
+		bool							bLoaded;			// false while creating thread is still decoding/staging
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	std::map<CacheKey, CacheEntry>		m_mapTextures;
+	std::unordered_map<VulkanTexture*, CacheKey>	m_umapTextureKeys;
+
+	mutable std::mutex					m_Mutex;
+	std::condition_variable				m_cvTextureLoaded;
+};
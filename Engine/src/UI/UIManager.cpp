@@ -1,5 +1,6 @@
 #include "UltimateEnginePCH.h"
 #include "../VulkanRenderer/VulkanDevice.h"
+#include "../VulkanRenderer/VulkanDescriptorAllocator.h"
 #include "UIManager.h"
 
 #include "vulkan/vulkan.hpp"
@@ -27,33 +28,17 @@ UIManager::~UIManager()
 //---------------------------------------------------------------------------------------------------------------------
 bool UIManager::Initialize(const GLFWwindow* pWindow, vk::Instance vkInstance, vk::RenderPass renderPass, const VulkanDevice* pDevice)
 {
-	// create descriptor pool for imgui
-	// the size of the pool is oversized, but it's copied from the demo!
-	constexpr vk::DescriptorPoolSize poolSizes[] =
+	// imgui backend wants a pool of its own. It only ever allocates combined image samplers (font atlas & textures
+	// added for display), so pool is sized for that instead of demo's 1000 of every type. Allocator destroys it!
+	const std::vector<vk::DescriptorPoolSize> listPoolSizes =
 	{
-		{vk::DescriptorType::eSampler, 1000},
-		{vk::DescriptorType::eCombinedImageSampler, 1000},
-		{vk::DescriptorType::eSampledImage, 1000},
-		{vk::DescriptorType::eStorageImage, 1000},
-		{vk::DescriptorType::eUniformTexelBuffer, 1000},
-		{vk::DescriptorType::eStorageTexelBuffer, 1000},
-		{vk::DescriptorType::eUniformBuffer, 1000},
-		{vk::DescriptorType::eStorageBuffer, 1000},
-		{vk::DescriptorType::eUniformBufferDynamic, 1000},
-		{vk::DescriptorType::eStorageBufferDynamic, 1000},
-		{vk::DescriptorType::eInputAttachment, 1000}
+		{ vk::DescriptorType::eCombinedImageSampler, 64 }
 	};
 
-	vk::DescriptorPoolCreateInfo poolInfo = {};
-	poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
-	poolInfo.maxSets = 1000;
-	poolInfo.poolSizeCount = static_cast<uint32_t>(std::size(poolSizes));
-	poolInfo.pPoolSizes = poolSizes;
-
 	const vk::Device vkDevice = pDevice->GetDevice();
 	const vk::PhysicalDevice vkPhysicalDevice = pDevice->GetPhysicalDevice();
 
-	const VkDescriptorPool imguiPool = vkDevice.createDescriptorPool(poolInfo);
+	const VkDescriptorPool imguiPool = pDevice->GetDescriptorAllocator()->CreateExternalPool(listPoolSizes, 64, vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
 
 	// Initialize imgui library
 	IMGUI_CHECKVERSION();
@@ -77,8 +62,8 @@ bool UIManager::Initialize(const GLFWwindow* pWindow, vk::Instance vkInstance, v
 	initInfo.Device = vkDevice;
 	initInfo.Queue = pDevice->GetGraphicsQueue();
 	initInfo.DescriptorPool = imguiPool;
-	initInfo.MinImageCount = pDevice->GetSwapchainImageCount();
-	initInfo.ImageCount = pDevice->GetSwapchainImageCount();
+	initInfo.MinImageCount = pDevice->GetFrameCount();
+	initInfo.ImageCount = pDevice->GetFrameCount();			// imgui cycles its buffers per frame in flight, like we do
 	initInfo.MSAASamples = vk::SampleCountFlagBits::e1;
 	initInfo.CheckVkResultFn = nullptr;
 
@@ -87,7 +72,10 @@ bool UIManager::Initialize(const GLFWwindow* pWindow, vk::Instance vkInstance, v
 	// execute GPU commands to upload imgui fonts to textures
 	const VkCommandBuffer cmdBuffer = pDevice->BeginTransferCommandBuffer();
 	ImGui_ImplVulkan_CreateFontsTexture(cmdBuffer);
-	pDevice->EndAndSubmitTransferCommandBuffer(cmdBuffer);
+	const UT::VkStructs::UploadTicket fontTicket = pDevice->EndAndSubmitTransferCommandBuffer(cmdBuffer);
+
+	// upload buffer is owned by imgui, has to stay alive until GPU is done with it!
+	pDevice->WaitForUpload(fontTicket);
 
 	// clear fonts from the cpu memory!
 	ImGui_ImplVulkan_DestroyFontUploadObjects();
@@ -111,10 +99,16 @@ void UIManager::BeginRender()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void UIManager::EndRender(const VulkanDevice* pDevice, uint32_t imageIndex)
+void UIManager::EndRender()
 {
+	// Draw data stays valid till next BeginRender(), it's recorded later in the frame
 	ImGui::Render();
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(),  pDevice->GetGraphicsCommandBuffer(imageIndex));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void UIManager::RecordDrawData(vk::CommandBuffer cmdBuffer)
+{
+	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuffer);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
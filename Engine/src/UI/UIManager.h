@@ -14,7 +14,8 @@ public:
 
 	void			HandleWindowResize();
 	void			BeginRender();
-	void			EndRender(const VulkanDevice* pDevice, uint32_t imageIndex);
+	void			EndRender();
+	void			RecordDrawData(vk::CommandBuffer cmdBuffer);
 	void			Render(Scene* pScene);
 };
 
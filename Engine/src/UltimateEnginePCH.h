@@ -19,6 +19,7 @@
 #include <tuple>
 #include <array>
 #include <list>
+#include <bitset>
 
 
 #ifdef UT_PLATFORM_WINDOWS
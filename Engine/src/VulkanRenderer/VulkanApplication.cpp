@@ -221,7 +221,7 @@ bool VulkanApplication::RunShaderCompiler(const std::string& directoryPath)
 		for (const auto& entry : std::filesystem::directory_iterator(directoryPath))
 		{
 			if (entry.is_regular_file() &&
-			   (entry.path().extension().string() == ".vert" || entry.path().extension().string() == ".frag") || 
+			   (entry.path().extension().string() == ".vert" || entry.path().extension().string() == ".frag" || entry.path().extension().string() == ".comp") || 
 			    entry.path().extension().string() == ".rchit" || entry.path().extension().string() == ".rmiss" || entry.path().extension().string() == ".rgen")
 			{
 				std::string cmd = compilerPath.string() + " --target-env=vulkan1.3" + " -c" + " " + entry.path().string() + " -o " + entry.path().string() + ".spv";
@@ -0,0 +1,170 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanBindlessTextures.h"
+#include "VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanBindlessTextures::VulkanBindlessTextures()
+{
+	m_pDevice = nullptr;
+	m_vkDescriptorSetLayout = nullptr;
+	m_vkDescriptorPool = nullptr;
+	m_vkDescriptorSet = nullptr;
+	m_uiMaxTextures = 0;
+	m_uiNextIndex = 0;
+
+	m_ListFreeIndices.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanBindlessTextures::~VulkanBindlessTextures()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanBindlessTextures::Initialize(const VulkanDevice* pDevice, uint32_t maxTextures)
+{
+	m_pDevice = pDevice;
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// Combined image samplers count against both sampler & sampled image limits of update-after-bind sets
+	const auto properties = m_pDevice->GetPhysicalDevice().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+	const vk::PhysicalDeviceVulkan12Properties& properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+
+	m_uiMaxTextures = std::min({ maxTextures,
+								 properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+								 properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+								 properties12.maxDescriptorSetUpdateAfterBindSamplers,
+								 properties12.maxDescriptorSetUpdateAfterBindSampledImages });
+
+	CHECK_LOG(m_uiMaxTextures > 0, "Device can't do update-after-bind textures!");
+
+	// Slots are filled as textures come & go, shader must only index slots its material points to
+	vk::DescriptorSetLayoutBinding layoutBinding = {};
+	layoutBinding.binding = 0;
+	layoutBinding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	layoutBinding.descriptorCount = m_uiMaxTextures;
+	layoutBinding.stageFlags = vk::ShaderStageFlagBits::eFragment;
+	layoutBinding.pImmutableSamplers = nullptr;
+
+	const vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound |
+													vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+													vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {};
+	bindingFlagsCreateInfo.bindingCount = 1;
+	bindingFlagsCreateInfo.pBindingFlags = &bindingFlags;
+
+	// Layout cache can't key extended create infos, & there's only ever one of these anyway
+	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+	layoutCreateInfo.bindingCount = 1;
+	layoutCreateInfo.pBindings = &layoutBinding;
+	layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+
+	m_vkDescriptorSetLayout = vkDevice.createDescriptorSetLayout(layoutCreateInfo);
+
+	// Update-after-bind sets need a pool of their own kind
+	vk::DescriptorPoolSize poolSize = {};
+	poolSize.type = vk::DescriptorType::eCombinedImageSampler;
+	poolSize.descriptorCount = m_uiMaxTextures;
+
+	vk::DescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	m_vkDescriptorPool = vkDevice.createDescriptorPool(poolCreateInfo);
+
+	vk::DescriptorSetAllocateInfo setAllocInfo = {};
+	setAllocInfo.descriptorPool = m_vkDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &m_vkDescriptorSetLayout;
+
+	m_vkDescriptorSet = vkDevice.allocateDescriptorSets(setAllocInfo).front();
+
+	LOG_DEBUG("Bindless textures : {0} slots", m_uiMaxTextures);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanBindlessTextures::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// set goes away with the pool!
+	vkDevice.destroyDescriptorPool(m_vkDescriptorPool);
+	vkDevice.destroyDescriptorSetLayout(m_vkDescriptorSetLayout);
+
+	m_vkDescriptorPool = nullptr;
+	m_vkDescriptorSetLayout = nullptr;
+	m_vkDescriptorSet = nullptr;
+
+	m_ListFreeIndices.clear();
+	m_uiNextIndex = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanBindlessTextures::Register(vk::ImageView vkImageView, vk::Sampler vkSampler)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	uint32_t index = InvalidIndex;
+	if (!m_ListFreeIndices.empty())
+	{
+		index = m_ListFreeIndices.back();
+		m_ListFreeIndices.pop_back();
+	}
+	else if (m_uiNextIndex < m_uiMaxTextures)
+	{
+		index = m_uiNextIndex++;
+	}
+	else
+	{
+		LOG_ERROR("Bindless textures : all {0} slots taken!", m_uiMaxTextures);
+		return InvalidIndex;
+	}
+
+	// Slot isn't used by anything in flight, so it can be written while set is bound
+	vk::DescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	imageInfo.imageView = vkImageView;
+	imageInfo.sampler = vkSampler;
+
+	vk::WriteDescriptorSet writeSet = {};
+	writeSet.dstSet = m_vkDescriptorSet;
+	writeSet.dstBinding = 0;
+	writeSet.dstArrayElement = index;
+	writeSet.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	writeSet.descriptorCount = 1;
+	writeSet.pImageInfo = &imageInfo;
+
+	m_pDevice->GetDevice().updateDescriptorSets(writeSet, nullptr);
+
+	return index;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanBindlessTextures::Unregister(uint32_t index)
+{
+	if (index == InvalidIndex)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Descriptor stays as is, partially bound array doesn't care as long as nobody indexes it
+	m_ListFreeIndices.push_back(index);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanBindlessTextures::GetTextureCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return m_uiNextIndex - static_cast<uint32_t>(m_ListFreeIndices.size());
+}
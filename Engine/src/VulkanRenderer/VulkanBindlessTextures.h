@@ -0,0 +1,47 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Global table of every loaded texture : one descriptor set with a single, partially bound array of combined image
+// samplers (descriptor indexing, update-after-bind). Textures register themselves when created & materials only keep
+// their slot index, so a whole frame's draws share one texture set instead of binding one per object.
+//
+// Register() & Unregister() can be called from asset loader threads, even while the set is bound in pending command
+// buffers. Slot handed to Unregister() must no longer be used by any pending frame, it's reused by the next Register()!
+class UT_API VulkanBindlessTextures
+{
+public:
+	VulkanBindlessTextures();
+	~VulkanBindlessTextures();
+
+	bool								Initialize(const VulkanDevice* pDevice, uint32_t maxTextures);
+	void								Cleanup();
+
+	uint32_t							Register(vk::ImageView vkImageView, vk::Sampler vkSampler);
+	void								Unregister(uint32_t index);
+
+	inline vk::DescriptorSetLayout		GetDescriptorSetLayout() const					{ return m_vkDescriptorSetLayout; }
+	inline vk::DescriptorSet			GetDescriptorSet() const						{ return m_vkDescriptorSet; }
+	inline uint32_t						GetMaxTextures() const							{ return m_uiMaxTextures; }
+	uint32_t							GetTextureCount() const;
+
+	static constexpr uint32_t			InvalidIndex = 0xFFFFFFFF;
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	vk::DescriptorSetLayout				m_vkDescriptorSetLayout;
+	vk::DescriptorPool					m_vkDescriptorPool;
+	vk::DescriptorSet					m_vkDescriptorSet;
+
+	uint32_t							m_uiMaxTextures;
+	uint32_t							m_uiNextIndex;				// slots below this were handed out at least once
+	std::vector<uint32_t>				m_ListFreeIndices;
+
+	mutable std::mutex					m_Mutex;
+};
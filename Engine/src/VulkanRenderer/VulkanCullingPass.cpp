@@ -0,0 +1,474 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanCullingPass.h"
+#include "VulkanDevice.h"
+#include "VulkanUniformArena.h"
+#include "VulkanLayoutCache.h"
+#include "VulkanSamplerCache.h"
+#include "VulkanDescriptorAllocator.h"
+#include "../RenderObjects/VulkanMeshData.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanCullingPass::VulkanCullingPass()
+{
+	m_pDevice = nullptr;
+	m_vkCullSetLayout = nullptr;
+	m_vkHiZSetLayout = nullptr;
+	m_vkCullPipelineLayout = nullptr;
+	m_vkHiZPipelineLayout = nullptr;
+	m_vkCullPipeline = nullptr;
+	m_vkHiZPipeline = nullptr;
+	m_vkHiZSampler = nullptr;
+	m_vkDepthView = nullptr;
+	m_matHiZViewProjection = glm::mat4(1);
+	m_bHiZValid = false;
+
+	m_ListFrames.clear();
+	m_vkListHiZMipViews.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanCullingPass::~VulkanCullingPass()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCullingPass::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+
+	// Culling set : cull data, instances & draw bounds in arena, both outputs & the pyramid
+	std::vector<vk::DescriptorSetLayoutBinding> listCullBindings(6);
+	for (uint32_t i = 0; i < listCullBindings.size(); ++i)
+	{
+		listCullBindings[i].binding = i;
+		listCullBindings[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+		listCullBindings[i].descriptorCount = 1;
+		listCullBindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+	}
+
+	listCullBindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+	listCullBindings[5].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+
+	// Pyramid set : previous mip (or depth buffer) in, next mip out
+	std::vector<vk::DescriptorSetLayoutBinding> listHiZBindings(2);
+	listHiZBindings[0].binding = 0;
+	listHiZBindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	listHiZBindings[0].descriptorCount = 1;
+	listHiZBindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
+	listHiZBindings[1].binding = 1;
+	listHiZBindings[1].descriptorType = vk::DescriptorType::eStorageImage;
+	listHiZBindings[1].descriptorCount = 1;
+	listHiZBindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+	VulkanLayoutCache* pLayoutCache = m_pDevice->GetLayoutCache();
+	m_vkCullSetLayout = pLayoutCache->GetDescriptorSetLayout(listCullBindings);
+	m_vkHiZSetLayout = pLayoutCache->GetDescriptorSetLayout(listHiZBindings);
+	m_vkCullPipelineLayout = pLayoutCache->GetPipelineLayout({ m_vkCullSetLayout }, {});
+	m_vkHiZPipelineLayout = pLayoutCache->GetPipelineLayout({ m_vkHiZSetLayout }, {});
+
+	CHECK(CreateComputePipeline("Assets/Shaders/cull.comp.spv", m_vkCullPipelineLayout, &m_vkCullPipeline));
+	CHECK(CreateComputePipeline("Assets/Shaders/hiz.comp.spv", m_vkHiZPipelineLayout, &m_vkHiZPipeline));
+
+	// Both shaders texelFetch, sampler is only there because combined image samplers need one
+	vk::SamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.magFilter = vk::Filter::eNearest;
+	samplerCreateInfo.minFilter = vk::Filter::eNearest;
+	samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+	samplerCreateInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+	samplerCreateInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+	samplerCreateInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	m_vkHiZSampler = m_pDevice->GetSamplerCache()->GetSampler(samplerCreateInfo);
+
+	LOG_DEBUG("Culling pass initialized!");
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::Cleanup()
+{
+	DestroyHiZ();
+	DestroyFrames();
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+	vkDevice.destroyPipeline(m_vkCullPipeline);
+	vkDevice.destroyPipeline(m_vkHiZPipeline);
+
+	// Layouts belong to layout cache & sampler to sampler cache!
+	m_vkCullPipeline = nullptr;
+	m_vkHiZPipeline = nullptr;
+	m_vkCullSetLayout = nullptr;
+	m_vkHiZSetLayout = nullptr;
+	m_vkCullPipelineLayout = nullptr;
+	m_vkHiZPipelineLayout = nullptr;
+	m_vkHiZSampler = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCullingPass::CreateFrames(uint32_t frameCount)
+{
+	// One frame per frame context, nothing to do if they already exist
+	if (m_ListFrames.size() == frameCount)
+		return true;
+
+	DestroyFrames();
+
+	m_ListFrames.resize(frameCount);
+
+	for (CullingFrame& frame : m_ListFrames)
+	{
+		// Written & read only by GPU
+		const bool bInstanceBuffer = m_pDevice->CreateBuffer(static_cast<vk::DeviceSize>(UT::VkGlobals::GMaxCulledInstances) * sizeof(InstanceData),
+															 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
+															 vk::MemoryPropertyFlagBits::eDeviceLocal,
+															 &frame.instanceBuffer);
+
+		const bool bDrawCommandBuffer = m_pDevice->CreateBuffer(static_cast<vk::DeviceSize>(UT::VkGlobals::GMaxCulledDraws) * sizeof(vk::DrawIndexedIndirectCommand),
+																vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+																vk::MemoryPropertyFlagBits::eDeviceLocal,
+																&frame.drawCommandBuffer);
+
+		CHECK_LOG(bInstanceBuffer && bDrawCommandBuffer, "Failed to create culling pass buffers!");
+	}
+
+	LOG_DEBUG("Culling pass : {0} frame(s), {1} instances & {2} draws each", frameCount, UT::VkGlobals::GMaxCulledInstances, UT::VkGlobals::GMaxCulledDraws);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::DestroyFrames()
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	for (CullingFrame& frame : m_ListFrames)
+	{
+		frame.instanceBuffer.DestroyAll(vkDevice);
+		frame.drawCommandBuffer.DestroyAll(vkDevice);
+	}
+
+	m_ListFrames.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCullingPass::CreateHiZ(vk::ImageView vkDepthView, const vk::Extent2D& extent)
+{
+	DestroyHiZ();
+
+	m_vkDepthView = vkDepthView;
+
+	// Mip 0 is a copy of depth buffer, every next one halves till 1x1
+	const uint32_t mipCount = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+
+	const bool bHiZImage = m_pDevice->CreateImage2D(extent.width, extent.height,
+													vk::Format::eR32Sfloat, vk::ImageTiling::eOptimal,
+													vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+													vk::MemoryPropertyFlagBits::eDeviceLocal,
+													vk::ImageAspectFlagBits::eColor,
+													&m_HiZImage, mipCount);
+
+	CHECK_LOG(bHiZImage, "Failed to create HiZ pyramid!");
+
+	// Whole chain view (m_HiZImage.imageView) is for culling, storage images need a view per mip
+	vk::ImageViewCreateInfo viewCreateInfo = {};
+	viewCreateInfo.image = m_HiZImage.image;
+	viewCreateInfo.viewType = vk::ImageViewType::e2D;
+	viewCreateInfo.format = vk::Format::eR32Sfloat;
+	viewCreateInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	viewCreateInfo.subresourceRange.levelCount = 1;
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	viewCreateInfo.subresourceRange.layerCount = 1;
+
+	m_vkListHiZMipViews.resize(mipCount);
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		viewCreateInfo.subresourceRange.baseMipLevel = mip;
+		m_vkListHiZMipViews[mip] = m_pDevice->GetDevice().createImageView(viewCreateInfo);
+	}
+
+	// Nothing in it yet, first frame culls against frustum only
+	m_bHiZValid = false;
+
+	LOG_DEBUG("HiZ pyramid : {0}x{1}, {2} mips", extent.width, extent.height, mipCount);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::DestroyHiZ()
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	for (vk::ImageView mipView : m_vkListHiZMipViews)
+	{
+		vkDevice.destroyImageView(mipView);
+	}
+
+	m_vkListHiZMipViews.clear();
+
+	if (m_HiZImage.image)
+	{
+		m_HiZImage.DestroyAll(vkDevice);
+		m_HiZImage = UT::VkStructs::VulkanImage();
+	}
+
+	m_vkDepthView = nullptr;
+	m_bHiZValid = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::RecordCulling(uint32_t frameIndex, const CullingPassInput& input)
+{
+	if (input.drawCount == 0 || input.instanceCount == 0)
+		return;
+
+	const vk::CommandBuffer cmdBuffer = m_pDevice->GetGraphicsCommandBuffer(frameIndex);
+	VulkanUniformArena* pUniformArena = m_pDevice->GetUniformArena();
+	const CullingFrame& frame = m_ListFrames[frameIndex];
+	const vk::Buffer arenaBuffer = pUniformArena->GetBuffer(frameIndex);
+
+	// Cull data goes in arena next to what scene packed
+	CullUniformData cullData;
+	ExtractFrustumPlanes(input.matViewProjection, cullData.frustumPlanes);
+	cullData.matHiZViewProjection = m_matHiZViewProjection;
+	cullData.hizSize = glm::vec4(m_HiZImage.extent.width, m_HiZImage.extent.height, m_vkListHiZMipViews.size(), m_bHiZValid ? 1.0f : 0.0f);
+	cullData.counts = glm::uvec4(input.instanceCount, input.drawCount, 0, 0);
+
+	uint32_t cullDataOffset = 0;
+	void* pCullData = pUniformArena->Allocate(sizeof(CullUniformData), &cullDataOffset);
+	if (!pCullData)
+	{
+		LOG_ERROR("Failed to pack cull uniform data!");
+		return;
+	}
+
+	memcpy(pCullData, &cullData, sizeof(CullUniformData));
+
+	// Draw table with zero instance counts becomes this frame's indirect buffer, cull.comp counts survivors into it
+	const vk::DeviceSize drawTableSize = static_cast<vk::DeviceSize>(input.drawCount) * sizeof(vk::DrawIndexedIndirectCommand);
+	const vk::BufferCopy copyRegion(input.drawCommandOffset, 0, drawTableSize);
+	cmdBuffer.copyBuffer(arenaBuffer, frame.drawCommandBuffer.buffer, copyRegion);
+
+	vk::BufferMemoryBarrier tableBarrier = {};
+	tableBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	tableBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	tableBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	tableBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	tableBarrier.buffer = frame.drawCommandBuffer.buffer;
+	tableBarrier.offset = 0;
+	tableBarrier.size = drawTableSize;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tableBarrier, nullptr);
+
+	// Pyramid isn't built yet, it's still bound (though never read) so it needs a layout shader can live with
+	if (!m_bHiZValid)
+	{
+		vk::ImageMemoryBarrier hizBarrier = {};
+		hizBarrier.oldLayout = vk::ImageLayout::eUndefined;
+		hizBarrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		hizBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hizBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hizBarrier.image = m_HiZImage.image;
+		hizBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, VK_REMAINING_MIP_LEVELS, 0, 1);
+		hizBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, hizBarrier);
+	}
+
+	// Set lives for this frame only, offsets change every frame anyway
+	const vk::DescriptorSet cullSet = m_pDevice->GetDescriptorAllocator()->AllocateTransient(m_vkCullSetLayout);
+	if (!cullSet)
+	{
+		LOG_ERROR("Failed to allocate culling pass descriptor set!");
+		return;
+	}
+
+	const std::array<vk::DescriptorBufferInfo, 5> bufferInfos =
+	{
+		vk::DescriptorBufferInfo(arenaBuffer, cullDataOffset, sizeof(CullUniformData)),
+		vk::DescriptorBufferInfo(arenaBuffer, input.instanceDataOffset, static_cast<vk::DeviceSize>(input.instanceCount) * sizeof(InstanceData)),
+		vk::DescriptorBufferInfo(arenaBuffer, input.drawBoundsOffset, static_cast<vk::DeviceSize>(input.drawCount) * sizeof(glm::vec4)),
+		vk::DescriptorBufferInfo(frame.instanceBuffer.buffer, 0, static_cast<vk::DeviceSize>(input.instanceCount) * sizeof(InstanceData)),
+		vk::DescriptorBufferInfo(frame.drawCommandBuffer.buffer, 0, drawTableSize)
+	};
+
+	const vk::DescriptorImageInfo hizInfo(m_vkHiZSampler, m_HiZImage.imageView, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	std::array<vk::WriteDescriptorSet, 6> writeSets = {};
+	for (uint32_t i = 0; i < writeSets.size(); ++i)
+	{
+		writeSets[i].dstSet = cullSet;
+		writeSets[i].dstBinding = i;
+		writeSets[i].dstArrayElement = 0;
+		writeSets[i].descriptorCount = 1;
+		writeSets[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+
+		if (i < bufferInfos.size())
+			writeSets[i].pBufferInfo = &bufferInfos[i];
+	}
+
+	writeSets[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+	writeSets[5].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	writeSets[5].pImageInfo = &hizInfo;
+
+	m_pDevice->GetDevice().updateDescriptorSets(writeSets, nullptr);
+
+	// A thread per instance
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_vkCullPipeline);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_vkCullPipelineLayout, 0, cullSet, nullptr);
+	cmdBuffer.dispatch((input.instanceCount + UT::VkGlobals::GCullWorkgroupSize - 1) / UT::VkGlobals::GCullWorkgroupSize, 1, 1);
+
+	// Forward pass reads counts as indirect commands & survivors as instance rate vertices
+	std::array<vk::BufferMemoryBarrier, 2> outputBarriers = {};
+	outputBarriers[0].srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+	outputBarriers[0].dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
+	outputBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarriers[0].buffer = frame.drawCommandBuffer.buffer;
+	outputBarriers[0].offset = 0;
+	outputBarriers[0].size = drawTableSize;
+
+	outputBarriers[1].srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+	outputBarriers[1].dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead;
+	outputBarriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarriers[1].buffer = frame.instanceBuffer.buffer;
+	outputBarriers[1].offset = 0;
+	outputBarriers[1].size = VK_WHOLE_SIZE;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+							  {}, nullptr, outputBarriers, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::RecordHiZBuild(uint32_t frameIndex, const glm::mat4& matViewProjection)
+{
+	const vk::CommandBuffer cmdBuffer = m_pDevice->GetGraphicsCommandBuffer(frameIndex);
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+	const uint32_t mipCount = static_cast<uint32_t>(m_vkListHiZMipViews.size());
+
+	// Whole pyramid is rewritten, old content can go. Culling read it earlier in this frame, so wait for that!
+	vk::ImageMemoryBarrier hizBarrier = {};
+	hizBarrier.srcAccessMask = vk::AccessFlagBits::eShaderRead;
+	hizBarrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+	hizBarrier.oldLayout = vk::ImageLayout::eUndefined;
+	hizBarrier.newLayout = vk::ImageLayout::eGeneral;
+	hizBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hizBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hizBarrier.image = m_HiZImage.image;
+	hizBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipCount, 0, 1);
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, hizBarrier);
+
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_vkHiZPipeline);
+
+	// Depth is already readable here, forward render pass leaves it read only & its dependency covers compute
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const vk::DescriptorSet hizSet = m_pDevice->GetDescriptorAllocator()->AllocateTransient(m_vkHiZSetLayout);
+		if (!hizSet)
+		{
+			LOG_ERROR("Failed to allocate HiZ descriptor set!");
+			return;
+		}
+
+		const vk::DescriptorImageInfo srcInfo = (mip == 0) ? vk::DescriptorImageInfo(m_vkHiZSampler, m_vkDepthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal)
+														   : vk::DescriptorImageInfo(m_vkHiZSampler, m_vkListHiZMipViews[mip - 1], vk::ImageLayout::eGeneral);
+		const vk::DescriptorImageInfo dstInfo(nullptr, m_vkListHiZMipViews[mip], vk::ImageLayout::eGeneral);
+
+		std::array<vk::WriteDescriptorSet, 2> writeSets = {};
+		writeSets[0].dstSet = hizSet;
+		writeSets[0].dstBinding = 0;
+		writeSets[0].descriptorCount = 1;
+		writeSets[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		writeSets[0].pImageInfo = &srcInfo;
+		writeSets[1].dstSet = hizSet;
+		writeSets[1].dstBinding = 1;
+		writeSets[1].descriptorCount = 1;
+		writeSets[1].descriptorType = vk::DescriptorType::eStorageImage;
+		writeSets[1].pImageInfo = &dstInfo;
+
+		vkDevice.updateDescriptorSets(writeSets, nullptr);
+
+		const uint32_t mipWidth = std::max(m_HiZImage.extent.width >> mip, 1u);
+		const uint32_t mipHeight = std::max(m_HiZImage.extent.height >> mip, 1u);
+
+		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_vkHiZPipelineLayout, 0, hizSet, nullptr);
+		cmdBuffer.dispatch((mipWidth + UT::VkGlobals::GHiZWorkgroupSize - 1) / UT::VkGlobals::GHiZWorkgroupSize,
+						   (mipHeight + UT::VkGlobals::GHiZWorkgroupSize - 1) / UT::VkGlobals::GHiZWorkgroupSize, 1);
+
+		// Next mip reads this one
+		vk::ImageMemoryBarrier mipBarrier = {};
+		mipBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		mipBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+		mipBarrier.oldLayout = vk::ImageLayout::eGeneral;
+		mipBarrier.newLayout = vk::ImageLayout::eGeneral;
+		mipBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		mipBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		mipBarrier.image = m_HiZImage.image;
+		mipBarrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1);
+
+		cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, mipBarrier);
+	}
+
+	// Ready for next frame's culling
+	hizBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+	hizBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+	hizBarrier.oldLayout = vk::ImageLayout::eGeneral;
+	hizBarrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, hizBarrier);
+
+	m_matHiZViewProjection = matViewProjection;
+	m_bHiZValid = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanCullingPass::CreateComputePipeline(const std::string& fileName, vk::PipelineLayout vkPipelineLayout, vk::Pipeline* pOutPipeline) const
+{
+	const vk::ShaderModule shaderModule = m_pDevice->CreateShaderModule(fileName);
+	CHECK(shaderModule);
+
+	vk::ComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+	pipelineCreateInfo.stage.module = shaderModule;
+	pipelineCreateInfo.stage.pName = "main";
+	pipelineCreateInfo.layout = vkPipelineLayout;
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+	vk::Result result;
+	std::tie(result, *pOutPipeline) = vkDevice.createComputePipeline(nullptr, pipelineCreateInfo);
+
+	vkDevice.destroyShaderModule(shaderModule);
+
+	if (result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Failed to create compute pipeline for {0}", fileName);
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanCullingPass::ExtractFrustumPlanes(const glm::mat4& matViewProjection, glm::vec4* pOutPlanes) const
+{
+	// Rows of view projection added to/subtracted from the last one (Gribb & Hartmann). glm is column major!
+	const glm::mat4 matRows = glm::transpose(matViewProjection);
+
+	pOutPlanes[0] = matRows[3] + matRows[0];		// left
+	pOutPlanes[1] = matRows[3] - matRows[0];		// right
+	pOutPlanes[2] = matRows[3] + matRows[1];		// bottom
+	pOutPlanes[3] = matRows[3] - matRows[1];		// top
+	pOutPlanes[4] = matRows[3] + matRows[2];		// near, -w <= z one is a bit behind 0 <= z one, so still conservative
+	pOutPlanes[5] = matRows[3] - matRows[2];		// far
+
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		pOutPlanes[i] /= glm::length(glm::vec3(pOutPlanes[i]));
+	}
+}
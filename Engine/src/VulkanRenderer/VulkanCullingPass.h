@@ -0,0 +1,107 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// What scene packed into this frame's uniform arena for the culling pass to chew on
+struct CullingPassInput
+{
+	CullingPassInput()
+	{
+		matViewProjection = glm::mat4(1);
+		instanceDataOffset = 0;
+		instanceCount = 0;
+		drawCommandOffset = 0;
+		drawBoundsOffset = 0;
+		drawCount = 0;
+	}
+
+	glm::mat4							matViewProjection;		// this frame's, frustum planes come out of it
+	uint32_t							instanceDataOffset;		// every ready instance, grouped by draw
+	uint32_t							instanceCount;
+	uint32_t							drawCommandOffset;		// draw table with zero instance counts
+	uint32_t							drawBoundsOffset;		// local bounding sphere of every draw's mesh
+	uint32_t							drawCount;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Packed into uniform arena every frame. Matches "CullData" block in cull.comp!
+struct CullUniformData
+{
+	CullUniformData()
+	{
+		for (glm::vec4& plane : frustumPlanes)
+			plane = glm::vec4(0);
+
+		matHiZViewProjection = glm::mat4(1);
+		hizSize = glm::vec4(0);
+		counts = glm::uvec4(0);
+	}
+
+	alignas(16) glm::vec4	frustumPlanes[6];			// normalized, xyz normal pointing inside & w distance
+	alignas(16) glm::mat4	matHiZViewProjection;		// previous frame's, pyramid's depth was rendered with it
+	alignas(16) glm::vec4	hizSize;					// width, height, mip count, 1 if pyramid can be tested against
+	alignas(16) glm::uvec4	counts;						// instance count, draw count
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// GPU culling. cull.comp tests every instance's bounding sphere against camera frustum & against a hierarchical-Z
+// pyramid of previous frame's depth, survivors are appended to their draw's range in this frame's instance buffer &
+// counted straight into the indirect draw table. Forward pass draws from those two buffers, so CPU never learns what's
+// visible & hidden objects cost a thread of compute instead of their vertices!
+//
+// Pyramid is built by hiz.comp after forward pass, a mip at a time, each texel keeps the farthest depth underneath it.
+// It lags a frame, so something coming out from behind an occluder shows up a frame late. After (re)creation there's
+// no pyramid yet & only frustum test runs.
+class UT_API VulkanCullingPass
+{
+public:
+	VulkanCullingPass();
+	~VulkanCullingPass();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	bool								CreateFrames(uint32_t frameCount);
+	void								DestroyFrames();
+
+	bool								CreateHiZ(vk::ImageView vkDepthView, const vk::Extent2D& extent);
+	void								DestroyHiZ();
+
+	void								RecordCulling(uint32_t frameIndex, const CullingPassInput& input);
+	void								RecordHiZBuild(uint32_t frameIndex, const glm::mat4& matViewProjection);
+
+	inline vk::Buffer					GetInstanceBuffer(uint32_t frameIndex) const	{ return m_ListFrames[frameIndex].instanceBuffer.buffer; }
+	inline vk::Buffer					GetDrawCommandBuffer(uint32_t frameIndex) const	{ return m_ListFrames[frameIndex].drawCommandBuffer.buffer; }
+
+private:
+	bool								CreateComputePipeline(const std::string& fileName, vk::PipelineLayout vkPipelineLayout, vk::Pipeline* pOutPipeline) const;
+	void								ExtractFrustumPlanes(const glm::mat4& matViewProjection, glm::vec4* pOutPlanes) const;
+
+	struct CullingFrame
+	{
+		UT::VkStructs::VulkanBuffer		instanceBuffer;			// survivors, at their draw's firstInstance
+		UT::VkStructs::VulkanBuffer		drawCommandBuffer;		// draw table, instance counts filled by cull.comp
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	vk::DescriptorSetLayout				m_vkCullSetLayout;
+	vk::DescriptorSetLayout				m_vkHiZSetLayout;
+	vk::PipelineLayout					m_vkCullPipelineLayout;
+	vk::PipelineLayout					m_vkHiZPipelineLayout;
+	vk::Pipeline						m_vkCullPipeline;
+	vk::Pipeline						m_vkHiZPipeline;
+	vk::Sampler							m_vkHiZSampler;
+
+	std::vector<CullingFrame>			m_ListFrames;
+
+	UT::VkStructs::VulkanImage			m_HiZImage;				// R32 float, full mip chain
+	std::vector<vk::ImageView>			m_vkListHiZMipViews;	// one per mip, hiz.comp writes through them
+	vk::ImageView						m_vkDepthView;			// framebuffer's, not ours to destroy
+	glm::mat4							m_matHiZViewProjection;	// what depth in pyramid was rendered with
+	bool								m_bHiZValid;
+};
@@ -0,0 +1,322 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDevice.h"
+#include "../EngineHeader.h"
+
+// Pools grow by half every time a list runs out, up to this many sets
+constexpr uint32_t GMaxSetsPerPool = 4096;
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanDescriptorAllocator::VulkanDescriptorAllocator()
+{
+	m_pDevice = nullptr;
+	m_uiInitialSetsPerPool = 0;
+	m_uiCurrentFrame = 0;
+	m_uiLiveSetCount = 0;
+	m_uiTransientSetCount = 0;
+
+	m_ListRatios.clear();
+	m_ListFramePools.clear();
+	m_ListExternalPools.clear();
+	m_umapRecycledSets.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanDescriptorAllocator::Initialize(const VulkanDevice* pDevice, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio>& listRatios)
+{
+	CHECK_LOG(initialSetsPerPool > 0 && !listRatios.empty(), "Descriptor allocator needs pool sizes!");
+
+	m_pDevice = pDevice;
+	m_uiInitialSetsPerPool = initialSetsPerPool;
+	m_ListRatios = listRatios;
+
+	m_PersistentPools.setsPerPool = m_uiInitialSetsPerPool;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::Cleanup()
+{
+	LogStats();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// sets go away with their pools!
+	DestroyPoolList(&m_PersistentPools);
+
+	for (PoolList& framePools : m_ListFramePools)
+	{
+		DestroyPoolList(&framePools);
+	}
+
+	for (const vk::DescriptorPool vkPool : m_ListExternalPools)
+	{
+		m_pDevice->GetDevice().destroyDescriptorPool(vkPool);
+	}
+
+	m_ListFramePools.clear();
+	m_ListExternalPools.clear();
+	m_umapRecycledSets.clear();
+	m_uiLiveSetCount = 0;
+	m_uiTransientSetCount = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanDescriptorAllocator::CreateFrames(uint32_t frameCount)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// One frame per frame context, nothing to do if they already exist
+	if (m_ListFramePools.size() == frameCount)
+		return true;
+
+	for (PoolList& framePools : m_ListFramePools)
+	{
+		DestroyPoolList(&framePools);
+	}
+
+	// Pools of a frame are created on first transient allocation, frames which never need any cost nothing
+	m_ListFramePools.clear();
+	m_ListFramePools.resize(frameCount);
+
+	for (PoolList& framePools : m_ListFramePools)
+	{
+		framePools.setsPerPool = m_uiInitialSetsPerPool;
+	}
+
+	m_uiCurrentFrame = 0;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	UT_ASSERT_BOOL((frameIndex < m_ListFramePools.size()), "Descriptor allocator frames not created!");
+
+	// Everything allocated for this frame last time around is dead, one reset per pool frees it all
+	m_uiCurrentFrame = frameIndex;
+	ResetPoolList(&m_ListFramePools[m_uiCurrentFrame]);
+	m_uiTransientSetCount = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorSet VulkanDescriptorAllocator::Allocate(vk::DescriptorSetLayout vkLayout)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Set freed earlier with same layout is good as new, caller writes it anyway
+	std::vector<vk::DescriptorSet>& listRecycled = m_umapRecycledSets[static_cast<VkDescriptorSetLayout>(vkLayout)];
+	if (!listRecycled.empty())
+	{
+		const vk::DescriptorSet vkDescriptorSet = listRecycled.back();
+		listRecycled.pop_back();
+
+		++m_uiLiveSetCount;
+		return vkDescriptorSet;
+	}
+
+	const vk::DescriptorSet vkDescriptorSet = AllocateFromList(&m_PersistentPools, vkLayout);
+	if (vkDescriptorSet)
+		++m_uiLiveSetCount;
+
+	return vkDescriptorSet;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::Free(vk::DescriptorSetLayout vkLayout, vk::DescriptorSet vkDescriptorSet)
+{
+	if (!vkDescriptorSet)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Set goes back to its layout's list, not to its pool. GPU must be done with it, next owner rewrites it!
+	m_umapRecycledSets[static_cast<VkDescriptorSetLayout>(vkLayout)].push_back(vkDescriptorSet);
+	--m_uiLiveSetCount;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorSet VulkanDescriptorAllocator::AllocateTransient(vk::DescriptorSetLayout vkLayout)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	UT_ASSERT_BOOL((m_uiCurrentFrame < m_ListFramePools.size()), "Descriptor allocator frames not created!");
+
+	const vk::DescriptorSet vkDescriptorSet = AllocateFromList(&m_ListFramePools[m_uiCurrentFrame], vkLayout);
+	if (vkDescriptorSet)
+		++m_uiTransientSetCount;
+
+	return vkDescriptorSet;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorPool VulkanDescriptorAllocator::CreateExternalPool(const std::vector<vk::DescriptorPoolSize>& listPoolSizes, uint32_t maxSets, vk::DescriptorPoolCreateFlags flags)
+{
+	vk::DescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.flags = flags;
+	poolCreateInfo.maxSets = maxSets;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(listPoolSizes.size());
+	poolCreateInfo.pPoolSizes = listPoolSizes.data();
+
+	const vk::DescriptorPool vkPool = m_pDevice->GetDevice().createDescriptorPool(poolCreateInfo);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_ListExternalPools.push_back(vkPool);
+
+	return vkPool;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+DescriptorAllocatorStats VulkanDescriptorAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	DescriptorAllocatorStats stats;
+
+	stats.persistentPoolCount = static_cast<uint32_t>(m_PersistentPools.listReadyPools.size() + m_PersistentPools.listFullPools.size());
+	stats.externalPoolCount = static_cast<uint32_t>(m_ListExternalPools.size());
+	stats.liveSetCount = m_uiLiveSetCount;
+	stats.transientSetCount = m_uiTransientSetCount;
+
+	for (const PoolList& framePools : m_ListFramePools)
+	{
+		stats.transientPoolCount += static_cast<uint32_t>(framePools.listReadyPools.size() + framePools.listFullPools.size());
+	}
+
+	for (const std::pair<const VkDescriptorSetLayout, std::vector<vk::DescriptorSet>>& recycled : m_umapRecycledSets)
+	{
+		stats.recycledSetCount += static_cast<uint32_t>(recycled.second.size());
+	}
+
+	return stats;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::LogStats() const
+{
+	const DescriptorAllocatorStats stats = GetStats();
+
+	LOG_DEBUG("---------- Descriptor Sets ----------");
+	LOG_DEBUG("Pools: {0} persistent | {1} transient | {2} external", stats.persistentPoolCount, stats.transientPoolCount, stats.externalPoolCount);
+	LOG_DEBUG("Sets: {0} live | {1} recycled | {2} transient this frame", stats.liveSetCount, stats.recycledSetCount, stats.transientSetCount);
+	LOG_DEBUG("-------------------------------------");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorSet VulkanDescriptorAllocator::AllocateFromList(PoolList* pPoolList, vk::DescriptorSetLayout vkLayout)
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	vk::DescriptorSetAllocateInfo setAllocInfo = {};
+	setAllocInfo.descriptorPool = GetOrCreatePool(pPoolList);
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &vkLayout;
+
+	vk::DescriptorSet vkDescriptorSet;
+	vk::Result result = vkDevice.allocateDescriptorSets(&setAllocInfo, &vkDescriptorSet);
+
+	// Current pool is done for, park it & try once more with a fresh one
+	if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+	{
+		pPoolList->listFullPools.push_back(pPoolList->listReadyPools.back());
+		pPoolList->listReadyPools.pop_back();
+
+		setAllocInfo.descriptorPool = GetOrCreatePool(pPoolList);
+		result = vkDevice.allocateDescriptorSets(&setAllocInfo, &vkDescriptorSet);
+	}
+
+	if (result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Descriptor allocator : failed to allocate descriptor set ({0})", vk::to_string(result));
+		return nullptr;
+	}
+
+	return vkDescriptorSet;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorPool VulkanDescriptorAllocator::GetOrCreatePool(PoolList* pPoolList)
+{
+	if (!pPoolList->listReadyPools.empty())
+		return pPoolList->listReadyPools.back();
+
+	const vk::DescriptorPool vkPool = CreatePool(pPoolList->setsPerPool);
+	pPoolList->listReadyPools.push_back(vkPool);
+
+	LOG_DEBUG("Descriptor allocator : new pool of {0} sets", pPoolList->setsPerPool);
+
+	// Needing another pool means this list is busier than we thought, next one is bigger
+	pPoolList->setsPerPool = std::min(pPoolList->setsPerPool + pPoolList->setsPerPool / 2, GMaxSetsPerPool);
+
+	return vkPool;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorPool VulkanDescriptorAllocator::CreatePool(uint32_t setCount) const
+{
+	std::vector<vk::DescriptorPoolSize> listPoolSizes;
+	listPoolSizes.reserve(m_ListRatios.size());
+
+	for (const PoolSizeRatio& ratio : m_ListRatios)
+	{
+		vk::DescriptorPoolSize poolSize = {};
+		poolSize.type = ratio.type;
+		poolSize.descriptorCount = std::max(1u, static_cast<uint32_t>(ratio.ratio * setCount));
+		listPoolSizes.push_back(poolSize);
+	}
+
+	// No eFreeDescriptorSet, sets are recycled or reset with the whole pool
+	vk::DescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.maxSets = setCount;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(listPoolSizes.size());
+	poolCreateInfo.pPoolSizes = listPoolSizes.data();
+
+	return m_pDevice->GetDevice().createDescriptorPool(poolCreateInfo);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::ResetPoolList(PoolList* pPoolList) const
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	for (const vk::DescriptorPool vkPool : pPoolList->listReadyPools)
+	{
+		vkDevice.resetDescriptorPool(vkPool);
+	}
+
+	for (const vk::DescriptorPool vkPool : pPoolList->listFullPools)
+	{
+		vkDevice.resetDescriptorPool(vkPool);
+		pPoolList->listReadyPools.push_back(vkPool);
+	}
+
+	pPoolList->listFullPools.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDescriptorAllocator::DestroyPoolList(PoolList* pPoolList) const
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	for (const vk::DescriptorPool vkPool : pPoolList->listReadyPools)
+	{
+		vkDevice.destroyDescriptorPool(vkPool);
+	}
+
+	for (const vk::DescriptorPool vkPool : pPoolList->listFullPools)
+	{
+		vkDevice.destroyDescriptorPool(vkPool);
+	}
+
+	pPoolList->listReadyPools.clear();
+	pPoolList->listFullPools.clear();
+}
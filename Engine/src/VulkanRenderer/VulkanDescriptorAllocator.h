@@ -0,0 +1,99 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+struct DescriptorAllocatorStats
+{
+	DescriptorAllocatorStats()
+	{
+		persistentPoolCount = 0;
+		transientPoolCount = 0;
+		externalPoolCount = 0;
+		liveSetCount = 0;
+		recycledSetCount = 0;
+		transientSetCount = 0;
+	}
+
+	uint32_t							persistentPoolCount;	// pools backing sets which live till Free()
+	uint32_t							transientPoolCount;		// pools of all frames, reset at BeginFrame()
+	uint32_t							externalPoolCount;		// handed out whole to libraries like imgui
+	uint32_t							liveSetCount;			// persistent sets currently in use
+	uint32_t							recycledSetCount;		// freed sets parked for reuse by same layout
+	uint32_t							transientSetCount;		// sets allocated for current frame so far
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Descriptor sets come from lists of pools instead of a pool per object. When every pool of a list is exhausted a new,
+// bigger one is added, pools are never freed one by one.
+//  - Persistent sets live till Free(). Freed sets aren't returned to their pool, they're parked per layout & handed to
+//    next Allocate() of that layout, so spawning & destroying objects neither creates pools nor fragments them!
+//  - Transient sets live for one frame, all pools of a frame are reset in one go at BeginFrame().
+class UT_API VulkanDescriptorAllocator
+{
+public:
+	// How many descriptors of a type a pool gets, per set it can hold
+	struct PoolSizeRatio
+	{
+		vk::DescriptorType				type;
+		float							ratio;
+	};
+
+public:
+	VulkanDescriptorAllocator();
+	~VulkanDescriptorAllocator();
+
+	bool								Initialize(const VulkanDevice* pDevice, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio>& listRatios);
+	void								Cleanup();
+
+	bool								CreateFrames(uint32_t frameCount);
+	void								BeginFrame(uint32_t frameIndex);
+
+	vk::DescriptorSet					Allocate(vk::DescriptorSetLayout vkLayout);
+	void								Free(vk::DescriptorSetLayout vkLayout, vk::DescriptorSet vkDescriptorSet);
+	vk::DescriptorSet					AllocateTransient(vk::DescriptorSetLayout vkLayout);
+
+	// For code which insists on its own pool (imgui), allocator only keeps it around to destroy it at cleanup
+	vk::DescriptorPool					CreateExternalPool(const std::vector<vk::DescriptorPoolSize>& listPoolSizes, uint32_t maxSets, vk::DescriptorPoolCreateFlags flags);
+
+	DescriptorAllocatorStats			GetStats() const;
+	void								LogStats() const;
+
+private:
+	struct PoolList
+	{
+		PoolList() : setsPerPool(0) {}
+
+		std::vector<vk::DescriptorPool>	listReadyPools;			// might still have room
+		std::vector<vk::DescriptorPool>	listFullPools;			// ran out once, only a reset brings them back
+		uint32_t						setsPerPool;			// size of next pool created for this list
+	};
+
+	vk::DescriptorSet					AllocateFromList(PoolList* pPoolList, vk::DescriptorSetLayout vkLayout);
+	vk::DescriptorPool					GetOrCreatePool(PoolList* pPoolList);
+	vk::DescriptorPool					CreatePool(uint32_t setCount) const;
+	void								ResetPoolList(PoolList* pPoolList) const;
+	void								DestroyPoolList(PoolList* pPoolList) const;
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	std::vector<PoolSizeRatio>			m_ListRatios;
+	uint32_t							m_uiInitialSetsPerPool;
+
+	PoolList							m_PersistentPools;
+	std::vector<PoolList>				m_ListFramePools;
+	std::vector<vk::DescriptorPool>		m_ListExternalPools;
+	uint32_t							m_uiCurrentFrame;
+
+	std::unordered_map<VkDescriptorSetLayout, std::vector<vk::DescriptorSet>>	m_umapRecycledSets;
+
+	uint32_t							m_uiLiveSetCount;
+	uint32_t							m_uiTransientSetCount;
+
+	mutable std::mutex					m_Mutex;
+};
@@ -2,12 +2,32 @@
 #include "../EngineHeader.h"
 #include "VulkanDevice.h"
 #include "VulkanGlobals.h"
-#include "VulkanFramebuffer.h"
+#include "VulkanFrameContext.h"
+#include "VulkanStagingRing.h"
+#include "VulkanSamplerCache.h"
+#include "VulkanUniformArena.h"
+#include "VulkanLayoutCache.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanBindlessTextures.h"
+#include "../RenderObjects/VulkanTextureCache.h"
+#include "../RenderObjects/VulkanMeshCache.h"
+#include "../RenderObjects/VulkanMeshPool.h"
 #include "GLFW/glfw3.h"
 
 //---------------------------------------------------------------------------------------------------------------------
 VulkanDevice::VulkanDevice()
 {
+	m_pMemoryAllocator = nullptr;
+	m_pStagingRing = nullptr;
+	m_pTextureCache = nullptr;
+	m_pMeshCache = nullptr;
+	m_pMeshPool = nullptr;
+	m_pSamplerCache = nullptr;
+	m_pUniformArena = nullptr;
+	m_pLayoutCache = nullptr;
+	m_pDescriptorAllocator = nullptr;
+	m_pBindlessTextures = nullptr;
+	m_uiImmediateTimelineValue = 0;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -35,10 +55,57 @@ void VulkanDevice::RecreateOnWindowResize()
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanDevice::Cleanup()
 {
-	m_vkDevice.freeCommandBuffers(m_vkGraphicsCommandPool, m_vkListGraphicsCommandBuffers);
-	m_vkDevice.destroyCommandPool(m_vkGraphicsCommandPool);
+	for (VulkanFrameContext* pFrameContext : m_ListFrameContexts)
+	{
+		pFrameContext->Cleanup();
+		SAFE_DELETE(pFrameContext);
+	}
+
+	m_ListFrameContexts.clear();
+
+	RetireImmediateSubmits(true);
+	for (const ImmediateSubmit& immediateSubmit : m_ListFreeImmediateSubmits)
+	{
+		m_vkDevice.destroyCommandPool(immediateSubmit.pool);
+	}
+
+	m_ListFreeImmediateSubmits.clear();
+	m_vkDevice.destroySemaphore(m_vkImmediateTimeline);
+
+	// Meshes & textures nobody released yet, their buffers & images come from the allocator too!
+	m_pMeshCache->Cleanup();
+	SAFE_DELETE(m_pMeshCache);
+
+	m_pMeshPool->Cleanup();
+	SAFE_DELETE(m_pMeshPool);
+
+	m_pTextureCache->Cleanup();
+	SAFE_DELETE(m_pTextureCache);
+
+	m_pSamplerCache->Cleanup();
+	SAFE_DELETE(m_pSamplerCache);
+
+	m_pUniformArena->Cleanup();
+	SAFE_DELETE(m_pUniformArena);
 
-	m_vkListGraphicsCommandBuffers.clear();
+	// Textures are gone, so are their slots
+	m_pBindlessTextures->Cleanup();
+	SAFE_DELETE(m_pBindlessTextures);
+
+	// Every set handed out goes away with the pools
+	m_pDescriptorAllocator->Cleanup();
+	SAFE_DELETE(m_pDescriptorAllocator);
+
+	// Arena's set layout comes from here as well
+	m_pLayoutCache->Cleanup();
+	SAFE_DELETE(m_pLayoutCache);
+
+	// Ring memory comes from the allocator, so it has to go first!
+	m_pStagingRing->Cleanup();
+	SAFE_DELETE(m_pStagingRing);
+
+	m_pMemoryAllocator->LogStats();
+	SAFE_DELETE(m_pMemoryAllocator);
 
 	//pRC->CleanupCommandBuffers();
 	//
@@ -47,58 +114,64 @@ void VulkanDevice::Cleanup()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CleanupOnWindowsResize()
+bool VulkanDevice::CreateFrameContexts()
 {
-	m_vkDevice.freeCommandBuffers(m_vkGraphicsCommandPool, m_vkListGraphicsCommandBuffers);
-	m_vkListGraphicsCommandBuffers.clear();
+	// Fixed count, swapchain may come back from a resize with a different number of images but we don't care anymore
+	m_ListFrameContexts.resize(UT::VkGlobals::GMaxFramesDraws);
 
-	//pRC->vkDevice.destroySwapchainKHR(pRC->vkSwapchain);
-	//pRC->vkDevice.freeCommandBuffers(pRC->vkGraphicsCommandPool, pRC->vkListGraphicsCommandBuffers);
+	for (uint32_t i = 0; i < m_ListFrameContexts.size(); ++i)
+	{
+		m_ListFrameContexts[i] = new VulkanFrameContext();
+		CHECK(m_ListFrameContexts[i]->Initialize(this, i));
+	}
+
+	// Uniforms & transient descriptor sets are written per frame context, so both need as many frames
+	CHECK(m_pDescriptorAllocator->CreateFrames(GetFrameCount()));
+	CHECK(m_pUniformArena->CreateFrames(GetFrameCount()));
+
+	LOG_INFO("{0} frame contexts created", GetFrameCount());
 
-	LOG_DEBUG("Window Resize ======> Command buffer destroyed");
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CreateCommandBuffers(const VulkanFramebuffer* pFrameBuffer)
+vk::CommandBuffer VulkanDevice::GetGraphicsCommandBuffer(uint32_t frameIndex) const
 {
-	// Create command pool!
-	vk::CommandPoolCreateInfo poolInfo = {};
-	poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
-	poolInfo.queueFamilyIndex = m_QueueFamilyIndices.graphicsFamily.value();
-
-	m_vkGraphicsCommandPool = m_vkDevice.createCommandPool(poolInfo);
-
-	LOG_INFO("Graphics command pool created");
+	return m_ListFrameContexts[frameIndex]->GetCommandBuffer();
+}
 
-	// Create command buffers!
-	if (pFrameBuffer->GetFramebufferCount() <= 0)
-		LOG_ERROR("Framebuffers needs to be created before creating command buffers!");
+//---------------------------------------------------------------------------------------------------------------------
+vk::CommandBuffer VulkanDevice::BeginTransferCommandBuffer() const
+{
+	ImmediateSubmit immediateSubmit;
 
-	// Make sure we have command buffer for each framebuffer!
-	m_vkListGraphicsCommandBuffers.resize(pFrameBuffer->GetFramebufferCount());
+	// Recycle a retired one if we have it, its pool was already reset...
+	if (!m_ListFreeImmediateSubmits.empty())
+	{
+		immediateSubmit = m_ListFreeImmediateSubmits.back();
+		m_ListFreeImmediateSubmits.pop_back();
+	}
+	else
+	{
+		// ...otherwise make a new pool & its only buffer!
+		vk::CommandPoolCreateInfo poolInfo = {};
+		poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+		poolInfo.queueFamilyIndex = m_QueueFamilyIndices.graphicsFamily.value();
 
-	// Allocate buffer from the Graphics command pool
-	vk::CommandBufferAllocateInfo cbAllocInfo = {};
-	cbAllocInfo.commandPool = m_vkGraphicsCommandPool;
-	cbAllocInfo.level = vk::CommandBufferLevel::ePrimary;
-	cbAllocInfo.commandBufferCount = static_cast<uint32_t>(m_vkListGraphicsCommandBuffers.size());
+		immediateSubmit.pool = m_vkDevice.createCommandPool(poolInfo);
 
-	m_vkListGraphicsCommandBuffers = m_vkDevice.allocateCommandBuffers(cbAllocInfo);
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.level = vk::CommandBufferLevel::ePrimary;
+		allocInfo.commandPool = immediateSubmit.pool;
+		allocInfo.commandBufferCount = 1;
 
-	LOG_INFO("Graphics command buffer created");
-}
+		immediateSubmit.cmdBuffer = m_vkDevice.allocateCommandBuffers(allocInfo).front();
+	}
 
-//---------------------------------------------------------------------------------------------------------------------
-vk::CommandBuffer VulkanDevice::BeginTransferCommandBuffer() const
-{
-	// Command buffer details
-	vk::CommandBufferAllocateInfo allocInfo;
-	allocInfo.level = vk::CommandBufferLevel::ePrimary;
-	allocInfo.commandPool = m_vkGraphicsCommandPool;
-	allocInfo.commandBufferCount = 1;
+	immediateSubmit.timelineValue = 0;
+	m_ListRecordingImmediateSubmits.push_back(immediateSubmit);
 
-	// Allocate command buffer from pool
-	const vk::CommandBuffer cmdBuffer = m_vkDevice.allocateCommandBuffers(allocInfo).front();
+	const vk::CommandBuffer cmdBuffer = immediateSubmit.cmdBuffer;
 
 	// Information to begin the command buffer record!
 	vk::CommandBufferBeginInfo beginInfo;
@@ -111,43 +184,162 @@ vk::CommandBuffer VulkanDevice::BeginTransferCommandBuffer() const
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::EndAndSubmitTransferCommandBuffer(vk::CommandBuffer commandBuffer) const
+UT::VkStructs::UploadTicket VulkanDevice::EndAndSubmitTransferCommandBuffer(vk::CommandBuffer commandBuffer) const
 {
 	// End Commands!
 	commandBuffer.end();
 
+	const uint64_t signalValue = ++m_uiImmediateTimelineValue;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+
 	// Queue submission information
 	vk::SubmitInfo submitInfo;
+	submitInfo.pNext = &timelineSubmitInfo;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_vkImmediateTimeline;
+
+	// Submit to graphics queue & return right away, caller waits on the ticket only if it really has to!
+	m_vkQueueGraphics.submit(submitInfo, nullptr);
 
-	// Submit transfer command to transfer queue (which is same as Graphics Queue) & wait until it finishes!
-	const vk::Fence commandFence = m_vkDevice.createFence({});
-	m_vkQueueGraphics.submit(submitInfo, commandFence);
-	m_vkQueueGraphics.waitIdle();
+	// Pool is reset & recycled once GPU is done with it
+	auto iter = std::find_if(m_ListRecordingImmediateSubmits.begin(), m_ListRecordingImmediateSubmits.end(),
+							 [commandBuffer](const ImmediateSubmit& immediateSubmit) { return immediateSubmit.cmdBuffer == commandBuffer; });
 
-	m_vkDevice.freeCommandBuffers(m_vkGraphicsCommandPool, commandBuffer);
+	UT_ASSERT_BOOL((iter != m_ListRecordingImmediateSubmits.end()), "Command buffer wasn't begun with BeginTransferCommandBuffer!");
+
+	iter->timelineValue = signalValue;
+	m_ListPendingImmediateSubmits.push_back(*iter);
+	m_ListRecordingImmediateSubmits.erase(iter);
+
+	UT::VkStructs::UploadTicket ticket;
+	ticket.timeline = m_vkImmediateTimeline;
+	ticket.value = signalValue;
+
+	return ticket;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::BindPipeline(uint32_t imageIndex, vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline) const
+void VulkanDevice::RetireImmediateSubmits(bool bWaitAll) const
 {
-	m_vkListGraphicsCommandBuffers[imageIndex].bindPipeline(bindPoint, pipeline);
+	if (m_ListPendingImmediateSubmits.empty())
+		return;
+
+	if (bWaitAll)
+	{
+		vk::SemaphoreWaitInfo waitInfo = {};
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_vkImmediateTimeline;
+		waitInfo.pValues = &m_uiImmediateTimelineValue;
+
+		const vk::Result result = m_vkDevice.waitSemaphores(waitInfo, UINT64_MAX);
+		UT_ASSERT_VK(result, "Waiting on immediate submits failed!");
+	}
+
+	const uint64_t completedValue = m_vkDevice.getSemaphoreCounterValue(m_vkImmediateTimeline);
+
+	// Submitted in order, so completed ones are always at the front
+	auto iter = m_ListPendingImmediateSubmits.begin();
+	for (; iter != m_ListPendingImmediateSubmits.end() && iter->timelineValue <= completedValue; ++iter)
+	{
+		m_vkDevice.resetCommandPool(iter->pool);
+		m_ListFreeImmediateSubmits.push_back(*iter);
+	}
+
+	m_ListPendingImmediateSubmits.erase(m_ListPendingImmediateSubmits.begin(), iter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+UT::VkStructs::UploadTicket VulkanDevice::UploadToBuffer(const void* pData, vk::DeviceSize size, vk::Buffer dstBuffer, vk::DeviceSize dstOffset) const
+{
+	UT::VkStructs::UploadTicket ticket;
+
+	if (!m_pStagingRing->UploadToBuffer(pData, size, dstBuffer, dstOffset, &ticket))
+	{
+		LOG_ERROR("Failed to stage buffer upload!");
+	}
+
+	return ticket;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+UT::VkStructs::UploadTicket VulkanDevice::UploadToImage(const void* pData, vk::DeviceSize size, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips) const
+{
+	UT::VkStructs::UploadTicket ticket;
+
+	// pData is either mip 0 only (GPU builds the rest) or the whole tightly packed chain
+	if (!m_pStagingRing->UploadToImage(pData, size, dstImage, bGenerateMips, &ticket))
+	{
+		LOG_ERROR("Failed to stage image upload!");
+	}
+
+	return ticket;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+UT::VkStructs::UploadTicket VulkanDevice::UploadImageLevels(const uint8_t* const* ppLevelData, const UT::VkStructs::VulkanImage& dstImage) const
+{
+	UT::VkStructs::UploadTicket ticket;
+
+	// One pointer per mip level of dstImage, usually straight into a memory mapped container file
+	if (!m_pStagingRing->UploadImageLevels(ppLevelData, dstImage, &ticket))
+	{
+		LOG_ERROR("Failed to stage image level upload!");
+	}
+
+	return ticket;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanDevice::IsUploadComplete(const UT::VkStructs::UploadTicket& ticket) const
+{
+	// Uploads still sitting in staging ring's recording batch only complete after next FlushUploads()!
+	if (!ticket.IsValid())
+		return true;
+
+	return m_vkDevice.getSemaphoreCounterValue(ticket.timeline) >= ticket.value;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize bufferSize) const
+void VulkanDevice::WaitForUpload(const UT::VkStructs::UploadTicket& ticket) const
 {
-	vk::CommandBuffer cmdBuffer = BeginTransferCommandBuffer();
+	if (IsUploadComplete(ticket))
+		return;
+
+	// Staging ring flushes first if the ticket belongs to its recording batch
+	if (ticket.timeline == m_pStagingRing->GetTimelineSemaphore())
+	{
+		m_pStagingRing->WaitForTicket(ticket);
+		return;
+	}
+
+	vk::SemaphoreWaitInfo waitInfo = {};
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &ticket.timeline;
+	waitInfo.pValues = &ticket.value;
+
+	const vk::Result result = m_vkDevice.waitSemaphores(waitInfo, UINT64_MAX);
+	UT_ASSERT_VK(result, "Waiting on upload ticket failed!");
+}
 
-	vk::BufferCopy bufferCopyRegion;
-	bufferCopyRegion.srcOffset = 0;
-	bufferCopyRegion.dstOffset = 0;
-	bufferCopyRegion.size = bufferSize;
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDevice::BindPipeline(uint32_t frameIndex, vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline) const
+{
+	GetGraphicsCommandBuffer(frameIndex).bindPipeline(bindPoint, pipeline);
+}
 
-	cmdBuffer.copyBuffer(srcBuffer, dstBuffer, 1, &bufferCopyRegion);
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanDevice::FlushUploads() const
+{
+	// Submit everything recorded into staging ring so far, doesn't wait for GPU!
+	m_pStagingRing->Flush();
 
-	EndAndSubmitTransferCommandBuffer(cmdBuffer);
+	// ...and give back command buffers of finished one-off submits
+	RetireImmediateSubmits(false);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -219,12 +411,13 @@ bool VulkanDevice::CreateLogicalDevice()
 	const std::set<uint32_t> uniqueQueueFamilies =
 	{
 		m_QueueFamilyIndices.graphicsFamily.value(),
-		m_QueueFamilyIndices.presentFamily.value()
+		m_QueueFamilyIndices.presentFamily.value(),
+		GetTransferQueueFamilyIndex()
 	};
 
 	constexpr float queuePriority = 1.0f;
 
-	for (uint32_t queueFamily = 0; queueFamily < uniqueQueueFamilies.size(); ++queueFamily)
+	for (const uint32_t queueFamily : uniqueQueueFamilies)
 	{
 		// Queue the logical device needs to create & the info to do so!
 		vk::DeviceQueueCreateInfo queueCreateInfo;
@@ -247,6 +440,32 @@ bool VulkanDevice::CreateLogicalDevice()
 
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
+	// Whole scene goes out as one indirect draw, every command picks its own instance range
+	CHECK_LOG(deviceFeatures.multiDrawIndirect && deviceFeatures.drawIndirectFirstInstance, "Device doesn't support multi draw indirect with first instance!");
+
+	// Descriptor indexing is core since 1.2, but its pieces are still optional. Bindless texture table needs all of them!
+	const auto supportedFeatures = m_vkPhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+	const vk::PhysicalDeviceVulkan12Features& supportedFeatures12 = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+
+	CHECK_LOG(supportedFeatures12.descriptorIndexing &&
+			  supportedFeatures12.runtimeDescriptorArray &&
+			  supportedFeatures12.descriptorBindingPartiallyBound &&
+			  supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind &&
+			  supportedFeatures12.descriptorBindingUpdateUnusedWhilePending &&
+			  supportedFeatures12.shaderSampledImageArrayNonUniformIndexing, "Device doesn't support descriptor indexing needed for bindless textures!");
+
+	// Vulkan 1.2 core features, timeline semaphores hand uploads over from transfer to graphics queue
+	vk::PhysicalDeviceVulkan12Features deviceFeatures12 = {};
+	deviceFeatures12.timelineSemaphore = true;
+	deviceFeatures12.descriptorIndexing = true;
+	deviceFeatures12.runtimeDescriptorArray = true;
+	deviceFeatures12.descriptorBindingPartiallyBound = true;
+	deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind = true;
+	deviceFeatures12.descriptorBindingUpdateUnusedWhilePending = true;
+	deviceFeatures12.shaderSampledImageArrayNonUniformIndexing = true;
+
+	deviceCreateInfo.pNext = &deviceFeatures12;
+
 	// Create logical device from the given physical device...
 	m_vkDevice = m_vkPhysicalDevice.createDevice(deviceCreateInfo);
 	LOG_DEBUG("Vulkan Logical device created!");
@@ -254,6 +473,67 @@ bool VulkanDevice::CreateLogicalDevice()
 	// Queues are created at the same time as device creation, store their handle!
 	m_vkQueueGraphics = m_vkDevice.getQueue(m_QueueFamilyIndices.graphicsFamily.value(), 0);
 	m_vkQueuePresent = m_vkDevice.getQueue(m_QueueFamilyIndices.presentFamily.value(), 0);
+	m_vkQueueTransfer = m_vkDevice.getQueue(GetTransferQueueFamilyIndex(), 0);
+
+	// Timeline for one-off command buffers (layout transitions, font upload etc.), their pools are made on demand
+	vk::SemaphoreTypeCreateInfo timelineInfo = {};
+	timelineInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+	timelineInfo.initialValue = 0;
+
+	vk::SemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.pNext = &timelineInfo;
+
+	m_vkImmediateTimeline = m_vkDevice.createSemaphore(semaphoreInfo);
+
+	// All buffers & images are sub-allocated from few big memory blocks instead of vkAllocateMemory per resource!
+	m_pMemoryAllocator = new VulkanMemoryAllocator(m_vkDevice, m_vkPhysicalDevice);
+
+	// ...and all uploads to device local memory go through one persistently mapped staging ring!
+	m_pStagingRing = new VulkanStagingRing();
+	CHECK(m_pStagingRing->Initialize(this, UT::VkGlobals::GStagingRingSize));
+
+	// Samplers are shared by everyone who asks for same settings...
+	m_pSamplerCache = new VulkanSamplerCache();
+	CHECK(m_pSamplerCache->Initialize(this));
+
+	// Every texture gets a slot in global table the moment it's created, materials refer to them by slot...
+	m_pBindlessTextures = new VulkanBindlessTextures();
+	CHECK(m_pBindlessTextures->Initialize(this, UT::VkGlobals::GMaxBindlessTextures));
+
+	// ...& textures shared between materials are created only once
+	m_pTextureCache = new VulkanTextureCache();
+	CHECK(m_pTextureCache->Initialize(this));
+
+	// Every mesh lives in the same pair of vertex & index buffers...
+	m_pMeshPool = new VulkanMeshPool();
+	CHECK(m_pMeshPool->Initialize(this, UT::VkGlobals::GMeshPoolMaxVertices, UT::VkGlobals::GMeshPoolMaxIndices));
+
+	// ...& meshes are shared just like textures, objects sharing geometry get drawn instanced
+	m_pMeshCache = new VulkanMeshCache();
+	CHECK(m_pMeshCache->Initialize(this));
+
+	// Layouts are descriptions, identical ones are shared by everyone...
+	m_pLayoutCache = new VulkanLayoutCache();
+	CHECK(m_pLayoutCache->Initialize(this));
+
+	// ...& descriptor sets of everyone come from a few shared pools
+	const std::vector<VulkanDescriptorAllocator::PoolSizeRatio> listPoolRatios =
+	{
+		{ vk::DescriptorType::eCombinedImageSampler, 4.0f },
+		{ vk::DescriptorType::eUniformBuffer, 1.0f },
+		{ vk::DescriptorType::eUniformBufferDynamic, 1.0f },
+		{ vk::DescriptorType::eStorageBuffer, 1.0f },
+		{ vk::DescriptorType::eStorageImage, 1.0f }
+	};
+
+	m_pDescriptorAllocator = new VulkanDescriptorAllocator();
+	CHECK(m_pDescriptorAllocator->Initialize(this, 64, listPoolRatios));
+
+	// Uniform data of every object for a frame goes in one buffer, frames are created with frame contexts
+	m_pUniformArena = new VulkanUniformArena();
+	CHECK(m_pUniformArena->Initialize(this, UT::VkGlobals::GUniformArenaSize));
+
+	CHECK(CreateFrameContexts());
 
 	return true;
 }
@@ -269,7 +549,7 @@ void VulkanDevice::FetchQueueFamilies(vk::SurfaceKHR vkSurface)
 	std::vector<vk::QueueFamilyProperties>::iterator iter = queueFamilyProps.begin();
 	for (; iter != queueFamilyProps.end(); ++iter)
 	{
-		if ((*iter).queueFlags & vk::QueueFlagBits::eGraphics)
+		if (!m_QueueFamilyIndices.graphicsFamily.has_value() && ((*iter).queueFlags & vk::QueueFlagBits::eGraphics))
 		{
 			m_QueueFamilyIndices.graphicsFamily = i;
 		}
@@ -278,16 +558,43 @@ void VulkanDevice::FetchQueueFamilies(vk::SurfaceKHR vkSurface)
 		VkBool32 bPresentSupport = m_vkPhysicalDevice.getSurfaceSupportKHR(i, vkSurface);
 
 		// if yes, store presentation family queue index!
-		if (bPresentSupport)
+		if (!m_QueueFamilyIndices.presentFamily.has_value() && bPresentSupport)
 		{
 			m_QueueFamilyIndices.presentFamily = i;
 		}
 
-		if (m_QueueFamilyIndices.isComplete())
-			break;
-
 		++i;
 	}
+
+	// Look for a family which can only do transfers (DMA engine on discrete GPUs), failing that any family without
+	// graphics. If there is none, uploads simply stay on graphics queue!
+	uint32_t bestTransferFlagCount = UINT32_MAX;
+
+	i = 0;
+	for (iter = queueFamilyProps.begin(); iter != queueFamilyProps.end(); ++iter, ++i)
+	{
+		const vk::QueueFlags flags = (*iter).queueFlags;
+
+		if (!(flags & vk::QueueFlagBits::eTransfer) || (flags & vk::QueueFlagBits::eGraphics))
+			continue;
+
+		// Fewer capabilities == more dedicated hardware
+		const uint32_t flagCount = static_cast<uint32_t>(std::bitset<32>(static_cast<VkQueueFlags>(flags)).count());
+		if (flagCount < bestTransferFlagCount)
+		{
+			bestTransferFlagCount = flagCount;
+			m_QueueFamilyIndices.transferFamily = i;
+		}
+	}
+
+	if (m_QueueFamilyIndices.transferFamily.has_value())
+	{
+		LOG_INFO("Dedicated transfer queue family {0} found", m_QueueFamilyIndices.transferFamily.value());
+	}
+	else
+	{
+		LOG_WARNING("No dedicated transfer queue family, uploads will use graphics queue");
+	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -334,47 +641,38 @@ vk::ShaderModule VulkanDevice::CreateShaderModule(const std::string& fileName) c
 	std::ifstream file(fileName, std::ios::ate | std::ios::binary);
 
 	if (!file.is_open())
-		LOG_ERROR("Failed to open Shader file!");
+	{
+		LOG_ERROR("Failed to open Shader file {0}!", fileName);
+		return nullptr;
+	}
 
-	// get the file size & allocate buffer memory!
+	// get the file size & allocate buffer memory! SPIR-V is a stream of 32 bit words, read it as such
 	const size_t fileSize = (size_t)file.tellg();
-	std::vector<char> buffer(fileSize);
+	if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0)
+	{
+		LOG_ERROR("{0} is not a SPIR-V binary!", fileName);
+		return nullptr;
+	}
+
+	std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
 
 	// now seek back to the beginning of the file & read all bytes at once!
 	file.seekg(0);
-	file.read(buffer.data(), fileSize);
+	file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
 
 	// close the file!
 	file.close();
 
 	// Create Shader Module
 	vk::ShaderModuleCreateInfo shaderModuleInfo;
-	shaderModuleInfo.codeSize = buffer.size();
-	shaderModuleInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
-
-	std::string shaderModuleName = fileName;
+	shaderModuleInfo.codeSize = fileSize;
+	shaderModuleInfo.pCode = buffer.data();
 
 	const vk::ShaderModule shaderModule = m_vkDevice.createShaderModule(shaderModuleInfo);
 
 	return shaderModule;
 }
 
-//-----------------------------------------------------------------------------------------------------------------------
-uint32_t VulkanDevice::FindMemoryTypeIndex(uint32_t allowedTypeIndex, vk::MemoryPropertyFlags props) const
-{
-	for (uint32_t i = 0; i < m_vkPhysicalDevice.getMemoryProperties().memoryTypeCount; i++)
-	{
-		if ((allowedTypeIndex & (1 << i))																		// Index of memory type must match corresponding bit in allowed types!
-			&& (m_vkPhysicalDevice.getMemoryProperties().memoryTypes[i].propertyFlags & props) == props)		// Desired property bit flags are part of the memory type's property flags!
-		{
-			// This memory type is valid, so return index!
-			return i;
-		}
-	}
-
-	return 0;
-}
-
 //---------------------------------------------------------------------------------------------------------------------
 vk::Format VulkanDevice::ChooseSupportedFormat(const std::vector<vk::Format>& formats, vk::ImageTiling tiling, vk::FormatFeatureFlags featureFlags) const
 {
@@ -393,41 +691,16 @@ vk::Format VulkanDevice::ChooseSupportedFormat(const std::vector<vk::Format>& fo
 		{
 			return format;
 		}
-		else
-		{
-			LOG_ERROR("Failed to find matching format!");
-			return vk::Format::eUndefined;
-		}
 	}
-}
 
-//---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CopyBufferToImage(vk::Buffer srcBuffer, uint32_t width, uint32_t height, vk::Image* image) const
-{
-	// Create buffer
-	const vk::CommandBuffer transferCommandBuffer = BeginTransferCommandBuffer();
-
-	vk::BufferImageCopy imgRegion = {};
-	imgRegion.bufferOffset = 0;
-	imgRegion.bufferRowLength = 0;
-	imgRegion.bufferImageHeight = 0;
-	imgRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-	imgRegion.imageSubresource.mipLevel = 0;
-	imgRegion.imageSubresource.baseArrayLayer = 0;
-	imgRegion.imageSubresource.layerCount = 1;
-	imgRegion.imageOffset = VkOffset3D{ 0,0,0 };
-	imgRegion.imageExtent = VkExtent3D{ width, height, 1 };
-	
-	// copy buffer to given image!
-	transferCommandBuffer.copyBufferToImage(srcBuffer, *image, vk::ImageLayout::eTransferDstOptimal, imgRegion);
-		
-	EndAndSubmitTransferCommandBuffer(transferCommandBuffer);
+	LOG_ERROR("Failed to find matching format!");
+	return vk::Format::eUndefined;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling,
+bool VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling,
 								vk::ImageUsageFlags usageFlags, vk::MemoryPropertyFlags memoryPropertyFlags,
-								vk::ImageAspectFlags aspectFlags, UT::VkStructs::VulkanImage* pOutImage2D) const 
+								vk::ImageAspectFlags aspectFlags, UT::VkStructs::VulkanImage* pOutImage2D, uint32_t mipLevels) const
 
 {
 	// Image creation info!
@@ -436,7 +709,7 @@ void VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format for
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -451,13 +724,17 @@ void VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format for
 	// Get memory requirements for the image...
 	const vk::MemoryRequirements imgMemReqs = m_vkDevice.getImageMemoryRequirements(image);
 
-	// Allocate memory using requirements & user defined properties...	
-	vk::MemoryAllocateInfo memAllocInfo;
-	memAllocInfo.allocationSize = imgMemReqs.size;
-	memAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(imgMemReqs.memoryTypeBits, memoryPropertyFlags);
+	// Sub-allocate memory using requirements & user defined properties...	
+	VulkanAllocation allocation;
+	const bool bLinearResource = (tiling == vk::ImageTiling::eLinear);
+	if (!m_pMemoryAllocator->Allocate(imgMemReqs, memoryPropertyFlags, bLinearResource, MemoryPoolType::POOL_FREE_LIST, &allocation))
+	{
+		LOG_ERROR("Failed to allocate memory for image!");
+		m_vkDevice.destroyImage(image);
+		return false;
+	}
 
-	const vk::DeviceMemory deviceMemory = m_vkDevice.allocateMemory(memAllocInfo);
-	m_vkDevice.bindImageMemory(image, deviceMemory, 0);
+	m_vkDevice.bindImageMemory(image, allocation.deviceMemory, allocation.offset);
 
 	// Image View Creation
 	vk::ImageViewCreateInfo createInfo;
@@ -472,7 +749,7 @@ void VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format for
 
 	createInfo.subresourceRange.aspectMask = aspectFlags;
 	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.levelCount = mipLevels;
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
@@ -480,11 +757,97 @@ void VulkanDevice::CreateImage2D(uint32_t width, uint32_t height, vk::Format for
 
 	// Fill out output image params!
 	pOutImage2D->image = image;
-	pOutImage2D->deviceMemory = deviceMemory;
+	pOutImage2D->allocation = allocation;
 	pOutImage2D->extent.width = width;
 	pOutImage2D->extent.height = height;
 	pOutImage2D->format = format;
+	pOutImage2D->mipLevels = mipLevels;
 	pOutImage2D->imageView = imgView;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+bool VulkanDevice::SupportsLinearBlit(vk::Format format) const
+{
+	const vk::FormatProperties formatProps = m_vkPhysicalDevice.getFormatProperties(format);
+	const vk::FormatFeatureFlags requiredFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst |
+													vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+	return (formatProps.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+void VulkanDevice::GenerateMipChain(vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevels, vk::CommandBuffer cmdBuffer) const
+{
+	// Expects every level in TRANSFER_DST with mip 0 written, leaves every level in SHADER_READ_ONLY. Blits need a
+	// graphics capable queue!
+	vk::ImageMemoryBarrier barrier = {};
+	barrier.srcQueueFamilyIndex = vk::QueueFamilyIgnored;
+	barrier.dstQueueFamilyIndex = vk::QueueFamilyIgnored;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	int32_t mipWidth = static_cast<int32_t>(width);
+	int32_t mipHeight = static_cast<int32_t>(height);
+
+	for (uint32_t mip = 1; mip < mipLevels; ++mip)
+	{
+		// Previous level becomes blit source...
+		barrier.subresourceRange.baseMipLevel = mip - 1;
+		barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+		barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+		cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+								  vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+		// ...gets filtered down into this level...
+		const int32_t nextWidth = std::max(mipWidth / 2, 1);
+		const int32_t nextHeight = std::max(mipHeight / 2, 1);
+
+		vk::ImageBlit blit = {};
+		blit.srcOffsets[0] = vk::Offset3D(0, 0, 0);
+		blit.srcOffsets[1] = vk::Offset3D(mipWidth, mipHeight, 1);
+		blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+		blit.srcSubresource.mipLevel = mip - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = vk::Offset3D(0, 0, 0);
+		blit.dstOffsets[1] = vk::Offset3D(nextWidth, nextHeight, 1);
+		blit.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+		blit.dstSubresource.mipLevel = mip;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+
+		cmdBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+
+		// ...& is done, shaders can have it
+		barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+		barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+								  vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+		mipWidth = nextWidth;
+		mipHeight = nextHeight;
+	}
+
+	// Last level was only ever written to
+	barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+	barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+	barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+							  vk::DependencyFlags(), nullptr, nullptr, barrier);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -492,7 +855,10 @@ void VulkanDevice::TransitionImageLayout(vk::Image srcImage, vk::ImageLayout old
 {
 	vk::CommandBuffer commandBuffer;
 
-	if (cmdBuffer != VK_NULL_HANDLE)
+	// Only submit here if we own the command buffer, otherwise caller submits it along with rest of its commands!
+	const bool bOwnCommandBuffer = (cmdBuffer == VK_NULL_HANDLE);
+
+	if (!bOwnCommandBuffer)
 		commandBuffer = cmdBuffer;
 	else
 		commandBuffer = BeginTransferCommandBuffer();
@@ -505,7 +871,7 @@ void VulkanDevice::TransitionImageLayout(vk::Image srcImage, vk::ImageLayout old
 	imageMemoryBarrier.image = srcImage;												// Image being accessed & modified as a part of barrier
 	imageMemoryBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;	// Aspect of image being altered
 	imageMemoryBarrier.subresourceRange.baseMipLevel = 0;								// First mip level to start alteration on
-	imageMemoryBarrier.subresourceRange.levelCount = 1;									// Number of mip levels to alter starting from base mip level
+	imageMemoryBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;			// Number of mip levels to alter starting from base mip level
 	imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;								// First layer of start alterations on
 	imageMemoryBarrier.subresourceRange.layerCount = 1;									// Number of layers to alter starting from base array layer
 
@@ -649,12 +1015,13 @@ void VulkanDevice::TransitionImageLayout(vk::Image srcImage, vk::ImageLayout old
 	//cmdBuffer.pipelineBarrier(srcStage, dstStage, vk::DependencyFlags(), nullptr, nullptr, &imageMemoryBarrier);
 	commandBuffer.pipelineBarrier(srcStage, dstStage, flags, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 
-	EndAndSubmitTransferCommandBuffer(commandBuffer);
+	if (bOwnCommandBuffer)
+		EndAndSubmitTransferCommandBuffer(commandBuffer);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::CreateBuffer(vk::DeviceSize bufferSize, vk::BufferUsageFlags usageFlags, vk::MemoryPropertyFlags memFlags,
-								UT::VkStructs::VulkanBuffer* pOutBuffer) const
+bool VulkanDevice::CreateBuffer(vk::DeviceSize bufferSize, vk::BufferUsageFlags usageFlags, vk::MemoryPropertyFlags memFlags,
+								UT::VkStructs::VulkanBuffer* pOutBuffer, MemoryPoolType poolType) const
 {
 	// Buffer creation info!
 	vk::BufferCreateInfo vbInfo;
@@ -667,67 +1034,71 @@ void VulkanDevice::CreateBuffer(vk::DeviceSize bufferSize, vk::BufferUsageFlags
 	// Buffer's memory requirements!
 	vk::MemoryRequirements memReq = m_vkDevice.getBufferMemoryRequirements(outBuffer);
 
-	// Allocate memory to buffer!
-	vk::MemoryAllocateInfo memAllocInfo;
-	memAllocInfo.allocationSize = memReq.size;
-	memAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(memReq.memoryTypeBits, memFlags);
-
-	vk::DeviceMemory outMemory = m_vkDevice.allocateMemory(memAllocInfo);
+	// Sub-allocate memory to buffer!
+	VulkanAllocation allocation;
+	if (!m_pMemoryAllocator->Allocate(memReq, memFlags, true, poolType, &allocation))
+	{
+		LOG_ERROR("Failed to allocate memory for buffer!");
+		m_vkDevice.destroyBuffer(outBuffer);
+		return false;
+	}
 
-	// Bind memory to given Vertex buffer
-	m_vkDevice.bindBufferMemory(outBuffer, outMemory, 0);
+	// Bind memory to given buffer
+	m_vkDevice.bindBufferMemory(outBuffer, allocation.deviceMemory, allocation.offset);
 
 	// Output buffer!
 	pOutBuffer->buffer = outBuffer;
-	pOutBuffer->deviceMemory = outMemory;
+	pOutBuffer->allocation = allocation;
+
+	return true;
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::BeginGraphicsCommandBuffer(uint32_t imageIndex, vk::CommandBufferBeginInfo cmdBufferBeginInfo) const
+void VulkanDevice::BeginGraphicsCommandBuffer(uint32_t frameIndex, vk::CommandBufferBeginInfo cmdBufferBeginInfo) const
 {
-	if (imageIndex > m_vkListGraphicsCommandBuffers.size())
+	if (frameIndex >= m_ListFrameContexts.size())
 	{
-		LOG_CRITICAL("Command buffer image index out of bound!");
+		LOG_CRITICAL("Command buffer frame index out of bound!");
 		return;
 	}
 		
-	m_vkListGraphicsCommandBuffers.at(imageIndex).begin(cmdBufferBeginInfo);
+	GetGraphicsCommandBuffer(frameIndex).begin(cmdBufferBeginInfo);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::EndGraphicsCommandBuffer(uint32_t imageIndex) const
+void VulkanDevice::EndGraphicsCommandBuffer(uint32_t frameIndex) const
 {
-	if (imageIndex > m_vkListGraphicsCommandBuffers.size())
+	if (frameIndex >= m_ListFrameContexts.size())
 	{
-		LOG_CRITICAL("Command buffer image index out of bound!");
+		LOG_CRITICAL("Command buffer frame index out of bound!");
 		return;
 	}
 
-	m_vkListGraphicsCommandBuffers.at(imageIndex).end();
+	GetGraphicsCommandBuffer(frameIndex).end();
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::BeginRenderPass(uint32_t imageIndex, vk::RenderPassBeginInfo renderPassInfo) const
+void VulkanDevice::BeginRenderPass(uint32_t frameIndex, vk::RenderPassBeginInfo renderPassInfo) const
 {
-	if (imageIndex > m_vkListGraphicsCommandBuffers.size())
+	if (frameIndex >= m_ListFrameContexts.size())
 	{
-		LOG_CRITICAL("Command buffer image index out of bound!");
+		LOG_CRITICAL("Command buffer frame index out of bound!");
 		return;
 	}
 
-	m_vkListGraphicsCommandBuffers.at(imageIndex).beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	GetGraphicsCommandBuffer(frameIndex).beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanDevice::EndRenderPass(uint32_t imageIndex) const
+void VulkanDevice::EndRenderPass(uint32_t frameIndex) const
 {
-	if (imageIndex > m_vkListGraphicsCommandBuffers.size())
+	if (frameIndex >= m_ListFrameContexts.size())
 	{
-		LOG_CRITICAL("Command buffer image index out of bound!");
+		LOG_CRITICAL("Command buffer frame index out of bound!");
 		return;
 	}
 
-	m_vkListGraphicsCommandBuffers.at(imageIndex).endRenderPass();
+	GetGraphicsCommandBuffer(frameIndex).endRenderPass();
 }
 
 
@@ -5,6 +5,16 @@
 class VulkanRenderer;
 class VulkanFramebuffer;
 class VulkanSwapchain;
+class VulkanStagingRing;
+class VulkanTextureCache;
+class VulkanMeshCache;
+class VulkanMeshPool;
+class VulkanSamplerCache;
+class VulkanUniformArena;
+class VulkanLayoutCache;
+class VulkanDescriptorAllocator;
+class VulkanBindlessTextures;
+class VulkanFrameContext;
 
 //---------------------------------------------------------------------------------------------------------------------
 struct QueueFamilyIndices
@@ -13,10 +23,12 @@ struct QueueFamilyIndices
 	{
 		graphicsFamily.reset();
 		presentFamily.reset();
+		transferFamily.reset();
 	}
 
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	std::optional<uint32_t> transferFamily;		// only set if device exposes a family without graphics support
 
 	bool UT_API isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
@@ -31,43 +43,62 @@ public:
 	bool									SetupDevice(vk::Instance vkInst, vk::SurfaceKHR vkSurface);
 	void									RecreateOnWindowResize();
 	void									Cleanup();
-	void									CleanupOnWindowsResize();
-	void									CreateCommandBuffers(const VulkanFramebuffer* pFrameBuffer);
 
 private:
 	bool									AcquirePhysicalDevice(vk::Instance vkInst, vk::SurfaceKHR vkSurface);
 	bool									CreateLogicalDevice();
+	bool									CreateFrameContexts();
 
 	bool									CheckInstanceExtensionSupport(const std::vector<const char*>& instanceExtensions);
 	bool									CheckDeviceExtensionSupport() const;
 	void									FetchQueueFamilies(vk::SurfaceKHR vkSurface);
-	uint32_t								FindMemoryTypeIndex(uint32_t allowedTypeIndex, vk::MemoryPropertyFlags props) const;
+	void									RetireImmediateSubmits(bool bWaitAll) const;
 
 public:
 	inline bool								IsQueueSharing() const							{ return (m_QueueFamilyIndices.graphicsFamily == m_QueueFamilyIndices.presentFamily); }
 	inline uint32_t							GetGraphicsQueueFamilyIndex() const				{ return m_QueueFamilyIndices.graphicsFamily.value(); }
 	inline uint32_t							GetPresentQueueFamilyIndex()  const				{ return m_QueueFamilyIndices.presentFamily.value();  }
-	inline vk::CommandBuffer			    GetGraphicsCommandBuffer(uint32_t index) const	{ return m_vkListGraphicsCommandBuffers[index]; }
+	inline uint32_t							GetTransferQueueFamilyIndex() const				{ return m_QueueFamilyIndices.transferFamily.value_or(m_QueueFamilyIndices.graphicsFamily.value()); }
+	inline bool								HasDedicatedTransferQueue() const				{ return m_QueueFamilyIndices.transferFamily.has_value(); }
+	inline uint32_t							GetFrameCount() const							{ return static_cast<uint32_t>(m_ListFrameContexts.size()); }
+	inline VulkanFrameContext*				GetFrameContext(uint32_t frameIndex) const		{ return m_ListFrameContexts[frameIndex]; }
+	vk::CommandBuffer						GetGraphicsCommandBuffer(uint32_t frameIndex) const;
 	inline vk::Queue						GetGraphicsQueue() const						{ return m_vkQueueGraphics; }
 	inline vk::Queue						GetPresentQueue() const							{ return m_vkQueuePresent; }
+	inline vk::Queue						GetTransferQueue() const						{ return m_vkQueueTransfer; }
 	inline vk::Device						GetDevice()	const								{ return m_vkDevice; }
 	inline vk::PhysicalDevice				GetPhysicalDevice() const						{ return m_vkPhysicalDevice;  }
-	inline uint16_t							GetSwapchainImageCount() const					{ return static_cast<uint32_t>(m_vkListGraphicsCommandBuffers.size()); }
+	inline VulkanMemoryAllocator*			GetMemoryAllocator() const						{ return m_pMemoryAllocator; }
+	inline VulkanStagingRing*				GetStagingRing() const							{ return m_pStagingRing; }
+	inline VulkanTextureCache*				GetTextureCache() const							{ return m_pTextureCache; }
+	inline VulkanMeshCache*					GetMeshCache() const							{ return m_pMeshCache; }
+	inline VulkanMeshPool*					GetMeshPool() const								{ return m_pMeshPool; }
+	inline VulkanSamplerCache*				GetSamplerCache() const							{ return m_pSamplerCache; }
+	inline VulkanUniformArena*				GetUniformArena() const							{ return m_pUniformArena; }
+	inline VulkanLayoutCache*				GetLayoutCache() const							{ return m_pLayoutCache; }
+	inline VulkanDescriptorAllocator*		GetDescriptorAllocator() const					{ return m_pDescriptorAllocator; }
+	inline VulkanBindlessTextures*			GetBindlessTextures() const						{ return m_pBindlessTextures; }
 
 public:
 	vk::ShaderModule						CreateShaderModule(const std::string& fileName) const;
 	vk::Format								ChooseSupportedFormat(const std::vector<vk::Format>& formats, vk::ImageTiling tiling, vk::FormatFeatureFlags featureFlags) const;
-	void									CopyBufferToImage(vk::Buffer srcBuffer, uint32_t width, uint32_t height, vk::Image* image) const;
-	void									CreateImage2D(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usageFlags, vk::MemoryPropertyFlags memoryPropertyFlags, vk::ImageAspectFlags aspectFlags, UT::VkStructs::VulkanImage* pOutImage2D) const;
-	void									CreateBuffer(vk::DeviceSize bufferSize, vk::BufferUsageFlags usageFlags, vk::MemoryPropertyFlags memFlags, UT::VkStructs::VulkanBuffer* pOutBuffer) const;
-	void									CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize bufferSize) const;
-	void									BeginGraphicsCommandBuffer(uint32_t imageIndex, vk::CommandBufferBeginInfo cmdBufferBeginInfo) const;
-	void									EndGraphicsCommandBuffer(uint32_t imageIndex) const;
-	void									BeginRenderPass(uint32_t imageIndex, vk::RenderPassBeginInfo renderPassInfo) const;
-	void									EndRenderPass(uint32_t imageIndex) const;
+	bool									CreateImage2D(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usageFlags, vk::MemoryPropertyFlags memoryPropertyFlags, vk::ImageAspectFlags aspectFlags, UT::VkStructs::VulkanImage* pOutImage2D, uint32_t mipLevels = 1) const;
+	bool									CreateBuffer(vk::DeviceSize bufferSize, vk::BufferUsageFlags usageFlags, vk::MemoryPropertyFlags memFlags, UT::VkStructs::VulkanBuffer* pOutBuffer, MemoryPoolType poolType = MemoryPoolType::POOL_FREE_LIST) const;
+	void									FlushUploads() const;
+	void									BeginGraphicsCommandBuffer(uint32_t frameIndex, vk::CommandBufferBeginInfo cmdBufferBeginInfo) const;
+	void									EndGraphicsCommandBuffer(uint32_t frameIndex) const;
+	void									BeginRenderPass(uint32_t frameIndex, vk::RenderPassBeginInfo renderPassInfo) const;
+	void									EndRenderPass(uint32_t frameIndex) const;
 	vk::CommandBuffer						BeginTransferCommandBuffer() const;
-	void									EndAndSubmitTransferCommandBuffer(vk::CommandBuffer commandBuffer) const;
-	void									BindPipeline(uint32_t imageIndex, vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline) const;
+	UT::VkStructs::UploadTicket				EndAndSubmitTransferCommandBuffer(vk::CommandBuffer commandBuffer) const;
+	UT::VkStructs::UploadTicket				UploadToBuffer(const void* pData, vk::DeviceSize size, vk::Buffer dstBuffer, vk::DeviceSize dstOffset = 0) const;
+	UT::VkStructs::UploadTicket				UploadToImage(const void* pData, vk::DeviceSize size, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips = false) const;
+	UT::VkStructs::UploadTicket				UploadImageLevels(const uint8_t* const* ppLevelData, const UT::VkStructs::VulkanImage& dstImage) const;
+	bool									IsUploadComplete(const UT::VkStructs::UploadTicket& ticket) const;
+	void									WaitForUpload(const UT::VkStructs::UploadTicket& ticket) const;
+	void									BindPipeline(uint32_t frameIndex, vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline) const;
+	bool									SupportsLinearBlit(vk::Format format) const;
+	void									GenerateMipChain(vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevels, vk::CommandBuffer cmdBuffer) const;
 	void									TransitionImageLayout(vk::Image srcImage, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::CommandBuffer cmdBuffer) const;
 
 private:
@@ -75,8 +106,33 @@ private:
 	vk::PhysicalDevice						m_vkPhysicalDevice;
 	vk::Queue								m_vkQueueGraphics;
 	vk::Queue								m_vkQueuePresent;
-	vk::CommandPool							m_vkGraphicsCommandPool;
-	std::vector<vk::CommandBuffer>			m_vkListGraphicsCommandBuffers;
+	vk::Queue								m_vkQueueTransfer;
+	std::vector<VulkanFrameContext*>		m_ListFrameContexts;	// one per frame in flight, not per swapchain image
 	QueueFamilyIndices						m_QueueFamilyIndices;	
+	VulkanMemoryAllocator*					m_pMemoryAllocator;
+	VulkanStagingRing*						m_pStagingRing;
+	VulkanTextureCache*						m_pTextureCache;
+	VulkanMeshCache*						m_pMeshCache;
+	VulkanMeshPool*							m_pMeshPool;
+	VulkanSamplerCache*						m_pSamplerCache;
+	VulkanUniformArena*						m_pUniformArena;
+	VulkanLayoutCache*						m_pLayoutCache;
+	VulkanDescriptorAllocator*				m_pDescriptorAllocator;
+	VulkanBindlessTextures*					m_pBindlessTextures;
+
+	// One-off command buffers (Begin/EndAndSubmitTransferCommandBuffer). Each comes with a transient pool of its own,
+	// reset wholesale once its timeline value is reached & recycled along with its buffer, nothing is freed per upload
+	struct ImmediateSubmit
+	{
+		vk::CommandPool						pool;
+		vk::CommandBuffer					cmdBuffer;
+		uint64_t							timelineValue;
+	};
+
+	vk::Semaphore							m_vkImmediateTimeline;
+	mutable uint64_t						m_uiImmediateTimelineValue;
+	mutable std::vector<ImmediateSubmit>	m_ListRecordingImmediateSubmits;	// begun, not submitted yet
+	mutable std::vector<ImmediateSubmit>	m_ListPendingImmediateSubmits;		// submitted, in order of timeline value
+	mutable std::vector<ImmediateSubmit>	m_ListFreeImmediateSubmits;
 };
 
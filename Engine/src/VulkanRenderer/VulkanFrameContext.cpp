@@ -0,0 +1,109 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanFrameContext.h"
+#include "VulkanDevice.h"
+#include "VulkanUniformArena.h"
+#include "VulkanDescriptorAllocator.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanFrameContext::VulkanFrameContext()
+{
+	m_pDevice = nullptr;
+	m_uiFrameIndex = 0;
+	m_vkCommandPool = nullptr;
+	m_vkCommandBuffer = nullptr;
+	m_vkFence = nullptr;
+	m_vkSemaphoreImageAvailable = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanFrameContext::~VulkanFrameContext()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanFrameContext::Initialize(const VulkanDevice* pDevice, uint32_t frameIndex)
+{
+	m_pDevice = pDevice;
+	m_uiFrameIndex = frameIndex;
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// Pool of our own, nobody else records from it while GPU might still be executing our buffer. No individual reset
+	// flag, whole pool goes back in one go!
+	vk::CommandPoolCreateInfo poolInfo = {};
+	poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+	poolInfo.queueFamilyIndex = m_pDevice->GetGraphicsQueueFamilyIndex();
+
+	m_vkCommandPool = vkDevice.createCommandPool(poolInfo);
+
+	vk::CommandBufferAllocateInfo cbAllocInfo = {};
+	cbAllocInfo.commandPool = m_vkCommandPool;
+	cbAllocInfo.level = vk::CommandBufferLevel::ePrimary;
+	cbAllocInfo.commandBufferCount = 1;
+
+	m_vkCommandBuffer = vkDevice.allocateCommandBuffers(cbAllocInfo).front();
+
+	// Signalled, so first wait on it returns right away
+	vk::FenceCreateInfo fenceCreateInfo = {};
+	fenceCreateInfo.flags = vk::FenceCreateFlagBits::eSignaled;
+
+	m_vkFence = vkDevice.createFence(fenceCreateInfo);
+	m_vkSemaphoreImageAvailable = vkDevice.createSemaphore(vk::SemaphoreCreateInfo());
+
+	CHECK_LOG(m_vkCommandPool && m_vkCommandBuffer && m_vkFence && m_vkSemaphoreImageAvailable, "Failed to create frame context!");
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanFrameContext::Cleanup()
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// Buffer goes away with its pool
+	vkDevice.destroyCommandPool(m_vkCommandPool);
+
+	vkDevice.destroyFence(m_vkFence);
+	vkDevice.destroySemaphore(m_vkSemaphoreImageAvailable);
+
+	m_vkCommandPool = nullptr;
+	m_vkCommandBuffer = nullptr;
+	m_vkFence = nullptr;
+	m_vkSemaphoreImageAvailable = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanFrameContext::WaitForGPU() const
+{
+	// Timeout only gives us a chance to complain, reusing frame's resources before the fence is signalled isn't an option
+	vk::Result result = vk::Result::eTimeout;
+	while (result == vk::Result::eTimeout)
+	{
+		result = m_pDevice->GetDevice().waitForFences(m_vkFence, true, UT::VkGlobals::GFenceTimeout);
+		if (result == vk::Result::eTimeout)
+			LOG_WARNING("Frame {0} : still waiting on GPU...", m_uiFrameIndex);
+	}
+
+	if (result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Frame {0} : waiting on fence failed!", m_uiFrameIndex);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanFrameContext::Begin()
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// Only once something is surely going to be submitted, an unsignalled fence nobody submits would hang next wait!
+	vkDevice.resetFences(m_vkFence);
+
+	// Primary buffer back to initial state, memory stays with the pool for this frame's recording
+	vkDevice.resetCommandPool(m_vkCommandPool);
+
+	// GPU is done with everything this frame wrote last time around
+	m_pDevice->GetDescriptorAllocator()->BeginFrame(m_uiFrameIndex);
+	m_pDevice->GetUniformArena()->BeginFrame(m_uiFrameIndex);
+}
+
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything CPU writes while recording a frame, one context per frame in flight (GMaxFramesDraws) no matter how many
+// images swapchain has. Context's fence is signalled once GPU is done with the frame, only after waiting on it are its
+// command buffer, its slice of uniform arena, its transient descriptor pools & culling buffers free to reuse.
+// Swapchain image is only a render target picked by acquire!
+//
+// Frame index doubles as index into per frame storage of uniform arena, descriptor allocator & culling pass.
+//
+// Command pool is transient & reset wholesale by Begin(), its primary buffer is never reset or freed on its own. Only
+// main thread records into it.
+class UT_API VulkanFrameContext
+{
+public:
+	VulkanFrameContext();
+	~VulkanFrameContext();
+
+	bool								Initialize(const VulkanDevice* pDevice, uint32_t frameIndex);
+	void								Cleanup();
+
+	void								WaitForGPU() const;
+	void								Begin();
+
+	inline uint32_t						GetFrameIndex() const							{ return m_uiFrameIndex; }
+	inline vk::CommandBuffer			GetCommandBuffer() const						{ return m_vkCommandBuffer; }
+	inline vk::Fence					GetFence() const								{ return m_vkFence; }
+	inline vk::Semaphore				GetImageAvailableSemaphore() const				{ return m_vkSemaphoreImageAvailable; }
+
+private:
+	const VulkanDevice*					m_pDevice;
+	uint32_t							m_uiFrameIndex;
+
+	vk::CommandPool						m_vkCommandPool;
+	vk::CommandBuffer					m_vkCommandBuffer;				// primary, from m_vkCommandPool
+	vk::Fence							m_vkFence;						// signalled by frame's submit
+	vk::Semaphore						m_vkSemaphoreImageAvailable;	// signalled by acquire, waited on by submit
+};
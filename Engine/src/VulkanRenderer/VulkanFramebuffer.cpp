@@ -21,7 +21,7 @@ VulkanFramebuffer::~VulkanFramebuffer()
 
 //-----------------------------------------------------------------------------------------------------------------------
 // Note: think about sending VulkanSwapchain* instead of Vulkan handles!
-void VulkanFramebuffer::CreateFramebuffersAttachments(const VulkanDevice* pDevice, const VulkanSwapchain* pSwapchain)
+bool VulkanFramebuffer::CreateFramebuffersAttachments(const VulkanDevice* pDevice, const VulkanSwapchain* pSwapchain)
 {
 	const vk::Format imgFormat = pSwapchain->GetSwapchainImageFormat();
 	const vk::Extent2D imgExtent = pSwapchain->GetSwapchainExtent();
@@ -38,9 +38,11 @@ void VulkanFramebuffer::CreateFramebuffersAttachments(const VulkanDevice* pDevic
 	}
 
 	// Create Depth buffer attachment!
-	CreateDepthBufferAttachment(pDevice, imgExtent.width, imgExtent.height, m_DepthAttachment);
+	CHECK_LOG(CreateDepthBufferAttachment(pDevice, imgExtent.width, imgExtent.height, m_DepthAttachment), "Depth buffer creation FAILED!");
 
 	LOG_INFO("Framebuffer attachments created");
+
+	return true;
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -77,18 +79,18 @@ void VulkanFramebuffer::CreateFramebuffers(const VulkanDevice* pDevice, vk::Rend
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
-void VulkanFramebuffer::CreateDepthBufferAttachment(const VulkanDevice* pDevice, uint32_t width, uint32_t height, UT::VkStructs::VulkanImage& depthImage)
+bool VulkanFramebuffer::CreateDepthBufferAttachment(const VulkanDevice* pDevice, uint32_t width, uint32_t height, UT::VkStructs::VulkanImage& depthImage)
 {
 	// List of depth formats we need
 	const std::vector<vk::Format> depthFormats = { vk::Format::eD32SfloatS8Uint, vk::Format::eD32Sfloat, vk::Format::eD24UnormS8Uint };
 
-	// Choose the supported format
-	const vk::Format chosenFormat = pDevice->ChooseSupportedFormat(depthFormats, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+	// Choose the supported format, culling pass builds its HiZ pyramid out of it so it has to be sampled too!
+	const vk::Format chosenFormat = pDevice->ChooseSupportedFormat(depthFormats, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage);
 
 	// Create depth image
-	pDevice->CreateImage2D(width, height,
+	return pDevice->CreateImage2D(width, height,
 		chosenFormat, vk::ImageTiling::eOptimal,
-		vk::ImageUsageFlagBits::eDepthStencilAttachment,
+		vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
 		vk::MemoryPropertyFlagBits::eDeviceLocal,
 		vk::ImageAspectFlagBits::eDepth,
 		&depthImage);
@@ -5,6 +5,7 @@
 #include "../EngineHeader.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "VulkanMemoryAllocator.h"
 
 namespace UT
 {
@@ -12,6 +13,31 @@ namespace UT
 	{
 		constexpr uint16_t		GMaxFramesDraws = 3;
 		constexpr uint64_t		GFenceTimeout = 100000000;
+		constexpr uint64_t		GStagingRingSize = 64 * 1024 * 1024;
+		constexpr uint32_t		GMaxMipLevels = 16;					// 32K x 32K, enough for anything we load
+		constexpr uint32_t		GMaxUniformBlockSize = 16 * 1024;	// range of arena's dynamic UBO binding, no block can be bigger! (spec's minimum maxUniformBufferRange)
+		constexpr uint32_t		GMaxMaterialsPerFrame = 256;		// material block is one array in arena, indexed by instance's material index
+		constexpr uint32_t		GMaxBindlessTextures = 4096;		// slots in global texture table, clamped to device's update-after-bind limits
+		constexpr uint32_t		GMeshPoolMaxVertices = 512 * 1024;	// shared vertex buffer of every mesh, 28 MB of VertexPNTBT
+		constexpr uint32_t		GMeshPoolMaxIndices = 2 * 1024 * 1024;	// shared index buffer of every mesh, 8 MB
+		constexpr uint32_t		GMaxCulledInstances = 64 * 1024;	// per frame, culling pass' output instance buffer is 6 MB of InstanceData
+		constexpr uint32_t		GMaxCulledDraws = 4096;				// per frame, a draw per distinct mesh in the scene
+		constexpr uint32_t		GInstanceDataSize = 96;				// sizeof(InstanceData), checked where it's declared
+		constexpr uint32_t		GMaxUniformBlocksPerFrame = 3;		// view, material & cull blocks
+		constexpr uint32_t		GMaxArenaAlignment = 256;			// spec's maximum minUniformBufferOffsetAlignment
+
+		//--- per frame, sized so every instance & draw culling pass can take fits in. Draws are indirect command plus a
+		//--- bounding sphere, every allocation pays alignment at worst & uniform blocks need their whole binding range!
+		constexpr uint64_t		GUniformArenaSize = static_cast<uint64_t>(GMaxCulledInstances) * GInstanceDataSize +
+													static_cast<uint64_t>(GMaxCulledDraws) * (sizeof(vk::DrawIndexedIndirectCommand) + sizeof(glm::vec4)) +
+													static_cast<uint64_t>(GMaxUniformBlocksPerFrame) * GMaxUniformBlockSize +
+													(GMaxUniformBlocksPerFrame + 3) * GMaxArenaAlignment;
+		constexpr uint32_t		GCullWorkgroupSize = 64;			// must match local_size_x of cull.comp
+		constexpr uint32_t		GHiZWorkgroupSize = 8;				// must match local_size_x & y of hiz.comp
+
+		//--- graphics stages which consume uploaded data, frame waits on transfer timeline at these stages. Transfer is
+		//--- there for mip chains blitted on graphics queue right after acquire!
+		constexpr vk::PipelineStageFlags GUploadAcquireStages = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
 		
 		inline glm::vec2		GCurrentResolution = glm::vec2(0, 0);
 
@@ -31,21 +57,22 @@ namespace UT
 			{
 				image = nullptr;
 				imageView = nullptr;
-				deviceMemory = nullptr;
+				mipLevels = 1;
 			}
 
 			vk::Image			image;
 			vk::ImageView		imageView;
-			vk::DeviceMemory	deviceMemory;
+			VulkanAllocation	allocation;
 
 			vk::Format			format;
 			vk::Extent2D		extent;
+			uint32_t			mipLevels;
 
 			void	DestroyAll(vk::Device device)
 			{
 				device.destroyImageView(imageView);
 				device.destroyImage(image);
-				device.freeMemory(deviceMemory);
+				allocation.Free();
 			}
 
 			void	DestroyImageView(vk::Device device)
@@ -60,18 +87,34 @@ namespace UT
 			VulkanBuffer()
 			{
 				buffer = nullptr;
-				deviceMemory = nullptr;
 			}
 
 			vk::Buffer			buffer;
-			vk::DeviceMemory	deviceMemory;
+			VulkanAllocation	allocation;
 
 			void	DestroyAll(vk::Device device)
 			{
 				device.destroyBuffer(buffer);
-				device.freeMemory(deviceMemory);
+				allocation.Free();
 			}
 		};
+
+		//---------------------------------------------------------------------------------------------------------------------
+		// Returned by every upload. Upload is done once the timeline semaphore reaches value, only then its source
+		// memory is reused & destination is safe to destroy or read on the CPU.
+		struct UploadTicket
+		{
+			UploadTicket()
+			{
+				timeline = nullptr;
+				value = 0;
+			}
+
+			vk::Semaphore		timeline;
+			uint64_t			value;
+
+			inline bool	IsValid() const		{ return timeline != vk::Semaphore(nullptr); }
+		};
 	}
 
 	namespace VkUtility
@@ -110,6 +153,60 @@ namespace UT
 
 			return hasExtension;
 		}
+
+		//---------------------------------------------------------------------------------------------------------------------
+		// Size of one texel block in bytes & its dimension in texels. Uncompressed formats are 1x1 "blocks".
+		inline UT_API uint32_t GetFormatBlockSize(vk::Format format, uint32_t* pBlockDim)
+		{
+			*pBlockDim = 1;
+
+			switch (format)
+			{
+				case vk::Format::eBc1RgbUnormBlock:
+				case vk::Format::eBc1RgbSrgbBlock:
+				case vk::Format::eBc1RgbaUnormBlock:
+				case vk::Format::eBc1RgbaSrgbBlock:
+				case vk::Format::eBc4UnormBlock:
+				case vk::Format::eBc4SnormBlock:
+					*pBlockDim = 4;
+					return 8;
+
+				case vk::Format::eBc2UnormBlock:
+				case vk::Format::eBc2SrgbBlock:
+				case vk::Format::eBc3UnormBlock:
+				case vk::Format::eBc3SrgbBlock:
+				case vk::Format::eBc5UnormBlock:
+				case vk::Format::eBc5SnormBlock:
+				case vk::Format::eBc6HUfloatBlock:
+				case vk::Format::eBc6HSfloatBlock:
+				case vk::Format::eBc7UnormBlock:
+				case vk::Format::eBc7SrgbBlock:
+					*pBlockDim = 4;
+					return 16;
+
+				case vk::Format::eR32G32B32A32Sfloat:
+					return 16;
+
+				case vk::Format::eR16G16B16A16Sfloat:
+					return 8;
+
+				default:
+					return 4;
+			}
+		}
+
+		//---------------------------------------------------------------------------------------------------------------------
+		// Bytes taken by one mip level, tightly packed (the way staging ring & texture containers lay them out)
+		inline UT_API vk::DeviceSize GetImageLevelSize(vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevel)
+		{
+			uint32_t blockDim = 1;
+			const uint32_t blockSize = GetFormatBlockSize(format, &blockDim);
+
+			const uint32_t mipWidth = std::max(width >> mipLevel, 1u);
+			const uint32_t mipHeight = std::max(height >> mipLevel, 1u);
+
+			return static_cast<vk::DeviceSize>((mipWidth + blockDim - 1) / blockDim) * ((mipHeight + blockDim - 1) / blockDim) * blockSize;
+		}
 	}
 }
 
@@ -0,0 +1,204 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanLayoutCache.h"
+#include "VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+template<typename T>
+static void HashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanLayoutCache::SetLayoutKey::operator==(const SetLayoutKey& rhs) const
+{
+	if (listBindings.size() != rhs.listBindings.size())
+		return false;
+
+	for (uint32_t i = 0; i < listBindings.size(); ++i)
+	{
+		const vk::DescriptorSetLayoutBinding& a = listBindings[i];
+		const vk::DescriptorSetLayoutBinding& b = rhs.listBindings[i];
+
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanLayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& rhs) const
+{
+	if (listSetLayouts != rhs.listSetLayouts || listPushConstantRanges.size() != rhs.listPushConstantRanges.size())
+		return false;
+
+	for (uint32_t i = 0; i < listPushConstantRanges.size(); ++i)
+	{
+		const vk::PushConstantRange& a = listPushConstantRanges[i];
+		const vk::PushConstantRange& b = rhs.listPushConstantRanges[i];
+
+		if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size)
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t VulkanLayoutCache::SetLayoutKeyHash::operator()(const SetLayoutKey& key) const
+{
+	size_t seed = 0;
+
+	for (const vk::DescriptorSetLayoutBinding& binding : key.listBindings)
+	{
+		HashCombine(seed, binding.binding);
+		HashCombine(seed, static_cast<uint32_t>(binding.descriptorType));
+		HashCombine(seed, binding.descriptorCount);
+		HashCombine(seed, static_cast<uint32_t>(binding.stageFlags));
+	}
+
+	return seed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t VulkanLayoutCache::PipelineLayoutKeyHash::operator()(const PipelineLayoutKey& key) const
+{
+	size_t seed = 0;
+
+	for (const vk::DescriptorSetLayout setLayout : key.listSetLayouts)
+	{
+		HashCombine(seed, static_cast<VkDescriptorSetLayout>(setLayout));
+	}
+
+	for (const vk::PushConstantRange& range : key.listPushConstantRanges)
+	{
+		HashCombine(seed, static_cast<uint32_t>(range.stageFlags));
+		HashCombine(seed, range.offset);
+		HashCombine(seed, range.size);
+	}
+
+	return seed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanLayoutCache::VulkanLayoutCache()
+{
+	m_pDevice = nullptr;
+	m_umapSetLayouts.clear();
+	m_umapPipelineLayouts.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanLayoutCache::~VulkanLayoutCache()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanLayoutCache::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanLayoutCache::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	LOG_DEBUG("Layout cache : destroying {0} pipeline layout(s) & {1} descriptor set layout(s)", m_umapPipelineLayouts.size(), m_umapSetLayouts.size());
+
+	// Pipeline layouts first, they were made out of set layouts
+	for (const std::pair<const PipelineLayoutKey, vk::PipelineLayout>& pipelineLayout : m_umapPipelineLayouts)
+	{
+		m_pDevice->GetDevice().destroyPipelineLayout(pipelineLayout.second);
+	}
+
+	for (const std::pair<const SetLayoutKey, vk::DescriptorSetLayout>& setLayout : m_umapSetLayouts)
+	{
+		m_pDevice->GetDevice().destroyDescriptorSetLayout(setLayout.second);
+	}
+
+	m_umapPipelineLayouts.clear();
+	m_umapSetLayouts.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DescriptorSetLayout VulkanLayoutCache::GetDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& listBindings)
+{
+	// Binding order in create info doesn't matter to Vulkan, so it shouldn't matter to the key either
+	SetLayoutKey key;
+	key.listBindings = listBindings;
+	std::sort(key.listBindings.begin(), key.listBindings.end(), [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b)
+	{
+		return a.binding < b.binding;
+	});
+
+	for (const vk::DescriptorSetLayoutBinding& binding : key.listBindings)
+	{
+		UT_ASSERT_BOOL((binding.pImmutableSamplers == nullptr), "Layout cache can't key immutable samplers!");
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const auto iter = m_umapSetLayouts.find(key);
+	if (iter != m_umapSetLayouts.end())
+		return iter->second;
+
+	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(key.listBindings.size());
+	layoutCreateInfo.pBindings = key.listBindings.data();
+
+	const vk::DescriptorSetLayout vkSetLayout = m_pDevice->GetDevice().createDescriptorSetLayout(layoutCreateInfo);
+	m_umapSetLayouts.emplace(key, vkSetLayout);
+
+	LOG_DEBUG("Layout cache : created descriptor set layout #{0}", m_umapSetLayouts.size());
+
+	return vkSetLayout;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::PipelineLayout VulkanLayoutCache::GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& listSetLayouts, const std::vector<vk::PushConstantRange>& listPushConstantRanges)
+{
+	// Set layouts come from this cache, so same handle means same layout & handles are good enough as key
+	PipelineLayoutKey key;
+	key.listSetLayouts = listSetLayouts;
+	key.listPushConstantRanges = listPushConstantRanges;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const auto iter = m_umapPipelineLayouts.find(key);
+	if (iter != m_umapPipelineLayouts.end())
+		return iter->second;
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(key.listSetLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = key.listSetLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(key.listPushConstantRanges.size());
+	pipelineLayoutCreateInfo.pPushConstantRanges = key.listPushConstantRanges.data();
+
+	const vk::PipelineLayout vkPipelineLayout = m_pDevice->GetDevice().createPipelineLayout(pipelineLayoutCreateInfo);
+	m_umapPipelineLayouts.emplace(key, vkPipelineLayout);
+
+	LOG_DEBUG("Layout cache : created pipeline layout #{0}", m_umapPipelineLayouts.size());
+
+	return vkPipelineLayout;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanLayoutCache::GetDescriptorSetLayoutCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return static_cast<uint32_t>(m_umapSetLayouts.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanLayoutCache::GetPipelineLayoutCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return static_cast<uint32_t>(m_umapPipelineLayouts.size());
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Descriptor set layouts & pipeline layouts are pure descriptions, every object of a kind asks for identical ones.
+// Cache creates one per unique description & hands out same handle to everyone, identical layouts are then trivially
+// compatible too. All of them live till device cleanup, so users never destroy layouts they got from here!
+class UT_API VulkanLayoutCache
+{
+public:
+	VulkanLayoutCache();
+	~VulkanLayoutCache();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	vk::DescriptorSetLayout				GetDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& listBindings);
+	vk::PipelineLayout					GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& listSetLayouts, const std::vector<vk::PushConstantRange>& listPushConstantRanges);
+
+	uint32_t							GetDescriptorSetLayoutCount() const;
+	uint32_t							GetPipelineLayoutCount() const;
+
+private:
+	struct SetLayoutKey
+	{
+		std::vector<vk::DescriptorSetLayoutBinding>	listBindings;				// sorted by binding
+
+		bool							operator==(const SetLayoutKey& rhs) const;
+	};
+
+	struct PipelineLayoutKey
+	{
+		std::vector<vk::DescriptorSetLayout>		listSetLayouts;
+		std::vector<vk::PushConstantRange>			listPushConstantRanges;
+
+		bool							operator==(const PipelineLayoutKey& rhs) const;
+	};
+
+	struct SetLayoutKeyHash
+	{
+		size_t							operator()(const SetLayoutKey& key) const;
+	};
+
+	struct PipelineLayoutKeyHash
+	{
+		size_t							operator()(const PipelineLayoutKey& key) const;
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	std::unordered_map<SetLayoutKey, vk::DescriptorSetLayout, SetLayoutKeyHash>				m_umapSetLayouts;
+	std::unordered_map<PipelineLayoutKey, vk::PipelineLayout, PipelineLayoutKeyHash>		m_umapPipelineLayouts;
+
+	mutable std::mutex					m_Mutex;
+};
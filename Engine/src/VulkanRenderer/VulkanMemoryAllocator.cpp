@@ -0,0 +1,465 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanMemoryAllocator.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Default block sizes, clamped to 1/8th of the heap for small heaps (integrated GPUs, BAR memory etc.)
+constexpr vk::DeviceSize GDeviceLocalBlockSize = 64 * 1024 * 1024;
+constexpr vk::DeviceSize GHostVisibleBlockSize = 16 * 1024 * 1024;
+
+//---------------------------------------------------------------------------------------------------------------------
+static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	// Vulkan guarantees alignment to be power of 2!
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// One vk::DeviceMemory allocation which is carved up into many VulkanAllocation ranges.
+class VulkanMemoryBlock
+{
+public:
+	VulkanMemoryBlock(vk::DeviceMemory memory, vk::DeviceSize blockSize, uint32_t typeIndex, uint32_t pool, MemoryPoolType type, bool dedicated)
+	{
+		deviceMemory = memory;
+		size = blockSize;
+		memoryTypeIndex = typeIndex;
+		poolIndex = pool;
+		poolType = type;
+		bDedicated = dedicated;
+
+		linearHead = 0;
+		allocationCount = 0;
+		bytesUsed = 0;
+
+		pMapped = nullptr;
+		mapCount = 0;
+
+		// whole block is one big hole to begin with!
+		mapFreeRanges.insert(std::make_pair(0, blockSize));
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	bool TryAllocate(vk::DeviceSize allocSize, vk::DeviceSize alignment, vk::DeviceSize* pOutOffset)
+	{
+		if (poolType == MemoryPoolType::POOL_LINEAR)
+		{
+			const vk::DeviceSize alignedOffset = AlignUp(linearHead, alignment);
+			if (alignedOffset + allocSize > size)
+				return false;
+
+			linearHead = alignedOffset + allocSize;
+			*pOutOffset = alignedOffset;
+		}
+		else
+		{
+			// Best fit : pick the hole which leaves the least amount of space behind after alignment!
+			std::map<vk::DeviceSize, vk::DeviceSize>::iterator bestIter = mapFreeRanges.end();
+			vk::DeviceSize bestLeftover = std::numeric_limits<vk::DeviceSize>::max();
+
+			std::map<vk::DeviceSize, vk::DeviceSize>::iterator iter = mapFreeRanges.begin();
+			for (; iter != mapFreeRanges.end(); ++iter)
+			{
+				const vk::DeviceSize alignedOffset = AlignUp(iter->first, alignment);
+				const vk::DeviceSize rangeEnd = iter->first + iter->second;
+
+				if (alignedOffset + allocSize > rangeEnd)
+					continue;
+
+				const vk::DeviceSize leftover = rangeEnd - (alignedOffset + allocSize);
+				if (leftover < bestLeftover)
+				{
+					bestLeftover = leftover;
+					bestIter = iter;
+
+					if (leftover == 0)
+						break;
+				}
+			}
+
+			if (bestIter == mapFreeRanges.end())
+				return false;
+
+			const vk::DeviceSize rangeOffset = bestIter->first;
+			const vk::DeviceSize rangeEnd = bestIter->first + bestIter->second;
+			const vk::DeviceSize alignedOffset = AlignUp(rangeOffset, alignment);
+
+			mapFreeRanges.erase(bestIter);
+
+			// Give back the padding in front & the tail as separate holes
+			if (alignedOffset > rangeOffset)
+				mapFreeRanges.insert(std::make_pair(rangeOffset, alignedOffset - rangeOffset));
+
+			if (alignedOffset + allocSize < rangeEnd)
+				mapFreeRanges.insert(std::make_pair(alignedOffset + allocSize, rangeEnd - (alignedOffset + allocSize)));
+
+			*pOutOffset = alignedOffset;
+		}
+
+		++allocationCount;
+		bytesUsed += allocSize;
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	void Release(vk::DeviceSize offset, vk::DeviceSize allocSize)
+	{
+		--allocationCount;
+		bytesUsed -= allocSize;
+
+		if (poolType == MemoryPoolType::POOL_LINEAR)
+		{
+			// Linear blocks are recycled as a whole once everything inside is gone
+			if (allocationCount == 0)
+				linearHead = 0;
+
+			return;
+		}
+
+		std::map<vk::DeviceSize, vk::DeviceSize>::iterator iter = mapFreeRanges.insert(std::make_pair(offset, allocSize)).first;
+
+		// Merge with the next hole...
+		std::map<vk::DeviceSize, vk::DeviceSize>::iterator nextIter = std::next(iter);
+		if (nextIter != mapFreeRanges.end() && iter->first + iter->second == nextIter->first)
+		{
+			iter->second += nextIter->second;
+			mapFreeRanges.erase(nextIter);
+		}
+
+		// ...& with the previous one!
+		if (iter != mapFreeRanges.begin())
+		{
+			std::map<vk::DeviceSize, vk::DeviceSize>::iterator prevIter = std::prev(iter);
+			if (prevIter->first + prevIter->second == iter->first)
+			{
+				prevIter->second += iter->second;
+				mapFreeRanges.erase(iter);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	vk::DeviceMemory							deviceMemory;
+	vk::DeviceSize								size;
+	uint32_t									memoryTypeIndex;
+	uint32_t									poolIndex;
+	MemoryPoolType								poolType;
+	bool										bDedicated;
+
+	std::map<vk::DeviceSize, vk::DeviceSize>	mapFreeRanges;		// FREE_LIST : offset -> size of every hole, sorted so neighbours can merge
+	vk::DeviceSize								linearHead;			// LINEAR : bump pointer
+
+	uint32_t									allocationCount;
+	vk::DeviceSize								bytesUsed;
+
+	void*										pMapped;			// whole block is mapped once, shared by all allocations inside
+	uint32_t									mapCount;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMemoryAllocator::VulkanMemoryAllocator(vk::Device vkDevice, vk::PhysicalDevice vkPhysicalDevice)
+{
+	m_vkDevice = vkDevice;
+	m_vkMemoryProperties = vkPhysicalDevice.getMemoryProperties();
+
+	// [memory type][linear/optimal][pool type]
+	m_ListPools.resize(m_vkMemoryProperties.memoryTypeCount * 2 * static_cast<uint32_t>(MemoryPoolType::POOL_END));
+	m_ListDedicatedBlocks.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+	const MemoryAllocatorStats stats = GetStats();
+	if (stats.allocationCount > 0)
+	{
+		LOG_WARNING("Memory Allocator destroyed with {0} live allocations ({1} bytes)!", stats.allocationCount, stats.bytesUsed);
+	}
+
+	for (std::vector<VulkanMemoryBlock*>& pool : m_ListPools)
+	{
+		for (VulkanMemoryBlock* pBlock : pool)
+		{
+			DestroyBlock(pBlock);
+		}
+
+		pool.clear();
+	}
+
+	for (VulkanMemoryBlock* pBlock : m_ListDedicatedBlocks)
+	{
+		DestroyBlock(pBlock);
+	}
+
+	m_ListDedicatedBlocks.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanMemoryAllocator::Allocate(const vk::MemoryRequirements& memReqs, vk::MemoryPropertyFlags memFlags, bool bLinearResource,
+									 MemoryPoolType poolType, VulkanAllocation* pOutAllocation)
+{
+	const uint32_t memoryTypeIndex = FindMemoryTypeIndex(memReqs.memoryTypeBits, memFlags);
+	CHECK_LOG(memoryTypeIndex != UINT32_MAX, "Failed to find suitable memory type!");
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const vk::DeviceSize blockSize = GetPreferredBlockSize(memoryTypeIndex);
+	VulkanMemoryBlock* pAllocatedBlock = nullptr;
+	vk::DeviceSize offset = 0;
+
+	if (memReqs.size > blockSize / 2)
+	{
+		// Too big to share, give it its own memory!
+		pAllocatedBlock = CreateBlock(memoryTypeIndex, memReqs.size, UINT32_MAX, MemoryPoolType::POOL_FREE_LIST, true);
+		CHECK(pAllocatedBlock);
+		pAllocatedBlock->TryAllocate(memReqs.size, memReqs.alignment, &offset);
+
+		m_ListDedicatedBlocks.push_back(pAllocatedBlock);
+	}
+	else
+	{
+		const uint32_t poolIndex = GetPoolIndex(memoryTypeIndex, bLinearResource, poolType);
+		std::vector<VulkanMemoryBlock*>& pool = m_ListPools[poolIndex];
+
+		for (VulkanMemoryBlock* pBlock : pool)
+		{
+			if (pBlock->TryAllocate(memReqs.size, memReqs.alignment, &offset))
+			{
+				pAllocatedBlock = pBlock;
+				break;
+			}
+		}
+
+		// No block had space, grow the pool!
+		if (pAllocatedBlock == nullptr)
+		{
+			pAllocatedBlock = CreateBlock(memoryTypeIndex, blockSize, poolIndex, poolType, false);
+			CHECK(pAllocatedBlock);
+			CHECK_LOG(pAllocatedBlock->TryAllocate(memReqs.size, memReqs.alignment, &offset), "Fresh memory block can't fit allocation!");
+
+			pool.push_back(pAllocatedBlock);
+		}
+	}
+
+	pOutAllocation->deviceMemory = pAllocatedBlock->deviceMemory;
+	pOutAllocation->offset = offset;
+	pOutAllocation->size = memReqs.size;
+	pOutAllocation->memoryTypeIndex = memoryTypeIndex;
+	pOutAllocation->pBlock = pAllocatedBlock;
+	pOutAllocation->pAllocator = this;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+{
+	if (allocation.pBlock == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* pBlock = allocation.pBlock;
+	pBlock->Release(allocation.offset, allocation.size);
+
+	if (pBlock->bDedicated)
+	{
+		m_ListDedicatedBlocks.erase(std::remove(m_ListDedicatedBlocks.begin(), m_ListDedicatedBlocks.end(), pBlock), m_ListDedicatedBlocks.end());
+		DestroyBlock(pBlock);
+	}
+	else if (pBlock->allocationCount == 0)
+	{
+		// Keep one empty block around per pool so that alloc/free patterns don't hammer vkAllocateMemory
+		std::vector<VulkanMemoryBlock*>& pool = m_ListPools[pBlock->poolIndex];
+		const bool bHasOtherEmptyBlock = std::any_of(pool.begin(), pool.end(), [pBlock](const VulkanMemoryBlock* pOther)
+		{
+			return pOther != pBlock && pOther->allocationCount == 0;
+		});
+
+		if (bHasOtherEmptyBlock)
+		{
+			pool.erase(std::remove(pool.begin(), pool.end(), pBlock), pool.end());
+			DestroyBlock(pBlock);
+		}
+	}
+
+	allocation = VulkanAllocation();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void* VulkanMemoryAllocator::Map(const VulkanAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* pBlock = allocation.pBlock;
+
+	// vkMapMemory can't be called twice on the same memory object, so block is mapped once & ref-counted!
+	if (pBlock->mapCount == 0)
+	{
+		pBlock->pMapped = m_vkDevice.mapMemory(pBlock->deviceMemory, 0, VK_WHOLE_SIZE);
+	}
+
+	++pBlock->mapCount;
+
+	return static_cast<uint8_t*>(pBlock->pMapped) + allocation.offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMemoryAllocator::Unmap(const VulkanAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* pBlock = allocation.pBlock;
+	if (pBlock->mapCount == 0)
+	{
+		LOG_ERROR("Unmapping memory which was never mapped!");
+		return;
+	}
+
+	--pBlock->mapCount;
+
+	if (pBlock->mapCount == 0)
+	{
+		m_vkDevice.unmapMemory(pBlock->deviceMemory);
+		pBlock->pMapped = nullptr;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanMemoryAllocator::FindMemoryTypeIndex(uint32_t allowedTypeIndex, vk::MemoryPropertyFlags props) const
+{
+	for (uint32_t i = 0; i < m_vkMemoryProperties.memoryTypeCount; i++)
+	{
+		if ((allowedTypeIndex & (1 << i))																		// Index of memory type must match corresponding bit in allowed types!
+			&& (m_vkMemoryProperties.memoryTypes[i].propertyFlags & props) == props)							// Desired property bit flags are part of the memory type's property flags!
+		{
+			// This memory type is valid, so return index!
+			return i;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+MemoryAllocatorStats VulkanMemoryAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	MemoryAllocatorStats stats;
+	vk::DeviceSize totalFree = 0;
+
+	const auto accumulateBlock = [&stats, &totalFree](const VulkanMemoryBlock* pBlock)
+	{
+		++stats.blockCount;
+		stats.allocationCount += pBlock->allocationCount;
+		stats.bytesReserved += pBlock->size;
+		stats.bytesUsed += pBlock->bytesUsed;
+
+		if (pBlock->poolType == MemoryPoolType::POOL_LINEAR)
+		{
+			const vk::DeviceSize tail = pBlock->size - pBlock->linearHead;
+			totalFree += tail;
+			stats.largestFreeRange = std::max(stats.largestFreeRange, tail);
+			++stats.freeRangeCount;
+		}
+		else
+		{
+			for (const std::pair<const vk::DeviceSize, vk::DeviceSize>& range : pBlock->mapFreeRanges)
+			{
+				totalFree += range.second;
+				stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+				++stats.freeRangeCount;
+			}
+		}
+	};
+
+	for (const std::vector<VulkanMemoryBlock*>& pool : m_ListPools)
+	{
+		for (const VulkanMemoryBlock* pBlock : pool)
+		{
+			accumulateBlock(pBlock);
+		}
+	}
+
+	for (const VulkanMemoryBlock* pBlock : m_ListDedicatedBlocks)
+	{
+		accumulateBlock(pBlock);
+		++stats.dedicatedBlockCount;
+	}
+
+	if (totalFree > 0)
+	{
+		stats.fragmentation = 1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(totalFree);
+	}
+
+	return stats;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMemoryAllocator::LogStats() const
+{
+	const MemoryAllocatorStats stats = GetStats();
+
+	LOG_DEBUG("---------- Device Memory ----------");
+	LOG_DEBUG("Memory Blocks: {0} ({1} dedicated)", stats.blockCount, stats.dedicatedBlockCount);
+	LOG_DEBUG("Allocations: {0}", stats.allocationCount);
+	LOG_DEBUG("Reserved: {0} KB | Used: {1} KB", stats.bytesReserved / 1024, stats.bytesUsed / 1024);
+	LOG_DEBUG("Free Ranges: {0} | Largest Free Range: {1} KB", stats.freeRangeCount, stats.largestFreeRange / 1024);
+	LOG_DEBUG("Fragmentation: {0}", stats.fragmentation);
+	LOG_DEBUG("-----------------------------------");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DeviceSize VulkanMemoryAllocator::GetPreferredBlockSize(uint32_t memoryTypeIndex) const
+{
+	const vk::MemoryType& memoryType = m_vkMemoryProperties.memoryTypes[memoryTypeIndex];
+	const vk::DeviceSize heapSize = m_vkMemoryProperties.memoryHeaps[memoryType.heapIndex].size;
+
+	const vk::DeviceSize preferredSize = (memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) ? GHostVisibleBlockSize : GDeviceLocalBlockSize;
+
+	return std::min(preferredSize, heapSize / 8);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanMemoryBlock* VulkanMemoryAllocator::CreateBlock(uint32_t memoryTypeIndex, vk::DeviceSize blockSize, uint32_t poolIndex, MemoryPoolType poolType, bool bDedicated)
+{
+	vk::MemoryAllocateInfo memAllocInfo;
+	memAllocInfo.allocationSize = blockSize;
+	memAllocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	// Result returning overload, out of memory is something callers handle & must not throw past them!
+	vk::DeviceMemory deviceMemory = nullptr;
+	const vk::Result result = m_vkDevice.allocateMemory(&memAllocInfo, nullptr, &deviceMemory);
+	if (result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("vkAllocateMemory failed for {0} bytes of memory type {1} : {2}!", blockSize, memoryTypeIndex, vk::to_string(result));
+		return nullptr;
+	}
+
+	LOG_DEBUG("Allocated {0} memory block of {1} KB from memory type {2}", bDedicated ? "dedicated" : "shared", blockSize / 1024, memoryTypeIndex);
+
+	return new VulkanMemoryBlock(deviceMemory, blockSize, memoryTypeIndex, poolIndex, poolType, bDedicated);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanMemoryAllocator::DestroyBlock(VulkanMemoryBlock* pBlock)
+{
+	if (pBlock->mapCount > 0)
+	{
+		m_vkDevice.unmapMemory(pBlock->deviceMemory);
+	}
+
+	m_vkDevice.freeMemory(pBlock->deviceMemory);
+
+	delete pBlock;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanMemoryAllocator::GetPoolIndex(uint32_t memoryTypeIndex, bool bLinearResource, MemoryPoolType poolType) const
+{
+	const uint32_t poolTypeCount = static_cast<uint32_t>(MemoryPoolType::POOL_END);
+
+	return (memoryTypeIndex * 2 + (bLinearResource ? 1 : 0)) * poolTypeCount + static_cast<uint32_t>(poolType);
+}
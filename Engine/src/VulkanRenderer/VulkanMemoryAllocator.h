@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../Core/Core.h"
+#include "vulkan/vulkan.hpp"
+
+#include <mutex>
+
+class VulkanMemoryAllocator;
+class VulkanMemoryBlock;
+
+//---------------------------------------------------------------------------------------------------------------------
+// FREE_LIST pools hand out best-fit ranges & coalesce on free, good for long lived resources of random lifetime.
+// LINEAR pools only bump an offset & recycle a block once everything in it is freed, good for resources which are
+// created & destroyed together (per swapchain image uniform buffers etc.)
+enum class MemoryPoolType
+{
+	POOL_FREE_LIST = 0,
+	POOL_LINEAR,
+	POOL_END
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// A range inside one of allocator's vk::DeviceMemory blocks. Multiple allocations share the same deviceMemory, so
+// always bind/map with the offset!
+struct VulkanAllocation
+{
+	VulkanAllocation()
+	{
+		deviceMemory = nullptr;
+		offset = 0;
+		size = 0;
+		memoryTypeIndex = 0;
+		pBlock = nullptr;
+		pAllocator = nullptr;
+	}
+
+	vk::DeviceMemory					deviceMemory;
+	vk::DeviceSize						offset;
+	vk::DeviceSize						size;
+	uint32_t							memoryTypeIndex;
+
+	VulkanMemoryBlock*					pBlock;
+	VulkanMemoryAllocator*				pAllocator;
+
+	inline bool							IsValid() const { return pAllocator != nullptr; }
+
+	void*								Map() const;
+	void								Unmap() const;
+	void								Free();
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct MemoryAllocatorStats
+{
+	MemoryAllocatorStats()
+	{
+		blockCount = 0;
+		dedicatedBlockCount = 0;
+		allocationCount = 0;
+		freeRangeCount = 0;
+		bytesReserved = 0;
+		bytesUsed = 0;
+		largestFreeRange = 0;
+		fragmentation = 0.0f;
+	}
+
+	uint32_t							blockCount;				// vk::DeviceMemory objects alive (counts against maxMemoryAllocationCount)
+	uint32_t							dedicatedBlockCount;	// ...out of which are dedicated to a single resource
+	uint32_t							allocationCount;		// live sub-allocations
+	uint32_t							freeRangeCount;			// holes inside free-list blocks
+	vk::DeviceSize						bytesReserved;			// total device memory allocated from driver
+	vk::DeviceSize						bytesUsed;				// bytes handed out to resources
+	vk::DeviceSize						largestFreeRange;
+	float								fragmentation;			// 0 = all free memory is contiguous, ~1 = free memory is scattered in tiny holes
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class UT_API VulkanMemoryAllocator
+{
+public:
+	VulkanMemoryAllocator(vk::Device vkDevice, vk::PhysicalDevice vkPhysicalDevice);
+	~VulkanMemoryAllocator();
+
+	bool								Allocate(const vk::MemoryRequirements& memReqs, vk::MemoryPropertyFlags memFlags, bool bLinearResource,
+												 MemoryPoolType poolType, VulkanAllocation* pOutAllocation);
+	void								Free(VulkanAllocation& allocation);
+
+	void*								Map(const VulkanAllocation& allocation);
+	void								Unmap(const VulkanAllocation& allocation);
+
+	uint32_t							FindMemoryTypeIndex(uint32_t allowedTypeIndex, vk::MemoryPropertyFlags props) const;
+	MemoryAllocatorStats				GetStats() const;
+	void								LogStats() const;
+
+private:
+	vk::DeviceSize						GetPreferredBlockSize(uint32_t memoryTypeIndex) const;
+	VulkanMemoryBlock*					CreateBlock(uint32_t memoryTypeIndex, vk::DeviceSize blockSize, uint32_t poolIndex, MemoryPoolType poolType, bool bDedicated);
+	void								DestroyBlock(VulkanMemoryBlock* pBlock);
+	uint32_t							GetPoolIndex(uint32_t memoryTypeIndex, bool bLinearResource, MemoryPoolType poolType) const;
+
+private:
+	vk::Device							m_vkDevice;
+	vk::PhysicalDeviceMemoryProperties	m_vkMemoryProperties;
+
+	// one list of blocks per [memory type][linear/optimal resource][pool type]. Linear (buffers) & optimal (images)
+	// resources never share a block, so we don't have to worry about bufferImageGranularity between neighbours!
+	std::vector<std::vector<VulkanMemoryBlock*>>	m_ListPools;
+	std::vector<VulkanMemoryBlock*>		m_ListDedicatedBlocks;
+
+	mutable std::mutex					m_Mutex;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void* VulkanAllocation::Map() const
+{
+	return (pAllocator != nullptr) ? pAllocator->Map(*this) : nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void VulkanAllocation::Unmap() const
+{
+	if (pAllocator != nullptr)
+		pAllocator->Unmap(*this);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void VulkanAllocation::Free()
+{
+	if (pAllocator != nullptr)
+		pAllocator->Free(*this);
+}
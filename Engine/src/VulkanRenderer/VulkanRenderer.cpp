@@ -2,8 +2,13 @@
 #include "UltimateEnginePCH.h"
 #include "VulkanRenderer.h"
 #include "VulkanDevice.h"
+#include "VulkanStagingRing.h"
+#include "VulkanUniformArena.h"
+#include "VulkanDescriptorAllocator.h"
 #include "VulkanSwapchain.h"
 #include "VulkanFramebuffer.h"
+#include "VulkanCullingPass.h"
+#include "VulkanFrameContext.h"
 #include "VulkanGlobals.h"
 #include "../World/Scene.h"
 #include "../World/Camera.h"
@@ -20,9 +25,11 @@ VulkanRenderer::VulkanRenderer()
 {
 	m_uiCurrentFrame = 0;
 	m_uiSwapchainImageIndex = 0;
+	m_uiUploadWaitValue = 0;
 	m_pVulkanDevice = nullptr;
 	m_pSwapchain = nullptr;
 	m_pFramebuffer = nullptr;
+	m_pCullingPass = nullptr;
 
 	m_pScene = nullptr;
 	m_pGUI = nullptr;
@@ -33,6 +40,7 @@ VulkanRenderer::~VulkanRenderer()
 {
 	SAFE_DELETE(m_pGUI);
 	SAFE_DELETE(m_pScene);
+	SAFE_DELETE(m_pCullingPass);
 	SAFE_DELETE(m_pFramebuffer);
 	SAFE_DELETE(m_pSwapchain);
 	SAFE_DELETE(m_pVulkanDevice);
@@ -46,7 +54,6 @@ bool VulkanRenderer::Initialize(const GLFWwindow* pWindow, vk::Instance vkInst,
 	CHECK_LOG(CreateFramebufferAttachments(),			"Framebuffer attachment creation FAILED!");
 	CHECK_LOG(CreateRenderPass(),						"Renderpass creation FAILED!");
 	CHECK_LOG(CreateFramebuffers(),						"Framebuffer creation FAILED!");
-	CHECK_LOG(CreateCommandbuffers(),					"Command buffer creation FAILED!");
 	CHECK_LOG(CreateFencesAndSemaphores(),				"Fences & Semaphore creation FAILED!");
 
 	m_pWindow = const_cast<GLFWwindow*>(pWindow);
@@ -57,8 +64,10 @@ bool VulkanRenderer::Initialize(const GLFWwindow* pWindow, vk::Instance vkInst,
 
 	m_pScene = new Scene();
 	CHECK_LOG(m_pScene->LoadScene(m_pVulkanDevice), "Load Scene FAILED!");
+	m_pVulkanDevice->GetMemoryAllocator()->LogStats();
 
 	CHECK_LOG(CreateGraphicsPipeline(), "Graphics Pipeline creation FAILED!");
+	CHECK_LOG(CreateCullingPass(), "Culling pass creation FAILED!");
 
 	LOG_DEBUG("Vulkan Renderer Initialized!");
 
@@ -68,20 +77,33 @@ bool VulkanRenderer::Initialize(const GLFWwindow* pWindow, vk::Instance vkInst,
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanRenderer::Update(double dt) const
 {
-	m_pScene->Update(dt);
+	// -- LAST CHANCE TO TOUCH LIVE SCENE, previous frame's simulation is done & next one isn't running yet!
+	// Finalize objects whose assets got loaded by workers since last frame...
+	m_pScene->UpdateLoading();
+
+	// ...let UI look at & edit objects...
+	m_pGUI->BeginRender();
+	m_pGUI->Render(m_pScene);
+	m_pGUI->EndRender();
+
+	// ...& simulate next frame while this one renders out of the snapshot previous simulation left behind
+	m_pScene->BeginSimulation(dt);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanRenderer::BeginFrame()
+bool VulkanRenderer::BeginFrame()
 {
 	const vk::Device vkDevice = m_pVulkanDevice->GetDevice();
+	VulkanFrameContext* pFrameContext = m_pVulkanDevice->GetFrameContext(m_uiCurrentFrame);
 
-	// -- GET NEXT IMAGE
-	vkDevice.waitForFences(m_vkListFences[m_uiCurrentFrame], true, UT::VkGlobals::GFenceTimeout);
-	vkDevice.resetFences(m_vkListFences[m_uiCurrentFrame]);
+	// -- WAIT TILL GPU IS DONE WITH THIS FRAME CONTEXT, everything it owns can be rewritten after that!
+	pFrameContext->WaitForGPU();
+
+	// Kick off any uploads recorded since last frame, they land on graphics queue before this frame's commands!
+	m_pVulkanDevice->FlushUploads();
 
 	// Get index of next image to be drawn to & signal semaphore when ready to be drawn to!
-	const vk::ResultValue<uint32_t> currentBuffer = vkDevice.acquireNextImageKHR(m_pSwapchain->GetSwapchainHandle(), UT::VkGlobals::GFenceTimeout, m_vkListSemaphoreImageAvailable[m_uiCurrentFrame], nullptr);
+	const vk::ResultValue<uint32_t> currentBuffer = vkDevice.acquireNextImageKHR(m_pSwapchain->GetSwapchainHandle(), UT::VkGlobals::GFenceTimeout, pFrameContext->GetImageAvailableSemaphore(), nullptr);
 	m_uiSwapchainImageIndex = currentBuffer.value;
 
 	// During any event such as window size change etc. we need to check if swap chain recreation is necessary
@@ -95,21 +117,32 @@ void VulkanRenderer::BeginFrame()
 	{
 		CleanupOnWindowsResize();
 		RecreateOnWindowsResize(m_pWindow, m_vkSurface);
-		return;
+		return false;
 	}
 	if (currentBuffer.result != vk::Result::eSuccess && currentBuffer.result != vk::Result::eSuboptimalKHR)
 	{
 		LOG_ERROR("Failed to acquire swapchain image!");
-		return;
+		return false;
 	}
+
+	// Frame is going to be submitted for sure, reset fence, command buffer & per frame storage
+	pFrameContext->Begin();
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void VulkanRenderer::Render()
 {
-	BeginFrame();
-	RecordCommands(m_uiSwapchainImageIndex);
-	SubmitAndPresentFrame();
+	// No image this time around (swapchain got recreated), try again next frame
+	if (BeginFrame())
+	{
+		RecordCommands(m_uiCurrentFrame);
+		SubmitAndPresentFrame();
+	}
+
+	// Input & next Update() touch live objects, simulation has to be done by then
+	m_pScene->EndSimulation();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -121,17 +154,29 @@ void VulkanRenderer::SubmitAndPresentFrame()
 	// Once we are done with the drawing to the image using graphics command buffer, we need to signal
 	// saying that we are done with the drawing to the image & that image is ready to PRESENT!
 
-	const vk::Semaphore waitSemaphores[] = { m_vkListSemaphoreImageAvailable[m_uiCurrentFrame] };
-	const vk::Semaphore signalSemaphores[] = { m_vkListSemaphoreRenderFinished[m_uiCurrentFrame] };
+	// If uploads were acquired this frame, also wait for transfer queue to reach their timeline value. Binary
+	// semaphore's value is ignored! Render finished semaphore belongs to the image, presentation engine holds on to it
+	// till that image comes back!
+	const VulkanFrameContext* pFrameContext = m_pVulkanDevice->GetFrameContext(m_uiCurrentFrame);
+	const vk::Semaphore waitSemaphores[] = { pFrameContext->GetImageAvailableSemaphore(), m_pVulkanDevice->GetStagingRing()->GetTimelineSemaphore() };
+	const uint64_t waitValues[] = { 0, m_uiUploadWaitValue };
+	const vk::Semaphore signalSemaphores[] = { m_vkListSemaphoreRenderFinished[m_uiSwapchainImageIndex] };
+
+	const std::array<vk::CommandBuffer, 1> commandBuffers = { pFrameContext->GetCommandBuffer() };
 
-	const std::array<vk::CommandBuffer, 1> commandBuffers = { m_pVulkanDevice->GetGraphicsCommandBuffer(m_uiSwapchainImageIndex) };
+	const uint32_t waitSemaphoreCount = (m_uiUploadWaitValue > 0) ? 2 : 1;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.waitSemaphoreValueCount = waitSemaphoreCount;
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
 
 	// Queue submission info
 	vk::SubmitInfo submitInfo = {};
-	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.waitSemaphoreCount = waitSemaphoreCount;
 	submitInfo.pWaitSemaphores = waitSemaphores;						// sempahores to WAIT on
 
-	constexpr std::array<vk::PipelineStageFlags, 1> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+	constexpr std::array<vk::PipelineStageFlags, 2> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput, UT::VkGlobals::GUploadAcquireStages };
 
 	submitInfo.pWaitDstStageMask = waitStages.data();
 	submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
@@ -140,7 +185,7 @@ void VulkanRenderer::SubmitAndPresentFrame()
 	submitInfo.pSignalSemaphores = signalSemaphores;					// semaphores to SIGNAL
 
 	// Submit the command buffer to Graphics Queue!
-	m_pVulkanDevice->GetGraphicsQueue().submit(submitInfo, m_vkListFences[m_uiCurrentFrame]);
+	m_pVulkanDevice->GetGraphicsQueue().submit(submitInfo, pFrameContext->GetFence());
 
 	std::array<vk::SwapchainKHR, 1> swapchains = { m_pSwapchain->GetSwapchainHandle() };
 
@@ -154,13 +199,14 @@ void VulkanRenderer::SubmitAndPresentFrame()
 
 	const vk::Result result = m_pVulkanDevice->GetPresentQueue().presentKHR(presentInfo);
 
+	// Frame is submitted either way, next one goes to the next context
+	m_uiCurrentFrame = (m_uiCurrentFrame + 1) % m_pVulkanDevice->GetFrameCount();
+
 	if (result != vk::Result::eSuccess)
 	{
 		LOG_ERROR("Failed to Present Image!");
 		return;
 	}
-
-	m_uiCurrentFrame = (m_uiCurrentFrame + 1) % UT::VkGlobals::GMaxFramesDraws;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -168,15 +214,22 @@ void VulkanRenderer::RecreateOnWindowsResize(const GLFWwindow* pWindow, vk::Surf
 {
 	LOG_DEBUG("Window Resize ======> Recreation started!");
 	m_pSwapchain->CreateSwapChain(pWindow, vkSurface, m_pVulkanDevice);
-	m_pFramebuffer->CreateFramebuffersAttachments(m_pVulkanDevice, m_pSwapchain);
+
+	if (!m_pFramebuffer->CreateFramebuffersAttachments(m_pVulkanDevice, m_pSwapchain))
+		LOG_CRITICAL("Window Resize ======> Framebuffer attachments recreation FAILED!");
 
 	CreateRenderPass();
 
 	m_pFramebuffer->CreateFramebuffers(m_pVulkanDevice, m_vkForwardRenderingRenderPass);
-	m_pVulkanDevice->CreateCommandBuffers(m_pFramebuffer);
+
+	// Frame contexts don't care about swapchain, only per image semaphores might need to follow its image count
+	CreateRenderFinishedSemaphores();
 
 	CreateGraphicsPipeline();
 
+	// Pyramid follows depth buffer's size
+	m_pCullingPass->CreateHiZ(m_pFramebuffer->GetDepthImageView(), m_pSwapchain->GetSwapchainExtent());
+
 	LOG_DEBUG("Window Resize ======> Recreation finished!");
 }
 
@@ -186,9 +239,19 @@ void VulkanRenderer::Cleanup()
 	vk::Device vkDevice = m_pVulkanDevice->GetDevice();
 	vkDevice.waitIdle();
 
+	m_pScene->Cleanup(m_pVulkanDevice);
+	m_pCullingPass->Cleanup();
+
 	vkDevice.destroyPipeline(m_vkForwardRenderingPipeline);
 	vkDevice.destroyRenderPass(m_vkForwardRenderingRenderPass);
 
+	for (vk::Semaphore semaphore : m_vkListSemaphoreRenderFinished)
+	{
+		vkDevice.destroySemaphore(semaphore);
+	}
+
+	m_vkListSemaphoreRenderFinished.clear();
+
 	m_pSwapchain->Cleanup(vkDevice);
 	m_pFramebuffer->Cleanup(vkDevice);
 	m_pVulkanDevice->Cleanup();
@@ -199,6 +262,9 @@ void VulkanRenderer::CleanupOnWindowsResize()
 {
 	LOG_DEBUG("Window Resize ======> Cleanup started!");
 
+	// Camera reads current resolution, simulation must not be running while it changes
+	m_pScene->EndSimulation();
+
 	const vk::Device vkDevice = m_pVulkanDevice->GetDevice();
 	vkDevice.waitIdle();
 
@@ -216,34 +282,46 @@ void VulkanRenderer::CleanupOnWindowsResize()
 	vkDevice.destroyRenderPass(m_vkForwardRenderingRenderPass);
 	LOG_DEBUG("Window Resize ======> RenderPass Destroyed!");
 
+	m_pCullingPass->DestroyHiZ();
+
 	m_pSwapchain->CleanupOnWindowResize(vkDevice);
 	m_pFramebuffer->CleanupOnWindowsResize(vkDevice);
-	m_pVulkanDevice->CleanupOnWindowsResize();
 
 	LOG_DEBUG("Window Resize ======> Cleanup finished!");
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 bool VulkanRenderer::CreateFencesAndSemaphores()
+{
+	// Fences & image available semaphores are per frame in flight, they live in device's frame contexts. What's left is
+	// per swapchain image!
+	CreateRenderFinishedSemaphores();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanRenderer::CreateRenderFinishedSemaphores()
 {
 	const vk::Device vkDevice = m_pVulkanDevice->GetDevice();
+	const uint32_t imageCount = m_pSwapchain->GetSwapchainImageCount();
 
-	m_vkListSemaphoreImageAvailable.resize(UT::VkGlobals::GMaxFramesDraws);
-	m_vkListSemaphoreRenderFinished.resize(UT::VkGlobals::GMaxFramesDraws);
-	m_vkListFences.resize(UT::VkGlobals::GMaxFramesDraws);
+	if (m_vkListSemaphoreRenderFinished.size() == imageCount)
+		return;
 
-	constexpr vk::SemaphoreCreateInfo sempaphoreCreateInfo = {};
-	vk::FenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.flags = vk::FenceCreateFlagBits::eSignaled;
+	// Only called with device idle, nothing is waiting on these
+	for (vk::Semaphore semaphore : m_vkListSemaphoreRenderFinished)
+	{
+		vkDevice.destroySemaphore(semaphore);
+	}
 
-	for (uint16_t i = 0; i < UT::VkGlobals::GMaxFramesDraws; i++)
+	m_vkListSemaphoreRenderFinished.resize(imageCount);
+
+	constexpr vk::SemaphoreCreateInfo sempaphoreCreateInfo = {};
+	for (uint32_t i = 0; i < imageCount; i++)
 	{
-		m_vkListSemaphoreImageAvailable[i] = vkDevice.createSemaphore(sempaphoreCreateInfo);
 		m_vkListSemaphoreRenderFinished[i] = vkDevice.createSemaphore(sempaphoreCreateInfo);
-		m_vkListFences[i] = vkDevice.createFence(fenceCreateInfo);
 	}
-
-	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -252,6 +330,7 @@ bool VulkanRenderer::CreateGraphicsPipeline()
 	// Read shader code & create modules
 	vk::ShaderModule vsModule = m_pVulkanDevice->CreateShaderModule("Assets/Shaders/triangle.vert.spv");
 	vk::ShaderModule fsModule = m_pVulkanDevice->CreateShaderModule("Assets/Shaders/triangle.frag.spv");
+	CHECK(vsModule && fsModule);
 
 	// Vertex Shader stage creation info
 	vk::PipelineShaderStageCreateInfo vsCreateInfo = {};
@@ -267,13 +346,17 @@ bool VulkanRenderer::CreateGraphicsPipeline()
 
 	std::array<vk::PipelineShaderStageCreateInfo, 2> arrShaderStages = { vsCreateInfo, fsCreateInfo };
 
-	// How the data for a single vertex is as a whole!
-	vk::VertexInputBindingDescription inputBindingDesc = {};
-	inputBindingDesc.binding = 0;
-	inputBindingDesc.stride = sizeof(VertexPNTBT);
-	inputBindingDesc.inputRate = vk::VertexInputRate::eVertex;
+	// How the data for a single vertex is as a whole! Binding 1 steps once per instance, see InstanceData
+	std::array<vk::VertexInputBindingDescription, 2> inputBindingDesc = {};
+	inputBindingDesc[0].binding = 0;
+	inputBindingDesc[0].stride = sizeof(VertexPNTBT);
+	inputBindingDesc[0].inputRate = vk::VertexInputRate::eVertex;
 
-	std::array<vk::VertexInputAttributeDescription, 5> attrDesc = {};
+	inputBindingDesc[1].binding = 1;
+	inputBindingDesc[1].stride = sizeof(InstanceData);
+	inputBindingDesc[1].inputRate = vk::VertexInputRate::eInstance;
+
+	std::array<vk::VertexInputAttributeDescription, 11> attrDesc = {};
 
 	// Position
 	attrDesc[0].binding = 0;
@@ -305,12 +388,33 @@ bool VulkanRenderer::CreateGraphicsPipeline()
 	attrDesc[4].format = vk::Format::eR32G32Sfloat;
 	attrDesc[4].offset = offsetof(VertexPNTBT, UV);
 
+	// World matrix, a column per location
+	for (uint32_t column = 0; column < 4; ++column)
+	{
+		attrDesc[5 + column].binding = 1;
+		attrDesc[5 + column].location = 5 + column;
+		attrDesc[5 + column].format = vk::Format::eR32G32B32A32Sfloat;
+		attrDesc[5 + column].offset = offsetof(InstanceData, matWorld) + column * sizeof(glm::vec4);
+	}
+
+	// Albedo Color
+	attrDesc[9].binding = 1;
+	attrDesc[9].location = 9;
+	attrDesc[9].format = vk::Format::eR32G32B32A32Sfloat;
+	attrDesc[9].offset = offsetof(InstanceData, albedoColor);
+
+	// Material Index
+	attrDesc[10].binding = 1;
+	attrDesc[10].location = 10;
+	attrDesc[10].format = vk::Format::eR32Uint;
+	attrDesc[10].offset = offsetof(InstanceData, materialIndex);
+
 	// Vertex Input (TODO)
 	vk::PipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
 	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrDesc.size());
 	vertexInputCreateInfo.pVertexAttributeDescriptions = attrDesc.data();
-	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-	vertexInputCreateInfo.pVertexBindingDescriptions = &inputBindingDesc;
+	vertexInputCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(inputBindingDesc.size());
+	vertexInputCreateInfo.pVertexBindingDescriptions = inputBindingDesc.data();
 
 	// Input Assembly
 	vk::PipelineInputAssemblyStateCreateInfo inputASCreateInfo = {};
@@ -396,7 +500,7 @@ bool VulkanRenderer::CreateGraphicsPipeline()
 	forwardRenderingPipelineInfo.pMultisampleState = &msCreateInfo;
 	forwardRenderingPipelineInfo.pColorBlendState = &colorBlendCreateInfo;
 	forwardRenderingPipelineInfo.pDepthStencilState = &depthStencilCreateInfo;
-	forwardRenderingPipelineInfo.layout = dynamic_cast<VulkanCube*>(m_pScene->GetFirstObject())->GetPipelineLayout();
+	forwardRenderingPipelineInfo.layout = ForwardPassLayouts::GetPipelineLayout(m_pVulkanDevice);
 	forwardRenderingPipelineInfo.renderPass = m_vkForwardRenderingRenderPass;
 	forwardRenderingPipelineInfo.subpass = 0;
 	forwardRenderingPipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
@@ -493,7 +597,7 @@ bool VulkanRenderer::CreateFramebufferAttachments()
 	UT_ASSERT_NULL(m_pSwapchain, "CreateFramebufferAttachments()-->VulkanSwapchain class object not valid?!");
 
 	m_pFramebuffer = new VulkanFramebuffer();
-	m_pFramebuffer->CreateFramebuffersAttachments(m_pVulkanDevice, m_pSwapchain);
+	CHECK(m_pFramebuffer->CreateFramebuffersAttachments(m_pVulkanDevice, m_pSwapchain));
 
 	return true;
 }
@@ -520,11 +624,11 @@ bool VulkanRenderer::CreateRenderPass()
 	depthAttachment.format = m_pFramebuffer->GetDepthBufferFormat();
 	depthAttachment.samples = vk::SampleCountFlagBits::e1;
 	depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
-	depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+	depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;					// HiZ pyramid is built out of it
 	depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 	depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 	depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
-	depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+	depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
 
 	constexpr vk::AttachmentReference colorAttachRef(0, vk::ImageLayout::eColorAttachmentOptimal);
 	constexpr vk::AttachmentReference depthAttachRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
@@ -536,29 +640,27 @@ bool VulkanRenderer::CreateRenderPass()
 	subpass.pColorAttachments = &colorAttachRef;
 	subpass.pDepthStencilAttachment = &depthAttachRef;
 
-	//std::array<vk::SubpassDependency, 2> subpassDependencies;
-	//
-	//// 1. UNDEFINED --> COLOR ATTACHMENT
-	//subpassDependencies[0].srcSubpass = vk::SubpassExternal;
-	//subpassDependencies[0].dstSubpass = 0;
-	//subpassDependencies[0].srcStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
-	//subpassDependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-	//subpassDependencies[0].srcAccessMask = vk::AccessFlagBits::eMemoryRead;
-	//subpassDependencies[0].dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
-	//subpassDependencies[0].dependencyFlags = vk::DependencyFlagBits::eByRegion | vk::DependencyFlagBits::eDeviceGroup | vk::DependencyFlagBits::eFeedbackLoopEXT;
-	//
-	//// 2. COLOR_ATTACHMENT --> PRESENT_SRC_KHR
-	//subpassDependencies[1].srcSubpass = 0;
-	//subpassDependencies[1].dstSubpass = vk::SubpassExternal;
-	//subpassDependencies[1].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-	//subpassDependencies[1].dstStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
-	//subpassDependencies[1].srcAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
-	//subpassDependencies[1].dstAccessMask = vk::AccessFlagBits::eMemoryRead;;
-	//subpassDependencies[1].dependencyFlags = vk::DependencyFlagBits::eByRegion| vk::DependencyFlagBits::eDeviceGroup | vk::DependencyFlagBits::eFeedbackLoopEXT;
+	std::array<vk::SubpassDependency, 2> subpassDependencies;
+
+	// 1. Previous frame's HiZ build (compute) reads depth, clear of this frame has to wait for it
+	subpassDependencies[0].srcSubpass = vk::SubpassExternal;
+	subpassDependencies[0].dstSubpass = 0;
+	subpassDependencies[0].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader;
+	subpassDependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+	subpassDependencies[0].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	subpassDependencies[0].dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+	// 2. DEPTH ATTACHMENT --> HiZ build reading it in compute, right after the pass
+	subpassDependencies[1].srcSubpass = 0;
+	subpassDependencies[1].dstSubpass = vk::SubpassExternal;
+	subpassDependencies[1].srcStageMask = vk::PipelineStageFlagBits::eLateFragmentTests;
+	subpassDependencies[1].dstStageMask = vk::PipelineStageFlagBits::eComputeShader;
+	subpassDependencies[1].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	subpassDependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead;
 
 	std::array<vk::AttachmentDescription, 2> renderPassAttachmentsDesc = { colorAttachment, depthAttachment };
 
-	const vk::RenderPassCreateInfo renderPassInfo(vk::RenderPassCreateFlags(), renderPassAttachmentsDesc, subpass);// , subpassDependencies);
+	const vk::RenderPassCreateInfo renderPassInfo(vk::RenderPassCreateFlags(), renderPassAttachmentsDesc, subpass, subpassDependencies);
 
 	m_vkForwardRenderingRenderPass = m_pVulkanDevice->GetDevice().createRenderPass(renderPassInfo);
 
@@ -579,17 +681,18 @@ bool VulkanRenderer::CreateFramebuffers()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-bool VulkanRenderer::CreateCommandbuffers() const
+bool VulkanRenderer::CreateCullingPass()
 {
-	UT_ASSERT_NULL(m_pFramebuffer, "CreateCommandbuffers()-->VulkanFramebuffer class object not valid?!");
-
-	m_pVulkanDevice->CreateCommandBuffers(m_pFramebuffer);
+	m_pCullingPass = new VulkanCullingPass();
+	CHECK(m_pCullingPass->Initialize(m_pVulkanDevice));
+	CHECK(m_pCullingPass->CreateFrames(m_pVulkanDevice->GetFrameCount()));
+	CHECK(m_pCullingPass->CreateHiZ(m_pFramebuffer->GetDepthImageView(), m_pSwapchain->GetSwapchainExtent()));
 
 	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void VulkanRenderer::RecordCommands(uint32_t currentImage) const
+void VulkanRenderer::RecordCommands(uint32_t frameIndex)
 {
 	// Information about how to begin each command buffer
 	constexpr vk::CommandBufferBeginInfo cmdBufferBeginInfo = {};
@@ -608,29 +711,42 @@ void VulkanRenderer::RecordCommands(uint32_t currentImage) const
 	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassBeginInfo.pClearValues = clearValues.data();
 
-	renderPassBeginInfo.framebuffer = m_pFramebuffer->GetFramebuffer(m_uiCurrentFrame);
+	// Framebuffer follows acquired image, everything else follows frame context
+	renderPassBeginInfo.framebuffer = m_pFramebuffer->GetFramebuffer(m_uiSwapchainImageIndex);
+
+	// Update uniforms! Objects pack into this frame's arena (begun with frame context) & remember their offsets, so it
+	// has to happen before draws
+	m_pScene->UpdateUniforms(m_pVulkanDevice);
 
 	// start recording...
-	m_pVulkanDevice->BeginGraphicsCommandBuffer(currentImage, cmdBufferBeginInfo);
+	m_pVulkanDevice->BeginGraphicsCommandBuffer(frameIndex, cmdBufferBeginInfo);
+
+	// Take ownership of whatever got uploaded on transfer queue since last frame
+	m_uiUploadWaitValue = m_pVulkanDevice->GetStagingRing()->RecordAcquireBarriers(m_pVulkanDevice->GetGraphicsCommandBuffer(frameIndex));
+
+	// Find out what's visible before render pass, draw counts come out of it
+	CullingPassInput cullingInput;
+	m_pScene->GetCullingInput(&cullingInput);
+	m_pCullingPass->RecordCulling(frameIndex, cullingInput);
 
 	// Begin RenderPass
-	m_pVulkanDevice->BeginRenderPass(currentImage, renderPassBeginInfo);
+	m_pVulkanDevice->BeginRenderPass(frameIndex, renderPassBeginInfo);
 
 	// Bind Rendering pipeline
-	m_pVulkanDevice->BindPipeline(currentImage, vk::PipelineBindPoint::eGraphics, m_vkForwardRenderingPipeline);
-	
-	m_pScene->Render(m_pVulkanDevice, currentImage);
+	m_pVulkanDevice->BindPipeline(frameIndex, vk::PipelineBindPoint::eGraphics, m_vkForwardRenderingPipeline);
 
-	m_pGUI->BeginRender();
-	m_pGUI->Render(m_pScene);
-	m_pGUI->EndRender(m_pVulkanDevice, currentImage);
+	// Whole scene is a handful of binds & one indirect draw, nothing there worth recording on another thread!
+	const vk::CommandBuffer gfxCmdBuffer = m_pVulkanDevice->GetGraphicsCommandBuffer(frameIndex);
+	m_pScene->RecordDraws(m_pVulkanDevice, m_pCullingPass, frameIndex, gfxCmdBuffer);
+
+	m_pGUI->RecordDrawData(gfxCmdBuffer);
 
 	// End RenderPass
-	m_pVulkanDevice->EndRenderPass(currentImage);
+	m_pVulkanDevice->EndRenderPass(frameIndex);
+
+	// Next frame culls against this frame's depth
+	m_pCullingPass->RecordHiZBuild(frameIndex, cullingInput.matViewProjection);
 	
 	// end recording...
-	m_pVulkanDevice->EndGraphicsCommandBuffer(currentImage);
-
-	// Update uniforms!
-	m_pScene->UpdateUniforms(m_pVulkanDevice, currentImage);
+	m_pVulkanDevice->EndGraphicsCommandBuffer(frameIndex);
 }
@@ -7,6 +7,7 @@ struct GLFWwindow;
 class VulkanDevice;
 class VulkanSwapchain;
 class VulkanFramebuffer;
+class VulkanCullingPass;
 class UIManager;
 class Scene;
 enum class CameraAction;
@@ -19,7 +20,7 @@ public:
 
 	bool								Initialize(const GLFWwindow* pWindow, vk::Instance vkInst, vk::SurfaceKHR vkSurface);
 	void								Update(double dt) const;
-	void								BeginFrame();
+	bool								BeginFrame();
 	void								Render();
 	void								SubmitAndPresentFrame();
 	void								Cleanup();
@@ -36,23 +37,24 @@ private:
 	bool								CreateFramebufferAttachments();
 	bool								CreateRenderPass();
 	bool								CreateFramebuffers();
-	bool								CreateCommandbuffers() const;
-	void								RecordCommands(uint32_t currentImage) const;
+	bool								CreateCullingPass();
+	void								CreateRenderFinishedSemaphores();
+	void								RecordCommands(uint32_t frameIndex);
 
 private:
 	VulkanDevice*						m_pVulkanDevice;
 	VulkanSwapchain*					m_pSwapchain;
 	VulkanFramebuffer*					m_pFramebuffer;
+	VulkanCullingPass*					m_pCullingPass;
 
 	vk::Pipeline						m_vkForwardRenderingPipeline;
 	vk::RenderPass						m_vkForwardRenderingRenderPass;
 
-	// -- Synchronization!
-	uint32_t							m_uiCurrentFrame;
-	uint32_t							m_uiSwapchainImageIndex;
-	std::vector<vk::Semaphore>			m_vkListSemaphoreImageAvailable;
-	std::vector<vk::Semaphore>			m_vkListSemaphoreRenderFinished;
-	std::vector<vk::Fence>				m_vkListFences;
+	// -- Synchronization! Fences & acquire semaphores live in device's frame contexts
+	uint32_t							m_uiCurrentFrame;				// frame in flight, indexes frame contexts
+	uint32_t							m_uiSwapchainImageIndex;		// acquired image, indexes framebuffers only
+	std::vector<vk::Semaphore>			m_vkListSemaphoreRenderFinished;	// per swapchain image
+	uint64_t							m_uiUploadWaitValue;			// transfer timeline value this frame has to wait on, 0 = none
 
 	GLFWwindow*							m_pWindow;
 	vk::SurfaceKHR						m_vkSurface;
@@ -0,0 +1,126 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanSamplerCache.h"
+#include "VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+template<typename T>
+static void HashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+size_t VulkanSamplerCache::SamplerInfoHash::operator()(const vk::SamplerCreateInfo& createInfo) const
+{
+	size_t seed = 0;
+
+	HashCombine(seed, static_cast<uint32_t>(createInfo.flags));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.magFilter));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.minFilter));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.mipmapMode));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.addressModeU));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.addressModeV));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.addressModeW));
+	HashCombine(seed, createInfo.mipLodBias);
+	HashCombine(seed, static_cast<uint32_t>(createInfo.anisotropyEnable));
+	HashCombine(seed, createInfo.maxAnisotropy);
+	HashCombine(seed, static_cast<uint32_t>(createInfo.compareEnable));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.compareOp));
+	HashCombine(seed, createInfo.minLod);
+	HashCombine(seed, createInfo.maxLod);
+	HashCombine(seed, static_cast<uint32_t>(createInfo.borderColor));
+	HashCombine(seed, static_cast<uint32_t>(createInfo.unnormalizedCoordinates));
+
+	return seed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanSamplerCache::SamplerInfoEqual::operator()(const vk::SamplerCreateInfo& lhs, const vk::SamplerCreateInfo& rhs) const
+{
+	// pNext isn't part of the key, GetSampler() refuses extended create infos
+	return	lhs.flags == rhs.flags &&
+			lhs.magFilter == rhs.magFilter &&
+			lhs.minFilter == rhs.minFilter &&
+			lhs.mipmapMode == rhs.mipmapMode &&
+			lhs.addressModeU == rhs.addressModeU &&
+			lhs.addressModeV == rhs.addressModeV &&
+			lhs.addressModeW == rhs.addressModeW &&
+			lhs.mipLodBias == rhs.mipLodBias &&
+			lhs.anisotropyEnable == rhs.anisotropyEnable &&
+			lhs.maxAnisotropy == rhs.maxAnisotropy &&
+			lhs.compareEnable == rhs.compareEnable &&
+			lhs.compareOp == rhs.compareOp &&
+			lhs.minLod == rhs.minLod &&
+			lhs.maxLod == rhs.maxLod &&
+			lhs.borderColor == rhs.borderColor &&
+			lhs.unnormalizedCoordinates == rhs.unnormalizedCoordinates;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanSamplerCache::VulkanSamplerCache()
+{
+	m_pDevice = nullptr;
+	m_fMaxAnisotropy = 1.0f;
+	m_umapSamplers.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanSamplerCache::~VulkanSamplerCache()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanSamplerCache::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+	m_fMaxAnisotropy = m_pDevice->GetPhysicalDevice().getProperties().limits.maxSamplerAnisotropy;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanSamplerCache::Cleanup()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	LOG_DEBUG("Sampler cache : destroying {0} sampler(s)", m_umapSamplers.size());
+
+	for (const std::pair<const vk::SamplerCreateInfo, vk::Sampler>& sampler : m_umapSamplers)
+	{
+		m_pDevice->GetDevice().destroySampler(sampler.second);
+	}
+
+	m_umapSamplers.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::Sampler VulkanSamplerCache::GetSampler(const vk::SamplerCreateInfo& createInfo)
+{
+	UT_ASSERT_BOOL((createInfo.pNext == nullptr), "Sampler cache can't key extended sampler create infos!");
+
+	// Clamp before lookup, so that "16x" & "whatever device supports" end up as the same sampler
+	vk::SamplerCreateInfo key = createInfo;
+	key.maxAnisotropy = key.anisotropyEnable ? std::min(key.maxAnisotropy, m_fMaxAnisotropy) : 1.0f;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	const auto iter = m_umapSamplers.find(key);
+	if (iter != m_umapSamplers.end())
+		return iter->second;
+
+	const vk::Sampler vkSampler = m_pDevice->GetDevice().createSampler(key);
+	m_umapSamplers.emplace(key, vkSampler);
+
+	LOG_DEBUG("Sampler cache : created sampler #{0}", m_umapSamplers.size());
+
+	return vkSampler;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t VulkanSamplerCache::GetSamplerCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return static_cast<uint32_t>(m_umapSamplers.size());
+}
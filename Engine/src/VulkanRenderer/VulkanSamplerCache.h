@@ -0,0 +1,44 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+#include <mutex>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Samplers are tiny but drivers cap how many can exist (maxSamplerAllocationCount), & almost every texture asks for
+// identical settings. Cache hands out one shared vk::Sampler per unique create info, all of them live till device
+// cleanup, so users never destroy samplers they got from here!
+class UT_API VulkanSamplerCache
+{
+public:
+	VulkanSamplerCache();
+	~VulkanSamplerCache();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	vk::Sampler							GetSampler(const vk::SamplerCreateInfo& createInfo);
+
+	uint32_t							GetSamplerCount() const;
+
+private:
+	struct SamplerInfoHash
+	{
+		size_t							operator()(const vk::SamplerCreateInfo& createInfo) const;
+	};
+
+	struct SamplerInfoEqual
+	{
+		bool							operator()(const vk::SamplerCreateInfo& lhs, const vk::SamplerCreateInfo& rhs) const;
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+	float								m_fMaxAnisotropy;
+
+	std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, SamplerInfoHash, SamplerInfoEqual>	m_umapSamplers;
+
+	mutable std::mutex					m_Mutex;
+};
@@ -0,0 +1,610 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanStagingRing.h"
+#include "VulkanDevice.h"
+#include "../Core/JobSystem.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	// texel block sizes (12 bytes for RGB32F etc.) aren't power of 2, so can't use bit tricks here!
+	return ((value + alignment - 1) / alignment) * alignment;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanStagingRing::VulkanStagingRing()
+{
+	m_pDevice = nullptr;
+	m_pMappedRing = nullptr;
+	m_vkRingSize = 0;
+
+	m_uiHead = 0;
+	m_uiTail = 0;
+
+	m_bQueueOwnershipTransfer = false;
+	m_uiTransferFamily = 0;
+	m_uiGraphicsFamily = 0;
+	m_uiLastSubmittedValue = 0;
+	m_uiPendingAcquireValue = 0;
+	m_bFlushRequested = false;
+
+	m_ListInFlightBatches.clear();
+	m_ListFreeBatches.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanStagingRing::~VulkanStagingRing()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::Initialize(const VulkanDevice* pDevice, vk::DeviceSize ringSize)
+{
+	m_pDevice = pDevice;
+	m_vkRingSize = ringSize;
+	m_OwnerThreadId = std::this_thread::get_id();
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// Uploads go to dedicated transfer queue if there is one, graphics queue otherwise
+	m_vkTransferQueue = m_pDevice->GetTransferQueue();
+	m_uiTransferFamily = m_pDevice->GetTransferQueueFamilyIndex();
+	m_uiGraphicsFamily = m_pDevice->GetGraphicsQueueFamilyIndex();
+	m_bQueueOwnershipTransfer = (m_uiTransferFamily != m_uiGraphicsFamily);
+
+	// Timeline semaphore replaces per batch fences, GPU side waits (renderer) & CPU side waits (ring recycling) both use it
+	vk::SemaphoreTypeCreateInfo timelineInfo = {};
+	timelineInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+	timelineInfo.initialValue = 0;
+
+	vk::SemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.pNext = &timelineInfo;
+
+	m_vkTimelineSemaphore = vkDevice.createSemaphore(semaphoreInfo);
+
+	// Ring buffer lives in host visible memory & stays mapped until we shutdown!
+	CHECK_LOG(m_pDevice->CreateBuffer(m_vkRingSize,
+									  vk::BufferUsageFlagBits::eTransferSrc,
+									  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+									  &m_RingBuffer), "Failed to create staging ring!");
+
+	m_pMappedRing = static_cast<uint8_t*>(m_RingBuffer.allocation.Map());
+	CHECK_LOG(m_pMappedRing, "Failed to map staging ring!");
+
+	LOG_DEBUG("Staging ring of {0} KB created, uploading on {1} queue", m_vkRingSize / 1024, m_bQueueOwnershipTransfer ? "dedicated transfer" : "graphics");
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::Cleanup()
+{
+	WaitIdle();
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	// command buffers go away with their pools!
+	for (const UploadBatch& batch : m_ListFreeBatches)
+	{
+		vkDevice.destroyCommandPool(batch.cmdPool);
+	}
+
+	m_ListFreeBatches.clear();
+	vkDevice.destroySemaphore(m_vkTimelineSemaphore);
+
+	m_RingBuffer.allocation.Unmap();
+	m_RingBuffer.DestroyAll(vkDevice);
+	m_pMappedRing = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::Reserve(vk::DeviceSize size, vk::DeviceSize alignment, StagingRegion* pOutRegion)
+{
+	CHECK_LOG(size <= m_vkRingSize, "Upload is bigger than the whole staging ring!");
+
+	// copy offsets must always be multiple of 4
+	alignment = std::max<vk::DeviceSize>(alignment, 4);
+
+	const bool bOwnerThread = (std::this_thread::get_id() == m_OwnerThreadId);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	uint64_t regionStart = 0;
+
+	while (true)
+	{
+		RetireCompletedBatches(false);
+
+		const uint64_t ringOffset = m_uiHead % m_vkRingSize;
+		const uint64_t alignedOffset = AlignUp(ringOffset, alignment);
+
+		// Wrap around if region doesn't fit in before the end of the ring
+		if (alignedOffset + size > m_vkRingSize)
+			regionStart = m_uiHead + (m_vkRingSize - ringOffset);
+		else
+			regionStart = m_uiHead + (alignedOffset - ringOffset);
+
+		if (regionStart + size - m_uiTail <= m_vkRingSize)
+			break;
+
+		// Ring is full. Main thread pushes out whatever is queued so far & blocks on the oldest batch to make room,
+		// workers can't touch the queue, so they ask main thread to flush. It picks that up once a frame or while it
+		// waits on a job counter, whichever comes first, so a main thread waiting on us can't starve the ring!
+		if (bOwnerThread)
+		{
+			FlushLocked();
+
+			if (!m_ListInFlightBatches.empty())
+			{
+				RetireCompletedBatches(true);
+				continue;
+			}
+		}
+		else if (!m_bFlushRequested && !m_ListPendingCopies.empty())
+		{
+			m_bFlushRequested = true;
+			JobSystem::getInstance().RunOnMainThread([this]() { Flush(); });
+		}
+
+		m_cvSpaceFreed.wait_for(lock, std::chrono::milliseconds(1));
+	}
+
+	m_uiHead = regionStart + size;
+	m_SetOutstandingRegions.insert(regionStart);
+
+	pOutRegion->buffer = m_RingBuffer.buffer;
+	pOutRegion->offset = regionStart % m_vkRingSize;
+	pOutRegion->size = size;
+	pOutRegion->ringStart = regionStart;
+	pOutRegion->pMappedData = m_pMappedRing + pOutRegion->offset;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::CopyToBuffer(const StagingRegion& region, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	PendingCopy copy;
+	copy.region = region;
+	copy.dstBuffer = dstBuffer;
+	copy.dstOffset = dstOffset;
+	copy.dstImage = nullptr;
+	copy.format = vk::Format::eUndefined;
+	copy.width = 0;
+	copy.height = 0;
+	copy.mipLevels = 0;
+	copy.bGenerateMips = false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CommitCopy(copy, pOutTicket);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::CopyToImage(const StagingRegion& region, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	PendingCopy copy;
+	copy.region = region;
+	copy.dstBuffer = nullptr;
+	copy.dstOffset = 0;
+	copy.dstImage = dstImage.image;
+	copy.format = dstImage.format;
+	copy.width = dstImage.extent.width;
+	copy.height = dstImage.extent.height;
+	copy.mipLevels = dstImage.mipLevels;
+	copy.bGenerateMips = bGenerateMips && (dstImage.mipLevels > 1);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CommitCopy(copy, pOutTicket);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::UploadToBuffer(const void* pData, vk::DeviceSize size, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	StagingRegion region;
+	CHECK(Reserve(size, 4, &region));
+
+	// memcpy happens outside the lock, so workers fill the ring in parallel
+	memcpy(region.pMappedData, pData, static_cast<size_t>(size));
+	CopyToBuffer(region, dstBuffer, dstOffset, pOutTicket);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::UploadToImage(const void* pData, vk::DeviceSize size, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	// Worst case texel/block size we upload (RGBA32F, BC3/5/7)
+	StagingRegion region;
+	CHECK(Reserve(size, 16, &region));
+
+	memcpy(region.pMappedData, pData, static_cast<size_t>(size));
+	CopyToImage(region, dstImage, bGenerateMips, pOutTicket);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanStagingRing::UploadImageLevels(const uint8_t* const* ppLevelData, const UT::VkStructs::VulkanImage& dstImage, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	// Levels may sit anywhere in source memory (KTX2 stores them smallest first), ring packs them mip 0 first so
+	// RecordImageCopy finds them where it expects
+	vk::DeviceSize totalSize = 0;
+	for (uint32_t mip = 0; mip < dstImage.mipLevels; ++mip)
+	{
+		totalSize += UT::VkUtility::GetImageLevelSize(dstImage.format, dstImage.extent.width, dstImage.extent.height, mip);
+	}
+
+	StagingRegion region;
+	CHECK(Reserve(totalSize, 16, &region));
+
+	uint8_t* pDst = static_cast<uint8_t*>(region.pMappedData);
+	for (uint32_t mip = 0; mip < dstImage.mipLevels; ++mip)
+	{
+		const vk::DeviceSize levelSize = UT::VkUtility::GetImageLevelSize(dstImage.format, dstImage.extent.width, dstImage.extent.height, mip);
+
+		memcpy(pDst, ppLevelData[mip], static_cast<size_t>(levelSize));
+		pDst += levelSize;
+	}
+
+	CopyToImage(region, dstImage, false, pOutTicket);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	FlushLocked();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::WaitIdle()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	FlushLocked();
+
+	while (!m_ListInFlightBatches.empty())
+	{
+		RetireCompletedBatches(true);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::WaitForTicket(const UT::VkStructs::UploadTicket& ticket)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Waiting on copies which aren't submitted yet would never return!
+		if (ticket.value > m_uiLastSubmittedValue)
+			FlushLocked();
+	}
+
+	vk::SemaphoreWaitInfo waitInfo = {};
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_vkTimelineSemaphore;
+	waitInfo.pValues = &ticket.value;
+
+	const vk::Result result = m_pDevice->GetDevice().waitSemaphores(waitInfo, UINT64_MAX);
+	UT_ASSERT_VK(result, "Waiting on upload ticket failed!");
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	RetireCompletedBatches(false);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint64_t VulkanStagingRing::RecordAcquireBarriers(vk::CommandBuffer graphicsCmdBuffer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_ListPendingBufferAcquires.empty() && m_ListPendingImageAcquires.empty())
+		return 0;
+
+	// Execution dependency on transfer queue comes from the timeline semaphore wait on frame submit, so src stage
+	// here is TOP_OF_PIPE. Frame must wait with same dst stages as this barrier!
+	graphicsCmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, UT::VkGlobals::GUploadAcquireStages,
+									  vk::DependencyFlags(), nullptr, m_ListPendingBufferAcquires, m_ListPendingImageAcquires);
+
+	// Acquired images that still need their mip chain are in TRANSFER_DST now, graphics queue can blit them
+	for (const PendingMipChain& mipChain : m_ListPendingMipChains)
+	{
+		m_pDevice->GenerateMipChain(mipChain.image, mipChain.width, mipChain.height, mipChain.mipLevels, graphicsCmdBuffer);
+	}
+
+	m_ListPendingBufferAcquires.clear();
+	m_ListPendingImageAcquires.clear();
+	m_ListPendingMipChains.clear();
+
+	return m_uiPendingAcquireValue;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint64_t VulkanStagingRing::GetCompletedTimelineValue() const
+{
+	return m_pDevice->GetDevice().getSemaphoreCounterValue(m_vkTimelineSemaphore);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::CommitCopy(const PendingCopy& copy, UT::VkStructs::UploadTicket* pOutTicket)
+{
+	m_ListPendingCopies.push_back(copy);
+	m_SetOutstandingRegions.erase(m_SetOutstandingRegions.find(copy.region.ringStart));
+
+	// Copy goes out with the next flush, which signals the next timeline value
+	if (pOutTicket)
+	{
+		pOutTicket->timeline = m_vkTimelineSemaphore;
+		pOutTicket->value = m_uiLastSubmittedValue + 1;
+	}
+
+	// main thread may be waiting for this copy to be able to flush & free up space!
+	m_cvSpaceFreed.notify_all();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::FlushLocked()
+{
+	m_bFlushRequested = false;
+
+	if (m_ListPendingCopies.empty())
+		return;
+
+	UploadBatch batch = AcquireBatch();
+
+	vk::CommandBufferBeginInfo beginInfo;
+	beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+	batch.cmdBuffer.begin(beginInfo);
+
+	for (const PendingCopy& copy : m_ListPendingCopies)
+	{
+		if (copy.dstImage)
+			RecordImageCopy(batch.cmdBuffer, copy);
+		else
+			RecordBufferCopy(batch.cmdBuffer, copy);
+	}
+
+	if (!m_bQueueOwnershipTransfer)
+	{
+		// Make transfer writes visible to whoever reads the buffers next on this queue. Commands submitted later on the
+		// same queue are ordered after this barrier, so no acquire is needed!
+		vk::MemoryBarrier memoryBarrier = {};
+		memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		memoryBarrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+									  vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+
+		batch.cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, UT::VkGlobals::GUploadAcquireStages,
+										vk::DependencyFlags(), memoryBarrier, nullptr, nullptr);
+	}
+
+	batch.cmdBuffer.end();
+
+	batch.timelineValue = ++m_uiLastSubmittedValue;
+
+	// Regions reserved by workers but not copied yet aren't part of this batch, don't let the tail run past them!
+	batch.ringEnd = m_SetOutstandingRegions.empty() ? m_uiHead : *m_SetOutstandingRegions.begin();
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &batch.timelineValue;
+
+	vk::SubmitInfo submitInfo;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch.cmdBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_vkTimelineSemaphore;
+
+	m_vkTransferQueue.submit(submitInfo, nullptr);
+
+	// Resources in this batch can be acquired on graphics queue once its timeline value is reached
+	if (m_bQueueOwnershipTransfer)
+		m_uiPendingAcquireValue = batch.timelineValue;
+
+	m_ListPendingCopies.clear();
+	m_ListInFlightBatches.push_back(batch);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanStagingRing::UploadBatch VulkanStagingRing::AcquireBatch()
+{
+	UploadBatch batch;
+
+	// Recycle a retired batch if we have one, its pool was reset when it retired...
+	if (!m_ListFreeBatches.empty())
+	{
+		batch = m_ListFreeBatches.back();
+		m_ListFreeBatches.pop_back();
+	}
+	else
+	{
+		// ...otherwise make a new one! Pools of our own, upload command buffers never fight with frame command buffers
+		vk::CommandPoolCreateInfo poolInfo = {};
+		poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+		poolInfo.queueFamilyIndex = m_uiTransferFamily;
+
+		batch.cmdPool = m_pDevice->GetDevice().createCommandPool(poolInfo);
+
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.level = vk::CommandBufferLevel::ePrimary;
+		allocInfo.commandPool = batch.cmdPool;
+		allocInfo.commandBufferCount = 1;
+
+		batch.cmdBuffer = m_pDevice->GetDevice().allocateCommandBuffers(allocInfo).front();
+	}
+
+	batch.timelineValue = 0;
+	batch.ringEnd = 0;
+
+	return batch;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::RecordBufferCopy(vk::CommandBuffer cmdBuffer, const PendingCopy& copy)
+{
+	vk::BufferCopy bufferCopyRegion;
+	bufferCopyRegion.srcOffset = copy.region.offset;
+	bufferCopyRegion.dstOffset = copy.dstOffset;
+	bufferCopyRegion.size = copy.region.size;
+
+	cmdBuffer.copyBuffer(copy.region.buffer, copy.dstBuffer, 1, &bufferCopyRegion);
+
+	if (m_bQueueOwnershipTransfer)
+		ReleaseBuffer(cmdBuffer, copy.dstBuffer, copy.dstOffset, copy.region.size);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::RecordImageCopy(vk::CommandBuffer cmdBuffer, const PendingCopy& copy)
+{
+	// Transition image to be DST for copy operation
+	m_pDevice->TransitionImageLayout(copy.dstImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, cmdBuffer);
+
+	// Region holds either just mip 0 or every level tightly packed one after another
+	const uint32_t copiedLevels = copy.bGenerateMips ? 1 : copy.mipLevels;
+
+	std::vector<vk::BufferImageCopy> listImgRegions(copiedLevels);
+	vk::DeviceSize levelOffset = copy.region.offset;
+
+	for (uint32_t mip = 0; mip < copiedLevels; ++mip)
+	{
+		const uint32_t mipWidth = std::max(copy.width >> mip, 1u);
+		const uint32_t mipHeight = std::max(copy.height >> mip, 1u);
+
+		vk::BufferImageCopy& imgRegion = listImgRegions[mip];
+		imgRegion.bufferOffset = levelOffset;
+		imgRegion.bufferRowLength = 0;
+		imgRegion.bufferImageHeight = 0;
+		imgRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+		imgRegion.imageSubresource.mipLevel = mip;
+		imgRegion.imageSubresource.baseArrayLayer = 0;
+		imgRegion.imageSubresource.layerCount = 1;
+		imgRegion.imageOffset = VkOffset3D{ 0,0,0 };
+		imgRegion.imageExtent = VkExtent3D{ mipWidth, mipHeight, 1 };
+
+		levelOffset += UT::VkUtility::GetImageLevelSize(copy.format, copy.width, copy.height, mip);
+	}
+
+	cmdBuffer.copyBufferToImage(copy.region.buffer, copy.dstImage, vk::ImageLayout::eTransferDstOptimal, listImgRegions);
+
+	if (copy.bGenerateMips)
+	{
+		// Transfer queue can't blit, so image goes to graphics family still in TRANSFER_DST & gets its mips there
+		if (m_bQueueOwnershipTransfer)
+		{
+			ReleaseImage(cmdBuffer, copy.dstImage, vk::ImageLayout::eTransferDstOptimal);
+			m_ListPendingMipChains.push_back({ copy.dstImage, copy.width, copy.height, copy.mipLevels });
+		}
+		else
+		{
+			m_pDevice->GenerateMipChain(copy.dstImage, copy.width, copy.height, copy.mipLevels, cmdBuffer);
+		}
+
+		return;
+	}
+
+	// Transition image to be Shader Readable for shader usage, on transfer queue that happens as part of ownership
+	// transfer since transfer queue doesn't know about shader stages!
+	if (m_bQueueOwnershipTransfer)
+		ReleaseImage(cmdBuffer, copy.dstImage, vk::ImageLayout::eShaderReadOnlyOptimal);
+	else
+		m_pDevice->TransitionImageLayout(copy.dstImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, cmdBuffer);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::RetireCompletedBatches(bool bWaitForOldest)
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	if (!m_ListInFlightBatches.empty())
+	{
+		if (bWaitForOldest)
+		{
+			const uint64_t waitValue = m_ListInFlightBatches.front().timelineValue;
+
+			vk::SemaphoreWaitInfo waitInfo = {};
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &m_vkTimelineSemaphore;
+			waitInfo.pValues = &waitValue;
+
+			const vk::Result result = vkDevice.waitSemaphores(waitInfo, UINT64_MAX);
+			UT_ASSERT_VK(result, "Waiting on staging ring timeline failed!");
+		}
+
+		const uint64_t completedValue = GetCompletedTimelineValue();
+
+		while (!m_ListInFlightBatches.empty() && m_ListInFlightBatches.front().timelineValue <= completedValue)
+		{
+			// GPU is done reading this part of the ring, hand it back!
+			m_uiTail = m_ListInFlightBatches.front().ringEnd;
+
+			vkDevice.resetCommandPool(m_ListInFlightBatches.front().cmdPool);
+			m_ListFreeBatches.push_back(m_ListInFlightBatches.front());
+			m_ListInFlightBatches.pop_front();
+
+			m_cvSpaceFreed.notify_all();
+		}
+	}
+
+	// Nothing in flight, queued or being filled, whole ring is free again
+	if (m_ListInFlightBatches.empty() && m_ListPendingCopies.empty() && m_SetOutstandingRegions.empty())
+	{
+		m_uiHead = 0;
+		m_uiTail = 0;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::ReleaseBuffer(vk::CommandBuffer cmdBuffer, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, vk::DeviceSize size)
+{
+	// Release & acquire must describe exactly the same barrier, only stage/access masks differ
+	vk::BufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.srcQueueFamilyIndex = m_uiTransferFamily;
+	bufferBarrier.dstQueueFamilyIndex = m_uiGraphicsFamily;
+	bufferBarrier.buffer = dstBuffer;
+	bufferBarrier.offset = dstOffset;
+	bufferBarrier.size = size;
+
+	// Release : make transfer writes available, dst masks are ignored for release
+	bufferBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	bufferBarrier.dstAccessMask = vk::AccessFlagBits::eNone;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+							  vk::DependencyFlags(), nullptr, bufferBarrier, nullptr);
+
+	// Acquire : recorded later on graphics queue
+	bufferBarrier.srcAccessMask = vk::AccessFlagBits::eNone;
+	bufferBarrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+								  vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+
+	m_ListPendingBufferAcquires.push_back(bufferBarrier);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanStagingRing::ReleaseImage(vk::CommandBuffer cmdBuffer, vk::Image dstImage, vk::ImageLayout newLayout)
+{
+	vk::ImageMemoryBarrier imageBarrier = {};
+	imageBarrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+	imageBarrier.newLayout = newLayout;
+	imageBarrier.srcQueueFamilyIndex = m_uiTransferFamily;
+	imageBarrier.dstQueueFamilyIndex = m_uiGraphicsFamily;
+	imageBarrier.image = dstImage;
+	imageBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+	imageBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	imageBarrier.dstAccessMask = vk::AccessFlagBits::eNone;
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+							  vk::DependencyFlags(), nullptr, nullptr, imageBarrier);
+
+	imageBarrier.srcAccessMask = vk::AccessFlagBits::eNone;
+	imageBarrier.dstAccessMask = (newLayout == vk::ImageLayout::eTransferDstOptimal) ? vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite
+																					  : vk::AccessFlagBits::eShaderRead;
+
+	m_ListPendingImageAcquires.push_back(imageBarrier);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Slice of the staging ring. pMappedData points straight into persistently mapped host memory, just memcpy into it!
+struct StagingRegion
+{
+	StagingRegion()
+	{
+		buffer = nullptr;
+		offset = 0;
+		size = 0;
+		ringStart = 0;
+		pMappedData = nullptr;
+	}
+
+	vk::Buffer						buffer;
+	vk::DeviceSize					offset;
+	vk::DeviceSize					size;
+	uint64_t						ringStart;			// position in ring's monotonic byte counter, used for bookkeeping
+	void*							pMappedData;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// One host visible buffer, mapped for its whole life, used as a ring for every upload to device local memory.
+// Copies are batched into a single transfer command buffer which is submitted on Flush() (or when ring runs out of
+// space). Every submitted batch signals the next value of a timeline semaphore, space is recycled once it's reached.
+//
+// If device has a dedicated transfer queue family, batches are submitted there & resources are released to graphics
+// family at the end of each copy. Renderer records matching acquire barriers with RecordAcquireBarriers() & makes its
+// frame submit wait on the returned timeline value, so graphics queue never blocks on uploads it doesn't need yet.
+//
+// Reserve(), CopyToXXX() & UploadToXXX() can be called from any thread: they only fill the ring & queue the copy.
+// Commands are recorded & submitted by Flush(), which (like everything touching the queue) is main thread only. A
+// worker finding the ring full queues a Flush() as a main thread job & waits for space.
+class UT_API VulkanStagingRing
+{
+public:
+	VulkanStagingRing();
+	~VulkanStagingRing();
+
+	bool							Initialize(const VulkanDevice* pDevice, vk::DeviceSize ringSize);
+	void							Cleanup();
+
+	bool							Reserve(vk::DeviceSize size, vk::DeviceSize alignment, StagingRegion* pOutRegion);
+	void							CopyToBuffer(const StagingRegion& region, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, UT::VkStructs::UploadTicket* pOutTicket = nullptr);
+	void							CopyToImage(const StagingRegion& region, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips, UT::VkStructs::UploadTicket* pOutTicket = nullptr);
+
+	bool							UploadToBuffer(const void* pData, vk::DeviceSize size, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, UT::VkStructs::UploadTicket* pOutTicket = nullptr);
+	bool							UploadToImage(const void* pData, vk::DeviceSize size, const UT::VkStructs::VulkanImage& dstImage, bool bGenerateMips, UT::VkStructs::UploadTicket* pOutTicket = nullptr);
+	bool							UploadImageLevels(const uint8_t* const* ppLevelData, const UT::VkStructs::VulkanImage& dstImage, UT::VkStructs::UploadTicket* pOutTicket = nullptr);
+
+	// -- main thread only!
+	void							Flush();
+	void							WaitIdle();
+	void							WaitForTicket(const UT::VkStructs::UploadTicket& ticket);
+	uint64_t						RecordAcquireBarriers(vk::CommandBuffer graphicsCmdBuffer);
+
+	inline vk::Semaphore			GetTimelineSemaphore() const			{ return m_vkTimelineSemaphore; }
+	uint64_t						GetCompletedTimelineValue() const;
+
+private:
+	struct UploadBatch
+	{
+		vk::CommandPool				cmdPool;			// transient pool of its own, reset wholesale when batch retires
+		vk::CommandBuffer			cmdBuffer;
+		uint64_t					timelineValue;		// timeline semaphore value signaled when batch finishes on GPU
+		uint64_t					ringEnd;			// tail moves here once batch finishes on GPU
+	};
+
+	struct PendingCopy
+	{
+		StagingRegion				region;
+		vk::Buffer					dstBuffer;
+		vk::DeviceSize				dstOffset;
+		vk::Image					dstImage;
+		vk::Format					format;
+		uint32_t					width;
+		uint32_t					height;
+		uint32_t					mipLevels;
+		bool						bGenerateMips;		// region holds mip 0 only, rest is blitted on a graphics queue
+	};
+
+	struct PendingMipChain
+	{
+		vk::Image					image;
+		uint32_t					width;
+		uint32_t					height;
+		uint32_t					mipLevels;
+	};
+
+	// -- m_Mutex must be held!
+	void							FlushLocked();
+	void							RetireCompletedBatches(bool bWaitForOldest);
+	void							CommitCopy(const PendingCopy& copy, UT::VkStructs::UploadTicket* pOutTicket);
+	UploadBatch						AcquireBatch();
+	void							RecordBufferCopy(vk::CommandBuffer cmdBuffer, const PendingCopy& copy);
+	void							RecordImageCopy(vk::CommandBuffer cmdBuffer, const PendingCopy& copy);
+	void							ReleaseBuffer(vk::CommandBuffer cmdBuffer, vk::Buffer dstBuffer, vk::DeviceSize dstOffset, vk::DeviceSize size);
+	void							ReleaseImage(vk::CommandBuffer cmdBuffer, vk::Image dstImage, vk::ImageLayout newLayout);
+
+private:
+	const VulkanDevice*				m_pDevice;
+	std::thread::id					m_OwnerThreadId;
+
+	UT::VkStructs::VulkanBuffer		m_RingBuffer;
+	uint8_t*						m_pMappedRing;
+	vk::DeviceSize					m_vkRingSize;
+
+	// monotonic byte counters, ring offset = counter % ring size
+	uint64_t						m_uiHead;
+	uint64_t						m_uiTail;
+
+	vk::Queue						m_vkTransferQueue;
+	bool							m_bQueueOwnershipTransfer;		// transfer & graphics families differ
+	uint32_t						m_uiTransferFamily;
+	uint32_t						m_uiGraphicsFamily;
+
+	vk::Semaphore					m_vkTimelineSemaphore;
+	uint64_t						m_uiLastSubmittedValue;
+
+	// regions handed out by Reserve() but not copied yet, batches can't release ring space beyond the oldest of these
+	std::multiset<uint64_t>			m_SetOutstandingRegions;
+	std::vector<PendingCopy>		m_ListPendingCopies;
+
+	std::list<UploadBatch>			m_ListInFlightBatches;
+	std::vector<UploadBatch>		m_ListFreeBatches;
+
+	// acquire half of ownership transfers for submitted batches, recorded on graphics queue by renderer
+	std::vector<vk::BufferMemoryBarrier>	m_ListPendingBufferAcquires;
+	std::vector<vk::ImageMemoryBarrier>		m_ListPendingImageAcquires;
+	std::vector<PendingMipChain>	m_ListPendingMipChains;			// blitted right after their acquire
+	uint64_t						m_uiPendingAcquireValue;
+
+	bool							m_bFlushRequested;				// a worker queued a Flush() on main thread, not run yet
+
+	std::mutex						m_Mutex;
+	std::condition_variable			m_cvSpaceFreed;
+};
@@ -0,0 +1,176 @@
+#include "UltimateEnginePCH.h"
+#include "VulkanUniformArena.h"
+#include "VulkanDevice.h"
+#include "VulkanLayoutCache.h"
+#include "VulkanDescriptorAllocator.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanUniformArena::VulkanUniformArena()
+{
+	m_pDevice = nullptr;
+	m_vkDescriptorSetLayout = nullptr;
+	m_vkFrameSize = 0;
+	m_vkAlignment = 0;
+	m_vkHead = 0;
+	m_uiCurrentFrame = 0;
+
+	m_ListFrames.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+VulkanUniformArena::~VulkanUniformArena()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanUniformArena::Initialize(const VulkanDevice* pDevice, vk::DeviceSize frameSize)
+{
+	m_pDevice = pDevice;
+	m_vkFrameSize = frameSize;
+
+	// Dynamic offsets must be multiple of this, storage buffer ranges of culling pass too. Both are powers of 2 by spec
+	const vk::PhysicalDeviceLimits& limits = m_pDevice->GetPhysicalDevice().getProperties().limits;
+	m_vkAlignment = std::max<vk::DeviceSize>({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16 });
+
+	CHECK_LOG(m_vkFrameSize > UT::VkGlobals::GMaxUniformBlockSize, "Uniform arena smaller than a single block?!");
+
+	// Layout doesn't depend on frame count, pipeline layouts can be built against it right away. Layout cache owns it!
+	vk::DescriptorSetLayoutBinding layoutBinding = {};
+	layoutBinding.binding = 0;
+	layoutBinding.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+	layoutBinding.descriptorCount = 1;
+	layoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+	m_vkDescriptorSetLayout = m_pDevice->GetLayoutCache()->GetDescriptorSetLayout({ layoutBinding });
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanUniformArena::Cleanup()
+{
+	DestroyFrames();
+
+	m_vkDescriptorSetLayout = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool VulkanUniformArena::CreateFrames(uint32_t frameCount)
+{
+	// One frame per frame context, nothing to do if they already exist
+	if (m_ListFrames.size() == frameCount)
+		return true;
+
+	DestroyFrames();
+
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	m_ListFrames.resize(frameCount);
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		ArenaFrame& frame = m_ListFrames[i];
+
+		CHECK_LOG(m_pDevice->CreateBuffer(m_vkFrameSize, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+										  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+										  &frame.buffer), "Failed to create uniform arena buffer!");
+
+		// Mapped for its whole life, coherent so writes need no flush!
+		frame.pMappedData = static_cast<uint8_t*>(frame.buffer.allocation.Map());
+		CHECK_LOG(frame.pMappedData, "Failed to map uniform arena!");
+
+		// Sets come from device's descriptor allocator & go back to it with DestroyFrames()
+		frame.descriptorSet = m_pDevice->GetDescriptorAllocator()->Allocate(m_vkDescriptorSetLayout);
+		CHECK_LOG(frame.descriptorSet, "Failed to allocate uniform arena's descriptor set!");
+
+		// Range is fixed by descriptor, offset comes at bind time
+		vk::DescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = frame.buffer.buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = UT::VkGlobals::GMaxUniformBlockSize;
+
+		vk::WriteDescriptorSet writeSet = {};
+		writeSet.dstSet = frame.descriptorSet;
+		writeSet.dstBinding = 0;
+		writeSet.dstArrayElement = 0;
+		writeSet.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+		writeSet.descriptorCount = 1;
+		writeSet.pBufferInfo = &bufferInfo;
+
+		vkDevice.updateDescriptorSets(writeSet, nullptr);
+	}
+
+	LOG_DEBUG("Uniform arena : {0} frame(s) of {1} KB", frameCount, m_vkFrameSize / 1024);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanUniformArena::DestroyFrames()
+{
+	const vk::Device vkDevice = m_pDevice->GetDevice();
+
+	for (ArenaFrame& frame : m_ListFrames)
+	{
+		frame.buffer.allocation.Unmap();
+		frame.buffer.DestroyAll(vkDevice);
+
+		m_pDevice->GetDescriptorAllocator()->Free(m_vkDescriptorSetLayout, frame.descriptorSet);
+	}
+
+	m_ListFrames.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VulkanUniformArena::BeginFrame(uint32_t frameIndex)
+{
+	// GPU is done with this frame's buffer (its fence was waited on), so everything in it can be overwritten
+	m_uiCurrentFrame = frameIndex;
+	m_vkHead = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void* VulkanUniformArena::Allocate(vk::DeviceSize size, uint32_t* pOutDynamicOffset)
+{
+	UT_ASSERT_BOOL((size <= UT::VkGlobals::GMaxUniformBlockSize), "Uniform block is bigger than arena's binding range!");
+
+	// Binding always reads GMaxUniformBlockSize bytes from the offset, so last block still needs that much room
+	const vk::DeviceSize offset = (m_vkHead + m_vkAlignment - 1) & ~(m_vkAlignment - 1);
+	if (offset + UT::VkGlobals::GMaxUniformBlockSize > m_vkFrameSize)
+	{
+		LOG_ERROR("Uniform arena is full, increase GUniformArenaSize!");
+		return nullptr;
+	}
+
+	m_vkHead = offset + size;
+	*pOutDynamicOffset = static_cast<uint32_t>(offset);
+
+	return m_ListFrames[m_uiCurrentFrame].pMappedData + offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void* VulkanUniformArena::AllocateData(vk::DeviceSize size, uint32_t* pOutOffset)
+{
+	// Vertex input & indirect draws read exactly what's there, so no binding range to leave room for. Can be bigger than
+	// a uniform block!
+	const vk::DeviceSize offset = (m_vkHead + m_vkAlignment - 1) & ~(m_vkAlignment - 1);
+	if (offset + size > m_vkFrameSize)
+	{
+		LOG_ERROR("Uniform arena is full, increase GUniformArenaSize!");
+		return nullptr;
+	}
+
+	m_vkHead = offset + size;
+	*pOutOffset = static_cast<uint32_t>(offset);
+
+	return m_ListFrames[m_uiCurrentFrame].pMappedData + offset;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+vk::DeviceSize VulkanUniformArena::GetFreeDataSize() const
+{
+	// What a single AllocateData() could still get this frame
+	const vk::DeviceSize offset = (m_vkHead + m_vkAlignment - 1) & ~(m_vkAlignment - 1);
+	return (offset < m_vkFrameSize) ? m_vkFrameSize - offset : 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "VulkanGlobals.h"
+
+class VulkanDevice;
+
+//---------------------------------------------------------------------------------------------------------------------
+// One persistently mapped uniform buffer per frame, every object's uniform block is bump allocated into it at
+// minUniformBufferOffsetAlignment. Whole frame shares a single descriptor set (set 0, binding 0) with a
+// UNIFORM_BUFFER_DYNAMIC binding, objects only pass their offset while binding it. Buffer & descriptor count depends
+// on number of frames, not on number of objects!
+//
+// Per instance data, draw bounds & indirect draw commands are packed right next to the uniforms with AllocateData().
+// Culling pass reads them as storage buffers & copies draw table out of it, so same buffer is also a storage & transfer
+// source buffer.
+//
+// Allocate() is main thread only & only valid between BeginFrame() & the submit of that frame.
+class UT_API VulkanUniformArena
+{
+public:
+	VulkanUniformArena();
+	~VulkanUniformArena();
+
+	bool								Initialize(const VulkanDevice* pDevice, vk::DeviceSize frameSize);
+	void								Cleanup();
+
+	bool								CreateFrames(uint32_t frameCount);
+	void								DestroyFrames();
+
+	void								BeginFrame(uint32_t frameIndex);
+	void*								Allocate(vk::DeviceSize size, uint32_t* pOutDynamicOffset);
+	void*								AllocateData(vk::DeviceSize size, uint32_t* pOutOffset);
+	vk::DeviceSize						GetFreeDataSize() const;
+
+	inline vk::DescriptorSetLayout		GetDescriptorSetLayout() const					{ return m_vkDescriptorSetLayout; }
+	inline vk::DescriptorSet			GetDescriptorSet(uint32_t frameIndex) const		{ return m_ListFrames[frameIndex].descriptorSet; }
+	inline vk::Buffer					GetBuffer(uint32_t frameIndex) const			{ return m_ListFrames[frameIndex].buffer.buffer; }
+	inline vk::DeviceSize				GetUsedSize() const								{ return m_vkHead; }
+
+private:
+	struct ArenaFrame
+	{
+		UT::VkStructs::VulkanBuffer		buffer;
+		uint8_t*						pMappedData;
+		vk::DescriptorSet				descriptorSet;
+	};
+
+private:
+	const VulkanDevice*					m_pDevice;
+
+	vk::DescriptorSetLayout				m_vkDescriptorSetLayout;
+	std::vector<ArenaFrame>				m_ListFrames;
+
+	vk::DeviceSize						m_vkFrameSize;
+	vk::DeviceSize						m_vkAlignment;
+	vk::DeviceSize						m_vkHead;
+	uint32_t							m_uiCurrentFrame;
+};
@@ -0,0 +1,85 @@
+#include "UltimateEnginePCH.h"
+#include "AssetLoader.h"
+#include "../RenderObjects/GameObject.h"
+#include "../VulkanRenderer/VulkanDevice.h"
+#include "../EngineHeader.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+AssetLoader::AssetLoader()
+{
+	m_pDevice = nullptr;
+	m_uiPendingLoads = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+AssetLoader::~AssetLoader()
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+bool AssetLoader::Initialize(const VulkanDevice* pDevice)
+{
+	m_pDevice = pDevice;
+
+	// Loads run on engine's job system, nothing to start here
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AssetLoader::Cleanup()
+{
+	// Workers must be done with objects & staging ring before anything gets destroyed!
+	JobSystem::getInstance().Wait(&m_LoadJobs);
+
+	m_ListLoadedObjects.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void AssetLoader::QueueLoad(GameObject* pObject)
+{
+	++m_uiPendingLoads;
+
+	// Decode takes a while, background so no frame ever waits on it
+	JobSystem::getInstance().RunBackground([this, pObject]()
+	{
+		const bool bLoaded = pObject->LoadAssets(m_pDevice);
+
+		if (!bLoaded)
+		{
+			LOG_ERROR("{0} failed to load assets!", pObject->getName());
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ListLoadedObjects.emplace_back(pObject, bLoaded);
+	}, &m_LoadJobs);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+uint32_t AssetLoader::FinalizeLoadedObjects()
+{
+	std::vector<std::pair<GameObject*, bool>> listLoaded;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		listLoaded.swap(m_ListLoadedObjects);
+	}
+
+	uint32_t finalizedCount = 0;
+
+	for (const std::pair<GameObject*, bool>& loaded : listLoaded)
+	{
+		if (loaded.second && loaded.first->FinalizeAssets(m_pDevice))
+		{
+			++finalizedCount;
+		}
+
+		--m_uiPendingLoads;
+	}
+
+	if (!listLoaded.empty() && !IsBusy())
+	{
+		LOG_INFO("Asset loader finished all queued objects");
+	}
+
+	return finalizedCount;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../Core/Core.h"
+#include "../Core/JobSystem.h"
+
+#include <mutex>
+#include <atomic>
+
+class VulkanDevice;
+class GameObject;
+
+//---------------------------------------------------------------------------------------------------------------------
+// Loads game objects in three stages :
+//	1. Job system's workers read & decode files (GameObject::LoadAssets)
+//	2. ...and on the same worker, copy decoded data into the staging ring
+//	3. Main thread creates descriptors etc. (GameObject::FinalizeAssets) & submits staged copies with FlushUploads()
+// Objects become renderable one by one as their uploads complete, nobody waits for the whole scene.
+class UT_API AssetLoader
+{
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	bool								Initialize(const VulkanDevice* pDevice);
+	void								Cleanup();
+
+	void								QueueLoad(GameObject* pObject);
+	uint32_t							FinalizeLoadedObjects();
+
+	inline bool							IsBusy() const					{ return m_uiPendingLoads.load() > 0; }
+
+private:
+	const VulkanDevice*					m_pDevice;
+	JobCounter							m_LoadJobs;						// stage 1 & 2 jobs still running
+
+	// objects done with stage 1 & 2, waiting for main thread
+	std::mutex							m_Mutex;
+	std::vector<std::pair<GameObject*, bool>>	m_ListLoadedObjects;
+
+	std::atomic<uint32_t>				m_uiPendingLoads;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../RenderObjects/VulkanMeshData.h"
+
+class VulkanMesh;
+
+//---------------------------------------------------------------------------------------------------------------------
+// One ready object as simulation left it, renderer batches & packs these instead of reading live objects.
+struct SnapshotObject
+{
+	SnapshotObject()
+	{
+		pMesh = nullptr;
+	}
+
+	const VulkanMesh*					pMesh;				// meshes live till scene cleanup, safe to hold on to
+	InstanceData						instanceData;		// material & draw index are filled by renderer
+	MaterialUniformData					materialData;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Everything renderer needs out of the scene for one frame : camera, transforms & materials. Simulation fills one while
+// renderer reads the other, never touched by both at once so neither waits on the other's object state!
+struct RenderSnapshot
+{
+	ViewUniformData						viewData;
+	std::vector<SnapshotObject>			listObjects;		// cleared & refilled every frame, memory is reused
+};
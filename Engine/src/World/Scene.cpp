@@ -4,20 +4,79 @@
 #include "../RenderObjects/GameObject.h"
 #include "../VulkanRenderer/VulkanDevice.h"
 #include "../RenderObjects/VulkanCube.h"
+#include "../RenderObjects/VulkanMesh.h"
+#include "../RenderObjects/VulkanMeshPool.h"
+#include "../RenderObjects/VulkanMeshData.h"
+#include "../VulkanRenderer/VulkanUniformArena.h"
+#include "../VulkanRenderer/VulkanBindlessTextures.h"
+#include "../VulkanRenderer/VulkanCullingPass.h"
+#include "AssetLoader.h"
+#include "RenderSnapshot.h"
+#include "../Core/JobSystem.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+Scene::Scene()
+{
+	m_pCamera = nullptr;
+	m_pAssetLoader = nullptr;
+	m_pDevice = nullptr;
+	m_uiViewUniformOffset = 0;
+	m_uiMaterialUniformOffset = 0;
+	m_uiInstanceDataOffset = 0;
+	m_uiDrawCommandOffset = 0;
+	m_uiDrawBoundsOffset = 0;
+	m_matViewProjection = glm::mat4(1);
+
+	m_pSnapshots[0] = new RenderSnapshot();
+	m_pSnapshots[1] = new RenderSnapshot();
+	m_uiSimulationSnapshot = 0;
+	m_bSimulating = false;
+}
 
 //---------------------------------------------------------------------------------------------------------------------
 bool Scene::LoadScene(const VulkanDevice* pDevice)
 {
+	m_pDevice = pDevice;
 	m_pCamera = new Camera();
+
+	m_pAssetLoader = new AssetLoader();
+	CHECK(m_pAssetLoader->Initialize(pDevice));
+
+	// Only queues loading, objects show up over next few frames as they get ready!
 	CHECK(LoadModels(pDevice));
+
+	return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void Scene::Cleanup(VulkanDevice* pDevice)
 {
+	// Workers might still be touching objects, let them finish first!
+	EndSimulation();
+
+	if (m_pAssetLoader)
+		m_pAssetLoader->Cleanup();
+
 	for (GameObject* object : m_ListModels)
 	{
 		object->Cleanup(reinterpret_cast<void*>(pDevice));
+		SAFE_DELETE(object);
+	}
+
+	m_ListModels.clear();
+
+	SAFE_DELETE(m_pAssetLoader);
+	SAFE_DELETE(m_pCamera);
+	SAFE_DELETE(m_pSnapshots[0]);
+	SAFE_DELETE(m_pSnapshots[1]);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Scene::UpdateLoading()
+{
+	if (m_pAssetLoader->IsBusy())
+	{
+		m_pAssetLoader->FinalizeLoadedObjects();
 	}
 }
 
@@ -26,39 +85,304 @@ void Scene::Update(double dt) const
 {
 	m_pCamera->Update(dt);
 
-	for (GameObject* object : m_ListModels)
+	m_ListUpdatedModels.assign(m_ListModels.size(), 0);
+
+	// Objects only touch their own data, spread them over every core
+	constexpr uint32_t minObjectsPerJob = 64;
+
+	JobSystem::getInstance().ParallelFor(static_cast<uint32_t>(m_ListModels.size()), minObjectsPerJob, [this, dt](uint32_t first, uint32_t last)
 	{
-		if (const VulkanCube* pCube = dynamic_cast<VulkanCube*>(object))
+		for (uint32_t i = first; i < last; ++i)
 		{
-			pCube->Update(m_pCamera, dt);
+			GameObject* object = m_ListModels[i];
+			if (!object->IsReady(m_pDevice))
+				continue;
+
+			if (VulkanCube* pCube = dynamic_cast<VulkanCube*>(object))
+			{
+				pCube->Update(dt);
+				m_ListUpdatedModels[i] = 1;
+			}
 		}
-	}
+	});
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void Scene::UpdateUniforms(const VulkanDevice* pDevice, uint32_t imageIndex) const
+void Scene::BeginSimulation(double dt)
 {
-	const vk::Device vkDevice = pDevice->GetDevice();
+	// Previous one has to be done, its snapshot is what renderer reads next!
+	EndSimulation();
 
-	for (GameObject* object : m_ListModels)
+	RenderSnapshot* pSnapshot = m_pSnapshots[m_uiSimulationSnapshot];
+	m_bSimulating = true;
+
+	// High priority : never queued behind asset loads. Main thread only ever runs it itself if it's still queued by the time
+	// EndSimulation() waits on it
+	JobSystem::getInstance().RunHighPriority([this, dt, pSnapshot]()
 	{
-		if (const VulkanCube* pCube = dynamic_cast<VulkanCube*>(object))
-		{
-			pCube->UpdateUniforms(vkDevice, imageIndex);
-		}
+		Update(dt);
+		BuildSnapshot(pSnapshot);
+	}, &m_SimulationJobs);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Scene::EndSimulation()
+{
+	if (!m_bSimulating)
+		return;
+
+	JobSystem::getInstance().Wait(&m_SimulationJobs);
+	m_bSimulating = false;
+
+	// Fresh snapshot goes to renderer, the one it was reading is simulation's next
+	m_uiSimulationSnapshot ^= 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Scene::BuildSnapshot(RenderSnapshot* pOutSnapshot) const
+{
+	ViewUniformData& viewData = pOutSnapshot->viewData;
+	viewData.matView = m_pCamera->m_matView;
+	viewData.matProjection = m_pCamera->m_matProjection;
+	viewData.matProjection[1][1] *= -1.0f;
+	viewData.matViewProjection = viewData.matProjection * viewData.matView;
+	viewData.cameraPosition = glm::vec4(m_pCamera->m_vecCameraPosition, 1.0f);
+
+	pOutSnapshot->listObjects.clear();
+
+	// Asking IsReady() again could let in an object which finished uploading after Update() skipped it, it'd be drawn
+	// with a world matrix nobody has computed yet!
+	for (uint32_t i = 0; i < m_ListModels.size(); ++i)
+	{
+		if (!m_ListUpdatedModels[i])
+			continue;
+
+		const VulkanCube* pCube = static_cast<const VulkanCube*>(m_ListModels[i]);
+
+		pOutSnapshot->listObjects.emplace_back();
+		pCube->FillSnapshot(&pOutSnapshot->listObjects.back());
 	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void Scene::Render(const VulkanDevice* pDevice, uint32_t imageIndex) const
+void Scene::UpdateUniforms(const VulkanDevice* pDevice) const
 {
-	for (GameObject* object : m_ListModels)
+	// Every object in the snapshot packs into this frame's arena, renderer has already begun the arena frame!
+	VulkanUniformArena* pUniformArena = pDevice->GetUniformArena();
+
+	// Nothing gets drawn unless everything below makes it into the arena
+	m_ListDrawBatches.clear();
+	m_ListBatchedObjects.clear();
+	m_ListFrameMaterials.clear();
+
+	// Simulation is done with this one & won't touch it till next frame's simulation starts
+	const RenderSnapshot* pSnapshot = m_pSnapshots[m_uiSimulationSnapshot ^ 1];
+
+	// View block goes first, once per frame
+	m_matViewProjection = pSnapshot->viewData.matViewProjection;
+
+	void* pViewData = pUniformArena->Allocate(sizeof(ViewUniformData), &m_uiViewUniformOffset);
+	if (!pViewData)
+	{
+		LOG_ERROR("Failed to pack view uniform data!");
+		return;
+	}
+
+	memcpy(pViewData, &pSnapshot->viewData, sizeof(ViewUniformData));
+
+	// Group snapshot's objects by mesh, every group becomes one instanced draw. Identical materials share a slot in
+	// frame's material block, so a crowd of same props costs one draw & one material no matter how big it is!
+	std::unordered_map<const VulkanMesh*, uint32_t> umapMeshBatches;
+
+	for (const SnapshotObject& object : pSnapshot->listObjects)
 	{
-		if (const VulkanCube* pCube = dynamic_cast<VulkanCube*>(object))
+		// Culling pass' output buffers are fixed size
+		if (m_ListBatchedObjects.size() == UT::VkGlobals::GMaxCulledInstances)
 		{
-			pCube->Render(pDevice, imageIndex);
+			LOG_ERROR("Too many instances for one frame, {0} skipped!", pSnapshot->listObjects.size() - m_ListBatchedObjects.size());
+			break;
 		}
+
+		if (m_ListDrawBatches.size() == UT::VkGlobals::GMaxCulledDraws && umapMeshBatches.find(object.pMesh) == umapMeshBatches.end())
+		{
+			LOG_ERROR("Too many meshes for one frame's draw table, object skipped!");
+			continue;
+		}
+
+		// Few distinct materials per frame, a linear search beats hashing them
+		const MaterialUniformData& materialData = object.materialData;
+		uint32_t materialIndex = 0;
+		while (materialIndex < m_ListFrameMaterials.size() && !(*m_ListFrameMaterials[materialIndex] == materialData))
+			++materialIndex;
+
+		if (materialIndex == m_ListFrameMaterials.size())
+		{
+			if (materialIndex == UT::VkGlobals::GMaxMaterialsPerFrame)
+			{
+				LOG_ERROR("Too many materials for one frame's material block, object skipped!");
+				continue;
+			}
+
+			m_ListFrameMaterials.push_back(&materialData);
+		}
+
+		const std::pair<std::unordered_map<const VulkanMesh*, uint32_t>::iterator, bool> batchIter = umapMeshBatches.emplace(object.pMesh, static_cast<uint32_t>(m_ListDrawBatches.size()));
+		if (batchIter.second)
+		{
+			DrawBatch batch;
+			batch.pMesh = object.pMesh;
+			batch.firstInstance = 0;
+			batch.instanceCount = 0;
+			m_ListDrawBatches.push_back(batch);
+		}
+
+		const uint32_t slotInBatch = m_ListDrawBatches[batchIter.first->second].instanceCount++;
+		m_ListBatchedObjects.push_back({ &object, batchIter.first->second, materialIndex, slotInBatch });
+	}
+
+	if (m_ListBatchedObjects.empty())
+		return;
+
+	// Material block
+	auto* pMaterialBlock = static_cast<MaterialUniformData*>(pUniformArena->Allocate(m_ListFrameMaterials.size() * sizeof(MaterialUniformData), &m_uiMaterialUniformOffset));
+	if (!pMaterialBlock)
+	{
+		LOG_ERROR("Failed to pack material uniform data!");
+		m_ListDrawBatches.clear();
+		return;
+	}
+
+	for (uint32_t i = 0; i < m_ListFrameMaterials.size(); ++i)
+	{
+		pMaterialBlock[i] = *m_ListFrameMaterials[i];
+	}
+
+	// Draw table & bounds go before instance data, they're tiny & without them nothing can be drawn at all
+	auto* pDrawCommands = static_cast<vk::DrawIndexedIndirectCommand*>(pUniformArena->AllocateData(m_ListDrawBatches.size() * sizeof(vk::DrawIndexedIndirectCommand), &m_uiDrawCommandOffset));
+	auto* pDrawBounds = static_cast<glm::vec4*>(pUniformArena->AllocateData(m_ListDrawBatches.size() * sizeof(glm::vec4), &m_uiDrawBoundsOffset));
+	if (!pDrawCommands || !pDrawBounds)
+	{
+		LOG_ERROR("Failed to pack indirect draw commands!");
+		m_ListDrawBatches.clear();
+		return;
 	}
+
+	// Whatever doesn't fit in the arena is dropped from the end. Objects got their slots in order, so every batch only
+	// loses its last few & slots of the rest stay tightly packed
+	const uint64_t maxInstances = pUniformArena->GetFreeDataSize() / sizeof(InstanceData);
+	if (m_ListBatchedObjects.size() > maxInstances)
+	{
+		LOG_ERROR("Uniform arena is full, {0} instances skipped!", m_ListBatchedObjects.size() - maxInstances);
+
+		m_ListBatchedObjects.resize(static_cast<size_t>(maxInstances));
+
+		for (DrawBatch& batch : m_ListDrawBatches)
+		{
+			batch.instanceCount = 0;
+		}
+
+		for (const BatchedObject& object : m_ListBatchedObjects)
+		{
+			++m_ListDrawBatches[object.batchIndex].instanceCount;
+		}
+	}
+
+	// Instance data (object table), batches one after another
+	InstanceData* pInstanceData = nullptr;
+	if (!m_ListBatchedObjects.empty())
+	{
+		pInstanceData = static_cast<InstanceData*>(pUniformArena->AllocateData(m_ListBatchedObjects.size() * sizeof(InstanceData), &m_uiInstanceDataOffset));
+		UT_ASSERT_BOOL((pInstanceData != nullptr), "Instance data doesn't fit in what uniform arena said was free!");
+	}
+
+	uint32_t firstInstance = 0;
+	for (DrawBatch& batch : m_ListDrawBatches)
+	{
+		batch.firstInstance = firstInstance;
+		firstInstance += batch.instanceCount;
+	}
+
+	// Every object already knows its slot, so they pack in parallel straight into the arena
+	constexpr uint32_t minInstancesPerJob = 256;
+
+	JobSystem::getInstance().ParallelFor(static_cast<uint32_t>(m_ListBatchedObjects.size()), minInstancesPerJob, [this, pInstanceData](uint32_t first, uint32_t last)
+	{
+		for (uint32_t i = first; i < last; ++i)
+		{
+			const BatchedObject& object = m_ListBatchedObjects[i];
+			InstanceData* pInstance = &pInstanceData[m_ListDrawBatches[object.batchIndex].firstInstance + object.slotInBatch];
+			*pInstance = object.pObject->instanceData;
+			pInstance->materialIndex = object.materialIndex;
+			pInstance->drawIndex = object.batchIndex;
+		}
+	});
+
+	// Draw table, a command per batch. Meshes are ranges in device's mesh pool, so commands only differ in offsets! Counts
+	// start at zero, culling pass adds every instance which survives. Batch keeps its whole range, so survivors of a
+	// batch never spill into the next one
+	for (uint32_t i = 0; i < m_ListDrawBatches.size(); ++i)
+	{
+		const DrawBatch& batch = m_ListDrawBatches[i];
+		const MeshPoolAllocation& meshRange = batch.pMesh->m_PoolAllocation;
+
+		pDrawCommands[i].indexCount = meshRange.indexCount;
+		pDrawCommands[i].instanceCount = 0;
+		pDrawCommands[i].firstIndex = meshRange.firstIndex;
+		pDrawCommands[i].vertexOffset = static_cast<int32_t>(meshRange.firstVertex);
+		pDrawCommands[i].firstInstance = batch.firstInstance;
+	}
+
+	// Bounding sphere of every batch's mesh, culling pass moves it to each instance
+	for (uint32_t i = 0; i < m_ListDrawBatches.size(); ++i)
+	{
+		pDrawBounds[i] = m_ListDrawBatches[i].pMesh->m_vecBoundingSphere;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Scene::GetCullingInput(CullingPassInput* pOutInput) const
+{
+	*pOutInput = CullingPassInput();
+	pOutInput->matViewProjection = m_matViewProjection;
+
+	// Nothing made it into the arena, nothing to cull
+	if (m_ListDrawBatches.empty())
+		return;
+
+	pOutInput->instanceDataOffset = m_uiInstanceDataOffset;
+	pOutInput->instanceCount = static_cast<uint32_t>(m_ListBatchedObjects.size());
+	pOutInput->drawCommandOffset = m_uiDrawCommandOffset;
+	pOutInput->drawBoundsOffset = m_uiDrawBoundsOffset;
+	pOutInput->drawCount = static_cast<uint32_t>(m_ListDrawBatches.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void Scene::RecordDraws(const VulkanDevice* pDevice, const VulkanCullingPass* pCullingPass, uint32_t frameIndex, vk::CommandBuffer cmdBuffer) const
+{
+	if (m_ListDrawBatches.empty())
+		return;
+
+	const VulkanUniformArena* pUniformArena = pDevice->GetUniformArena();
+
+	// View, materials & bindless textures are bound once for the whole frame. Only the two arena bindings are dynamic,
+	// texture table takes no offset!
+	const vk::DescriptorSet arenaSet = pUniformArena->GetDescriptorSet(frameIndex);
+	const vk::DescriptorSet textureSet = pDevice->GetBindlessTextures()->GetDescriptorSet();
+	const std::array<vk::DescriptorSet, 3> descriptorSets = { arenaSet, arenaSet, textureSet };
+	const std::array<uint32_t, 2> dynamicOffsets = { m_uiViewUniformOffset, m_uiMaterialUniformOffset };
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, ForwardPassLayouts::GetPipelineLayout(pDevice), 0, descriptorSets, dynamicOffsets);
+
+	// Every mesh lives in mesh pool's buffers & visible instances in culling pass' buffer, so all of it is bound once...
+	const VulkanMeshPool* pMeshPool = pDevice->GetMeshPool();
+
+	const std::array<vk::Buffer, 2> vertexBuffers = { pMeshPool->GetVertexBuffer(), pCullingPass->GetInstanceBuffer(frameIndex) };
+	const std::array<vk::DeviceSize, 2> offsets = { 0, 0 };
+
+	cmdBuffer.bindVertexBuffers(0, static_cast<uint32_t>(vertexBuffers.size()), vertexBuffers.data(), offsets.data());
+	cmdBuffer.bindIndexBuffer(pMeshPool->GetIndexBuffer(), 0, vk::IndexType::eUint32);
+
+	// ...& whole scene is one indirect draw. Counts were written by culling pass, fully culled batches draw nothing!
+	cmdBuffer.drawIndexedIndirect(pCullingPass->GetDrawCommandBuffer(frameIndex), 0, static_cast<uint32_t>(m_ListDrawBatches.size()), sizeof(vk::DrawIndexedIndirectCommand));
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -154,5 +478,11 @@ bool Scene::LoadModels(const VulkanDevice* pDevice)
 
 	m_ListModels.push_back(pBottomWall);
 
+	// Hand everything over to worker threads, Initialize() above only created layouts!
+	for (GameObject* object : m_ListModels)
+	{
+		m_pAssetLoader->QueueLoad(object);
+	}
+
 	return true;
 }
@@ -1,23 +1,38 @@
 #pragma once
 
 #include "../Core/Core.h"
+#include "glm/glm.hpp"
+#include "vulkan/vulkan.hpp"
+#include "../Core/JobSystem.h"
 
 class VulkanDevice;
 class GameObject;
 class Camera;
+class AssetLoader;
+class VulkanMesh;
+class VulkanCube;
+class VulkanCullingPass;
+struct MaterialUniformData;
+struct CullingPassInput;
+struct RenderSnapshot;
+struct SnapshotObject;
 
 class UT_API Scene
 {
 public:
-	Scene() = default;
+	Scene();
 	~Scene() = default;
 
 	bool								LoadScene(const VulkanDevice* pDevice);
 	void								Cleanup(VulkanDevice* pDevice);
 
+	void								UpdateLoading();
 	void								Update(double dt) const;
-	void								UpdateUniforms(const VulkanDevice* pDevice, uint32_t imageIndex) const;
-	void								Render(const VulkanDevice* pDevice, uint32_t imageIndex) const;
+	void								BeginSimulation(double dt);
+	void								EndSimulation();
+	void								UpdateUniforms(const VulkanDevice* pDevice) const;
+	void								GetCullingInput(CullingPassInput* pOutInput) const;
+	void								RecordDraws(const VulkanDevice* pDevice, const VulkanCullingPass* pCullingPass, uint32_t frameIndex, vk::CommandBuffer cmdBuffer) const;
 
 public:
 	inline GameObject* GetFirstObject() const { return m_ListModels[0]; }
@@ -25,10 +40,52 @@ public:
 
 private:
 	bool								LoadModels(const VulkanDevice* pDevice);
+	void								BuildSnapshot(RenderSnapshot* pOutSnapshot) const;
+
+	// Objects sharing a mesh, their instances are contiguous in this frame's instance data. Becomes one command in
+	// frame's indirect draw table, culling pass compacts survivors to the front of the batch's range
+	struct DrawBatch
+	{
+		const VulkanMesh*				pMesh;
+		uint32_t						firstInstance;
+		uint32_t						instanceCount;
+	};
+
+	struct BatchedObject
+	{
+		const SnapshotObject*			pObject;
+		uint32_t						batchIndex;
+		uint32_t						materialIndex;
+		uint32_t						slotInBatch;		// instance's place in batch's range, so packing needs no ordering
+	};
 
 public:
 	std::vector <GameObject*>			m_ListModels;
 	Camera*								m_pCamera;
+	AssetLoader*						m_pAssetLoader;
+	const VulkanDevice*					m_pDevice;
+	mutable uint32_t					m_uiViewUniformOffset;			// this frame's view block in uniform arena
+	mutable uint32_t					m_uiMaterialUniformOffset;		// this frame's material block in uniform arena
+	mutable uint32_t					m_uiInstanceDataOffset;			// this frame's instance data in uniform arena
+	mutable uint32_t					m_uiDrawCommandOffset;			// this frame's draw table in uniform arena, zero instance counts
+	mutable uint32_t					m_uiDrawBoundsOffset;			// this frame's mesh bounding spheres in uniform arena, one per draw
+	mutable glm::mat4					m_matViewProjection;			// this frame's, culling pass builds frustum out of it
+
+	// Simulation of frame N + 1 runs on a worker while renderer packs & records frame N out of the other snapshot.
+	// Live objects & camera are only touched by main thread in between (input, asset finalize, UI)!
+	RenderSnapshot*						m_pSnapshots[2];
+	uint32_t							m_uiSimulationSnapshot;			// being filled by simulation, renderer reads the other one
+	bool								m_bSimulating;
+	JobCounter							m_SimulationJobs;
+
+	// Readiness is checked once per simulation step by Update(), snapshot takes exactly the objects it updated. Bytes,
+	// not bools, every object's flag is written from whichever thread updates it!
+	mutable std::vector<uint8_t>		m_ListUpdatedModels;
+
+	// Rebuilt by UpdateUniforms() every frame, kept around only so their memory is reused
+	mutable std::vector<DrawBatch>						m_ListDrawBatches;
+	mutable std::vector<BatchedObject>					m_ListBatchedObjects;
+	mutable std::vector<const MaterialUniformData*>		m_ListFrameMaterials;
 
 };
 
@@ -1,9 +1,12 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 //---------------------------------------------------------------------------------------------------------------------
 //-- Input from Vertex shader
 layout(location = 0) in vec2 vs_outUV;
 layout(location = 1) in vec3 vs_outNormal;
+layout(location = 2) in flat vec4 vs_outAlbedoColor;
+layout(location = 3) in flat uint vs_outMaterialIndex;
 
 //---------------------------------------------------------------------------------------------------------------------
 // -- Final Output color
@@ -11,37 +14,38 @@ layout(location = 0) out vec4 outColor;
 
 //---------------------------------------------------------------------------------------------------------------------
 //-- Uniforms
-layout(set = 0, binding = 0) uniform mvpData
+//-- Per object material, whole frame's worth in one block. Set 0 (view data) isn't used here
+struct MaterialData
 {
-    mat4 World;
-    mat4 View;
-    mat4 Projection;
-
-    vec4 albedoColor;
     vec4 emissionColor;
-    vec4 hasTextureAEN;
-    vec4 hasTextureRMO;
+    ivec4 textureIndexAEN;      // slots in bindless table, -1 if material has no such texture
+    ivec4 textureIndexRMO;
     float occlusion;
     float roughness;
     float metalness;
+};
+
+layout(set = 1, binding = 0) uniform MaterialBlock
+{
+    MaterialData materials[256];
 
-}shaderData;
+}materialBlock;
 
-//-- Textures
-layout(set = 0, binding = 1) uniform sampler2D samplerAlbedoTexture;
+//-- Every loaded texture, materials index into it. Bound once per frame
+layout(set = 2, binding = 0) uniform sampler2D textures[];
 
 //---------------------------------------------------------------------------------------------------------------------
 void main()
 {
     vec4 albedoColor = vec4(1.0f);
 
-    //--- Albedo Color
-    //if(shaderData.hasTextureAEN.r == 1)
-    //{
-    //    albedoColor = texture(samplerAlbedoTexture, vs_outUV);    
-    //}
-    
-    albedoColor = texture(samplerAlbedoTexture, vs_outUV); 
-    outColor = vec4(shaderData.albedoColor * albedoColor);
+    //--- Albedo Color, instances of one draw can use different textures
+    int albedoIndex = materialBlock.materials[vs_outMaterialIndex].textureIndexAEN.r;
+    if(albedoIndex >= 0)
+    {
+        albedoColor = texture(textures[nonuniformEXT(albedoIndex)], vs_outUV);
+    }
+
+    outColor = vec4(vs_outAlbedoColor * albedoColor);
     //outColor = vec4(vs_outNormal, 1.0f);
 }
\ No newline at end of file
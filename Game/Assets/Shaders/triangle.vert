@@ -8,33 +8,36 @@ layout(location = 2) in vec3 in_Tangent;
 layout(location = 3) in vec3 in_BiNormal;
 layout(location = 4) in vec2 in_UV;
 
+//-- Per instance, must match InstanceData. World matrix takes locations 5 to 8
+layout(location = 5) in mat4 in_World;
+layout(location = 9) in vec4 in_AlbedoColor;
+layout(location = 10) in uint in_MaterialIndex;
+
 //---------------------------------------------------------------------------------------------------------------------
 //-- Output to Fragment shader
 layout(location = 0) out vec2 vs_outUV;
 layout(location = 1) out vec3 vs_outNormal;
+layout(location = 2) out flat vec4 vs_outAlbedoColor;
+layout(location = 3) out flat uint vs_outMaterialIndex;
 
 //---------------------------------------------------------------------------------------------------------------------
 //-- Uniforms
-layout(set = 0, binding = 0) uniform mvpData
+//-- Per view, bound once per frame
+layout(set = 0, binding = 0) uniform ViewData
 {
-    mat4 World;
     mat4 View;
     mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CameraPosition;
 
-    vec4 albedoColor;
-    vec4 emissionColor;
-    vec4 hasTextureAEN;
-    vec4 hasTextureRMO;
-    float occlusion;
-    float roughness;
-    float metalness;
-
-}shaderData;
+}viewData;
 
 //---------------------------------------------------------------------------------------------------------------------
 void main()
 {
-    gl_Position = shaderData.Projection * shaderData.View * shaderData.World * vec4(in_Pos, 1.0f);
+    gl_Position = viewData.ViewProjection * (in_World * vec4(in_Pos, 1.0f));
     vs_outUV = in_UV;
     vs_outNormal = in_Normal;
+    vs_outAlbedoColor = in_AlbedoColor;
+    vs_outMaterialIndex = in_MaterialIndex;
 }
\ No newline at end of file